@@ -0,0 +1,50 @@
+#
+# Copyright (c) 2017 Leon Mlakar.
+# Copyright (c) 2017 Digiverse d.o.o.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License. The
+# license should be included in the source distribution of the Software;
+# if not, you may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# The above copyright notice and licensing terms shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+# IN THE SOFTWARE.
+
+# benchmarks of library internals, use static library
+set( LIBRARY_BENCHMARKS
+  run-queue-contention
+  runner-footprint
+)
+
+### Benchmark files
+
+set( run-queue-contention_SRCS    tests/benchmark/run_queue/contention.cpp )
+set( runner-footprint_SRCS        tests/benchmark/runner/footprint.cpp )
+
+### Helper macros
+
+macro(internal_benchmark BenchName)
+  add_executable( ${BenchName}-bench ${ARGN} )
+
+  target_link_libraries( ${BenchName}-bench cool.ng.archive ${COOL_NG_PLATFORM_LIBRARIES} )
+  target_include_directories( ${BenchName}-bench PRIVATE ${COOL_NG_HOME}/lib/include )
+  target_compile_definitions( ${BenchName}-bench PRIVATE COOL_NG_STATIC_LIBRARY )
+  set_target_properties( ${BenchName}-bench PROPERTIES
+    RUNTIME_OUTPUT_DIRECTORY ${COOL_NG_BIN_DIR}
+    FOLDER "Benchmarks/Internal"
+  )
+endmacro()
+
+foreach( bm ${LIBRARY_BENCHMARKS} )
+  internal_benchmark( ${bm} ${${bm}_SRCS} )
+endforeach()
@@ -137,6 +137,7 @@ source_group("IP Address\\Impl" FILES ${MODULE_OTHER_API_HEADERS} )
 set( MODULE_DOCUMENTED_API_HEADERS
   include/cool/ng/async/task.h
   include/cool/ng/async/runner.h
+  include/cool/ng/async/runner_pool.h
   include/cool/ng/async/event_sources.h
   include/cool/ng/async/net/server.h
   include/cool/ng/async/net/stream.h
@@ -159,6 +160,7 @@ set( MODULE_OTHER_API_HEADERS
 )
 set( MODULE_COMMON_SRCS
   ${COOL_NG_HOME}/lib/src/async/runner.cpp
+  ${COOL_NG_HOME}/lib/src/async/runner_pool.cpp
 )
 set( MODULE_DOC_FILES
   doc/api/module-async.dox
@@ -180,12 +182,16 @@ source_group("Async\\Impl" FILES ${MODULE_OTHER_API_HEADERS} )
 set( COOL_NG_GCD_RUN_QUEUE_DIR   ${COOL_NG_HOME}/lib/src/async/run_queue/gcd )
 set( COOL_NG_DEQUE_RUN_QUEUE_DIR ${COOL_NG_HOME}/lib/src/async/run_queue/deque )
 set( COOL_NG_WINCP_RUN_QUEUE_DIR ${COOL_NG_HOME}/lib/src/async/run_queue/wincp )
+set( COOL_NG_POSIX_POOL_DIR      ${COOL_NG_HOME}/lib/src/async/run_queue/posix )
 
 if ( COOL_TASK_RUNNER_IMPL STREQUAL "GCD_TARGET_QUEUE" )
   report("-- Task runner will use GCD scheduler with the target queue")
   set ( COOL_NG_RUN_QUEUE_DIR ${COOL_NG_GCD_RUN_QUEUE_DIR} )
 elseif ( COOL_TASK_RUNNER_IMPL STREQUAL "GCD_DEQUE" )
-  report("-- Task runner will use GCD scheduler with std::deque task queue")
+  report("-- Task runner will use GCD scheduler with lock-free task queue")
+  set ( COOL_NG_RUN_QUEUE_DIR ${COOL_NG_DEQUE_RUN_QUEUE_DIR} )
+elseif ( COOL_TASK_RUNNER_IMPL STREQUAL "POSIX_POOL" )
+  report("-- Task runner will use POSIX thread pool with lock-free task queue")
   set ( COOL_NG_RUN_QUEUE_DIR ${COOL_NG_DEQUE_RUN_QUEUE_DIR} )
 elseif  ( COOL_TASK_RUNNER_IMPL STREQUAL "WIN_COMPLETION_PORT" )
   report("-- Task runner will use Windows Completion Ports with the thread pool")
@@ -199,6 +205,24 @@ set( COOL_NG_RUN_QUEUE_HEADERS ${COOL_NG_RUN_QUEUE_DIR}/run_queue.h )
 if ( TASK_RUNNER_IMPL STREQUAL "WIN_COMPLETION_PORT" )
   set( COOL_NG_RUN_QUEUE_HEADERS ${COOL_NG_RUN_QUEUE_HEADERS} ${COOL_NG_RUN_QUEUE_DIR}/critical_section.h )
 endif()
+if ( COOL_TASK_RUNNER_IMPL STREQUAL "GCD_DEQUE" OR COOL_TASK_RUNNER_IMPL STREQUAL "POSIX_POOL" )
+  set( COOL_NG_RUN_QUEUE_HEADERS ${COOL_NG_RUN_QUEUE_HEADERS}
+    ${COOL_NG_HOME}/lib/include/lib/async/mpsc_queue.h
+    ${COOL_NG_HOME}/lib/include/lib/async/object_pool.h
+    ${COOL_NG_HOME}/lib/include/lib/async/queue_metrics.h
+    ${COOL_NG_HOME}/lib/include/lib/async/queue_bound.h
+    ${COOL_NG_HOME}/lib/include/lib/async/queue_codel.h
+    ${COOL_NG_HOME}/lib/include/lib/async/token_bucket.h
+    ${COOL_NG_POSIX_POOL_DIR}/thread_pool.h
+    ${COOL_NG_POSIX_POOL_DIR}/timer_service.h
+  )
+  # thread_pool provides the dedicated threads and timer_service the timed
+  # waits with both implementations
+  set( COOL_NG_RUN_QUEUE_SRCS ${COOL_NG_RUN_QUEUE_SRCS}
+    ${COOL_NG_POSIX_POOL_DIR}/thread_pool.cpp
+    ${COOL_NG_POSIX_POOL_DIR}/timer_service.cpp
+  )
+endif()
 
 add_build_files( ${COOL_NG_RUN_QUEUE_HEADERS} ${COOL_NG_RUN_QUEUE_SRCS} )
 add_all_files(
@@ -209,10 +233,23 @@ add_all_files(
   ${COOL_NG_GCD_RUN_QUEUE_DIR}/run_queue.cpp
   ${COOL_NG_DEQUE_RUN_QUEUE_DIR}/run_queue.cpp
   ${COOL_NG_WINCP_RUN_QUEUE_DIR}/run_queue.cpp
+  ${COOL_NG_HOME}/lib/include/lib/async/mpsc_queue.h
+  ${COOL_NG_HOME}/lib/include/lib/async/object_pool.h
+  ${COOL_NG_HOME}/lib/include/lib/async/queue_metrics.h
+  ${COOL_NG_HOME}/lib/include/lib/async/queue_bound.h
+  ${COOL_NG_HOME}/lib/include/lib/async/queue_codel.h
+  ${COOL_NG_HOME}/lib/include/lib/async/token_bucket.h
+  ${COOL_NG_POSIX_POOL_DIR}/thread_pool.h
+  ${COOL_NG_POSIX_POOL_DIR}/thread_pool.cpp
+  ${COOL_NG_POSIX_POOL_DIR}/timer_service.h
+  ${COOL_NG_POSIX_POOL_DIR}/timer_service.cpp
 )
 
 # set the correct include path for runner implementation headers
 include_directories( ${COOL_NG_RUN_QUEUE_DIR} )
+if ( COOL_TASK_RUNNER_IMPL STREQUAL "GCD_DEQUE" OR COOL_TASK_RUNNER_IMPL STREQUAL "POSIX_POOL" )
+  include_directories( ${COOL_NG_POSIX_POOL_DIR} )
+endif()
 
 # --- event sources have two implementations, one for GCD based run queue and the other for the Windows Thread Pool based run queue
 
@@ -238,7 +275,8 @@ add_all_files(
 ) 
 
 source_group("Async\\Run Queue\\Gcd" FILES ${COOL_NG_GCD_RUN_QUEUE_DIR}/run_queue.h ${COOL_NG_GCD_RUN_QUEUE_DIR}/run_queue.cpp )
-source_group("Async\\Run Queue\\Deque" FILES ${COOL_NG_DEQUE_RUN_QUEUE_DIR}/run_queue.h ${COOL_NG_DEQUE_RUN_QUEUE_DIR}/run_queue.cpp )
+source_group("Async\\Run Queue\\Deque" FILES ${COOL_NG_DEQUE_RUN_QUEUE_DIR}/run_queue.h ${COOL_NG_DEQUE_RUN_QUEUE_DIR}/run_queue.cpp ${COOL_NG_HOME}/lib/include/lib/async/mpsc_queue.h ${COOL_NG_HOME}/lib/include/lib/async/object_pool.h ${COOL_NG_HOME}/lib/include/lib/async/queue_metrics.h ${COOL_NG_HOME}/lib/include/lib/async/queue_bound.h ${COOL_NG_HOME}/lib/include/lib/async/queue_codel.h ${COOL_NG_HOME}/lib/include/lib/async/token_bucket.h )
+source_group("Async\\Run Queue\\Posix" FILES ${COOL_NG_POSIX_POOL_DIR}/thread_pool.h ${COOL_NG_POSIX_POOL_DIR}/thread_pool.cpp ${COOL_NG_POSIX_POOL_DIR}/timer_service.h ${COOL_NG_POSIX_POOL_DIR}/timer_service.cpp )
 source_group("Async\\Run Queue\\Wincp" FILES ${COOL_NG_WINCP_RUN_QUEUE_DIR}/run_queue.h ${COOL_NG_WINCP_RUN_QUEUE_DIR}/critical_section.h ${COOL_NG_WINCP_RUN_QUEUE_DIR}/run_queue.cpp )
 source_group("Async\\Event Sources\\Gcd" FILES ${COOL_NG_GCD_EVENT_SOURCES_HEADERS} ${COOL_NG_GCD_EVENT_SOURCES_SRCS} )
 source_group("Async\\Event Sources\\Wincp" FILES ${COOL_NG_WINCP_EVENT_SOURCES_HEADERS} ${COOL_NG_WINCP_EVENT_SOURCES_SRCS} )
@@ -53,8 +53,8 @@ target_include_directories( ${COOL_NG_TARGET_STATIC}  BEFORE PRIVATE ${COOL_NG_H
 target_include_directories( ${COOL_NG_TARGET_STATIC}  PUBLIC  ${COOL_NG_COMPONENT_INCLUDE_DIRECTORIES} )
 target_include_directories( ${COOL_NG_TARGET_DYNAMIC} BEFORE PRIVATE ${COOL_NG_HOME}/lib ${COOL_NG_HOME}/lib/include )
 target_include_directories( ${COOL_NG_TARGET_DYNAMIC} PUBLIC  ${COOL_NG_COMPONENT_INCLUDE_DIRECTORIES} )
-target_compile_definitions( ${COOL_NG_TARGET_STATIC}  PRIVATE COOL_NG_BUILD ${COOL_ASYNC_PLATFORM} ${TASK_RUNNER_IMPL} )
-target_compile_definitions( ${COOL_NG_TARGET_DYNAMIC} PRIVATE COOL_NG_BUILD ${COOL_ASYNC_PLATFORM} ${TASK_RUNNER_IMPL} )
+target_compile_definitions( ${COOL_NG_TARGET_STATIC}  PRIVATE COOL_NG_BUILD ${COOL_ASYNC_PLATFORM} ${COOL_TASK_RUNNER_IMPL} COOL_NG_POOL_THREADS=${COOL_NG_POOL_THREADS} )
+target_compile_definitions( ${COOL_NG_TARGET_DYNAMIC} PRIVATE COOL_NG_BUILD ${COOL_ASYNC_PLATFORM} ${COOL_TASK_RUNNER_IMPL} COOL_NG_POOL_THREADS=${COOL_NG_POOL_THREADS} )
 target_compile_definitions( ${COOL_NG_TARGET_DYNAMIC} PUBLIC  PLATFORM_TARGET=${COOL_PLATFORM_TARGET} ${COOL_PLATFORM_TARGET} )
 target_compile_definitions( ${COOL_NG_TARGET_STATIC}  PUBLIC COOL_NG_STATIC_LIBRARY PLATFORM_TARGET=${COOL_PLATFORM_TARGET} ${COOL_PLATFORM_TARGET} )
 
@@ -16,13 +16,16 @@
 #    - LINUX set to true
 #    - COOL_PLATFORM_TARGET --> LINUX
 #    - COOL_ASYNC_PLATFORM --> COOL_ASYNC_PLATFORM_GCD
-#    - COOL_TASK_RUNNER_IMPL -->  GCD_DEQUE
+#    - COOL_TASK_RUNNER_IMPL -->  GCD_DEQUE if libdispatch is found, POSIX_POOL otherwise
 #
 # On FreeBSD:
 #    - FREEBSD set to true
 #    - COOL_PLATFORM_TARGET --> FREEBSD
 #    - COOL_ASYNC_PLATFORM --> COOL_ASYNC_PLATFORM_GCD
-#    - COOL_TASK_RUNNER_IMPL -->  GCD_DEQUE
+#    - COOL_TASK_RUNNER_IMPL -->  GCD_DEQUE if libdispatch is found, POSIX_POOL otherwise
+#
+# On Linux and FreeBSD the task runner implementation can be selected explicitly
+# with -DCOOL_TASK_RUNNER_IMPL=GCD_DEQUE or -DCOOL_TASK_RUNNER_IMPL=POSIX_POOL.
 #
 # It also sets COOL_NG_COMPILER_OPTIONS and COOL_NG_PLATFORM_LIBRARIES correctly for platform
 # It may set COOL_NG_ADDITIONAL_SYS_INCLUDES and COOL_NG_ADDITIONAL_SYS_LIBDIRS if necessary
@@ -42,7 +45,24 @@ macro(report Level)
     endif()
   endif()
 endmacro()
-	
+
+# --- On the platforms without the native libdispatch the deque run_queue
+#     uses either libdispatch's global queue, if installed, or the library's
+#     own POSIX thread pool
+macro(select_deque_runner_impl)
+  if ( NOT DEFINED COOL_TASK_RUNNER_IMPL OR COOL_TASK_RUNNER_IMPL STREQUAL "" )
+    find_path( COOL_NG_DISPATCH_INCLUDE_DIR dispatch/dispatch.h PATHS ${ARGN} )
+    if ( COOL_NG_DISPATCH_INCLUDE_DIR )
+      set( COOL_TASK_RUNNER_IMPL GCD_DEQUE )
+    else()
+      report( "-- libdispatch not found, task runner will use POSIX thread pool" )
+      set( COOL_TASK_RUNNER_IMPL POSIX_POOL )
+    endif()
+  elseif ( NOT COOL_TASK_RUNNER_IMPL STREQUAL "GCD_DEQUE" AND NOT COOL_TASK_RUNNER_IMPL STREQUAL "POSIX_POOL" )
+    report( FATAL "Task runner implementation '${COOL_TASK_RUNNER_IMPL}' is not supported on ${CMAKE_SYSTEM_NAME}" )
+  endif()
+endmacro()
+
 if ( ${CMAKE_GENERATOR} MATCHES "Unix Makefiles" )
 
   if( NOT DEFINED CMAKE_BUILD_TYPE OR CMAKE_BUILD_TYPE STREQUAL "" )
@@ -81,10 +101,14 @@ elseif( ${CMAKE_SYSTEM_NAME} MATCHES "Linux" )
   set( LINUX true )
   set( COOL_PLATFORM_TARGET LINUX_TARGET )
   set( COOL_ASYNC_PLATFORM COOL_ASYNC_PLATFORM_GCD )
-  set( COOL_TASK_RUNNER_IMPL GCD_DEQUE )
-  
+  select_deque_runner_impl()
+
   # platform libraries to link
-  set( COOL_NG_PLATFORM_LIBRARIES pthread dispatch )
+  if ( COOL_TASK_RUNNER_IMPL STREQUAL "POSIX_POOL" )
+    set( COOL_NG_PLATFORM_LIBRARIES pthread )
+  else()
+    set( COOL_NG_PLATFORM_LIBRARIES pthread dispatch )
+  endif()
   set( COOL_NG_COMPILER_OPTIONS -g -std=c++11 -fPIC)
 
 elseif( ${CMAKE_SYSTEM_NAME} MATCHES "FreeBSD" )
@@ -92,10 +116,14 @@ elseif( ${CMAKE_SYSTEM_NAME} MATCHES "FreeBSD" )
   set( FREEBSD true )
   set( COOL_PLATFORM_TARGET FREEBSD_TARGET )
   set( COOL_ASYNC_PLATFORM COOL_ASYNC_PLATFORM_GCD )
-  set( COOL_TASK_RUNNER_IMPL GCD_DEQUE )
-  
+  select_deque_runner_impl( /usr/local/include )
+
   # platform libraries to link
-  set( COOL_NG_PLATFORM_LIBRARIES execinfo pthread dispatch )
+  if ( COOL_TASK_RUNNER_IMPL STREQUAL "POSIX_POOL" )
+    set( COOL_NG_PLATFORM_LIBRARIES execinfo pthread )
+  else()
+    set( COOL_NG_PLATFORM_LIBRARIES execinfo pthread dispatch )
+  endif()
   set( COOL_NG_COMPILER_OPTIONS -g -std=c++11 -fPIC -fbracket-depth=10000 )
   set( COOL_NG_ADDITIONAL_SYS_INCLUDES /usr/local/include )
   set( COOL_NG_ADDITIONAL_SYS_LIBDIRS /usr/local/lib )
@@ -11,6 +11,7 @@ set( LIBRARY_UNIT_TESTS
 #  executor
   run-queue
   task-context
+  task-executor
 )
 
 # api level unit tests, will use both static and dynamic library
@@ -33,6 +34,7 @@ set( task-traits_SRCS       ${TEST_HEADER} tests/unit/traits/task_traits.cpp )
 set( executor_SRCS          tests/unit/executor/executor.cpp )
 set( run-queue_SRCS         tests/unit/run_queue/run_queue.cpp )
 set( task-context_SRCS        tests/unit/task/task-context.cpp )
+set( task-executor_SRCS       tests/unit/task/task_executor.cpp )
 
 # API level tests
 set( utilities_SRCS ${TEST_HEADER} tests/unit/utilities/binary.cpp  tests/unit/utilities/identification.cpp)
@@ -74,8 +76,8 @@ macro(internal_unit_test TestName)
 #  target_link_directories( ${TestName}-test PRIVATE ${Boost_LIBRARY_DIRS} )
   target_link_libraries( ${TestName}-test cool.ng.archive ${Boost_LIBRARIES} ${COOL_NG_PLATFORM_LIBRARIES} )
   target_include_directories( ${TestName}-test SYSTEM PRIVATE ${Boost_INCLUDE_DIR} )
-  target_include_directories( ${TestName}-test PRIVATE ${COOL_NG_HOME}/tests/unit )
-  target_compile_definitions( ${TestName}-test PRIVATE BOOST_TEST_DYN_LINK COOL_NG_STATIC_LIBRARY )
+  target_include_directories( ${TestName}-test PRIVATE ${COOL_NG_HOME}/tests/unit ${COOL_NG_HOME}/lib/include )
+  target_compile_definitions( ${TestName}-test PRIVATE BOOST_TEST_DYN_LINK COOL_NG_STATIC_LIBRARY ${COOL_ASYNC_PLATFORM} ${COOL_TASK_RUNNER_IMPL} )
    set_target_properties( ${TestName}-test PROPERTIES
      RUNTIME_OUTPUT_DIRECTORY ${COOL_NG_TEST_DIR}
      LINK_DIRECTORIES  ${Boost_LIBRARY_DIRS}
@@ -27,6 +27,7 @@
 #include "impl/platform.h"
 
 #include "async/runner.h"
+#include "async/runner_pool.h"
 #include "async/task.h"
 //#include "async/event_sources.h"
 
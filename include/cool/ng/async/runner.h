@@ -26,6 +26,11 @@
 
 #include <memory>
 #include <string>
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <vector>
+#include <functional>
 
 #include "cool/ng/impl/platform.h"
 #include "cool/ng/exception.h"
@@ -34,6 +39,96 @@ namespace cool { namespace ng { namespace async {
 
 namespace impl { class run_queue; }
 
+/**
+ * Task scheduling policy of the @ref runner.
+ */
+enum class RunPolicy {
+  /** Tasks are executed one after another, in the order of submission. */
+  SEQUENTIAL,
+  /**
+   * Tasks may be executed concurrently, on several worker threads, and in
+   * no particular order.
+   */
+  CONCURRENT
+};
+
+/**
+ * Priority class of the @ref runner.
+ *
+ * The runners of different priority classes do not share the worker threads.
+ * The tasks of the runner with the higher priority thus never wait for the
+ * worker threads busy with the tasks of the lower priority runners, and the
+ * worker threads of the lower priority classes yield the CPU to the worker
+ * threads of the higher priority classes when supported by the platform.
+ */
+enum class Priority {
+  /** For the latency critical tasks, such as the control traffic. */
+  HIGH,
+  /** The default priority class. */
+  DEFAULT,
+  /** For the tasks that can wait, such as the bulk data processing. */
+  LOW,
+  /** For the tasks that should only run when the system is otherwise idle. */
+  BACKGROUND
+};
+
+/**
+ * Urgency of the task within its @ref runner.
+ *
+ * The sequential runner keeps a separate lane for each urgency and executes
+ * the more urgent tasks ahead of the less urgent tasks submitted earlier, as
+ * set by the runner's @ref LanePolicy "lane policy". The tasks of the same
+ * urgency are executed in the order of submission and the runner still
+ * executes one task at a time. The urgency is set when the task is submitted
+ * with @ref task::run() "run()" and applies to all runners the task visits.
+ * The urgency does not affect the order in which the worker threads serve
+ * different runners; use the @ref Priority "priority class" for that.
+ */
+enum class Urgency {
+  /** For the tasks that must not wait behind other tasks, such as the control messages. */
+  CRITICAL,
+  /** For the tasks that should run ahead of the regular tasks. */
+  HIGH,
+  /** The default urgency. */
+  NORMAL,
+  /** For the tasks that can wait, such as the housekeeping. */
+  LOW
+};
+
+/**
+ * The order in which the @ref runner executes the tasks of different
+ * @ref Urgency "urgency".
+ */
+enum class LanePolicy {
+  /**
+   * The runner always executes the most urgent task waiting. The less urgent
+   * tasks only run when no more urgent task is waiting.
+   */
+  STRICT,
+  /**
+   * The runner serves the lanes in rounds. Each round executes up to 8
+   * Urgency::CRITICAL, 4 Urgency::HIGH, 2 Urgency::NORMAL and 1 Urgency::LOW
+   * task. The less urgent tasks thus progress even under the steady load of
+   * the more urgent tasks.
+   */
+  WEIGHTED
+};
+
+/**
+ * Behavior of the bounded @ref runner when its task queue is full.
+ */
+enum class OverflowPolicy {
+  /** The thread submitting the task is blocked until the queue has room. */
+  BLOCK,
+  /**
+   * The task is not accepted and the submitting call throws
+   * @ref cool::ng::exception::queue_full "queue_full" exception.
+   */
+  REJECT,
+  /** The oldest task waiting in the queue is discarded to make room. */
+  DROP_OLDEST
+};
+
 /**
  * A representation of the queue of asynchronously executing tasks.
  *
@@ -64,16 +159,682 @@ namespace impl { class run_queue; }
  */
 class runner
 {
+ public:
+  /**
+   * Clock of the task deadlines.
+   */
+  using clock = std::chrono::steady_clock;
+  /**
+   * Handler of the tasks that missed their deadline.
+   *
+   * The handler is called with the deadline of the task instead of the task.
+   *
+   * @see @ref options::on_late(const late_handler&) "on_late()"
+   */
+  using late_handler = std::function<void(const clock::time_point&)>;
+  /**
+   * Handler of the tasks shed by the overloaded runner.
+   *
+   * The handler is called with the time the task waited in the runner's
+   * queue instead of the task.
+   *
+   * @see @ref options::on_overload(const overload_handler&) "on_overload()"
+   */
+  using overload_handler = std::function<void(const clock::duration&)>;
+
+  /**
+   * Runner configuration.
+   *
+   * A set of optional parameters that control the behavior of the @ref runner's
+   * task queue. The parameters are specified at the @ref runner construction
+   * and cannot be changed afterwards. All setters return the reference to
+   * the options object to permit chaining:
+   * @code
+   *   cool::ng::async::runner r(cool::ng::async::runner::options()
+   *       .drain_limit(64)
+   *       .drain_time(std::chrono::microseconds(200)));
+   * @endcode
+   *
+   * @note Not all parameters are supported on all platforms. The parameters
+   *   not supported by the platform are silently ignored.
+   */
+  class options
+  {
+   public:
+    /**
+     * Default maximal number of tasks executed in a single drain.
+     */
+    static const std::size_t default_drain_limit = 32;
+    /**
+     * Default time budget of a single drain, in microseconds.
+     */
+    static const std::size_t default_drain_time = 1000;
+    /**
+     * Capacity of the unbounded task queue.
+     */
+    static const std::size_t unbounded = 0;
+    /**
+     * NUMA node value denoting no particular NUMA node.
+     */
+    static const int any_node = -1;
+    /**
+     * Default load shedding interval, in microseconds.
+     */
+    static const std::size_t default_shed_interval = 100000;
+
+   public:
+    options()
+      : m_drain_limit(default_drain_limit)
+      , m_drain_time(default_drain_time)
+      , m_policy(RunPolicy::SEQUENTIAL)
+      , m_metrics(false)
+      , m_capacity(unbounded)
+      , m_overflow(OverflowPolicy::BLOCK)
+      , m_priority(Priority::DEFAULT)
+      , m_numa_node(any_node)
+      , m_dedicated(false)
+      , m_busy_poll(0)
+      , m_weight(0)
+      , m_lanes(LanePolicy::STRICT)
+      , m_edf(false)
+      , m_shed_target(0)
+      , m_shed_interval(default_shed_interval)
+      , m_rate_count(0)
+      , m_rate_interval(0)
+      , m_rate_burst(0)
+    { /* noop */ }
+
+    /**
+     * Set the task scheduling policy.
+     *
+     * The tasks submitted to the @ref runner with the RunPolicy::CONCURRENT
+     * policy may run in parallel on all available worker threads. The tasks
+     * the running task submits to such runner are preferably executed on the
+     * same worker thread, where they can still find their data in the CPU
+     * cache, while the idle worker threads steal the older tasks. The drain
+     * limits do not apply to the concurrent runners.
+     *
+     * @param policy_ the task scheduling policy, RunPolicy::SEQUENTIAL by default
+     *
+     * @note Not all platforms support concurrent runners; on such platforms
+     *   the tasks are executed sequentially. The work stealing and the
+     *   preference for the submitting worker thread are only available with
+     *   the library's own thread pool (POSIX_POOL task runner
+     *   implementation); elsewhere the concurrent runner leaves the choice
+     *   of the worker thread to the platform.
+     */
+    options& policy(RunPolicy policy_)
+    {
+      m_policy = policy_;
+      return *this;
+    }
+
+    /**
+     * Set the priority class.
+     *
+     * @param priority_ the priority class, Priority::DEFAULT by default
+     *
+     * @see @ref Priority
+     */
+    options& priority(Priority priority_)
+    {
+      m_priority = priority_;
+      return *this;
+    }
+
+    /**
+     * Pin the runner to the set of CPUs.
+     *
+     * The tasks of the pinned @ref runner are executed by the group of worker
+     * threads that may only run on the CPUs in the set. The runners with the
+     * same CPU set and @ref Priority "priority class" share the same group
+     * of worker threads, which has one worker thread per CPU in the set.
+     * Use it to keep the tasks working on the same data, for example all the
+     * tasks of a connection, in the same cache hierarchy.
+     *
+     * @param cpus_ the indices of the CPUs, as used by the operating system;
+     *   the empty set, which is the default, does not pin the runner.
+     *
+     * @note Not all platforms support the CPU affinity.
+     */
+    options& affinity(const std::vector<unsigned int>& cpus_)
+    {
+      m_cpus = cpus_;
+      return *this;
+    }
+    /**
+     * Pin the runner to the NUMA node.
+     *
+     * The tasks of the @ref runner pinned to the NUMA node are executed by
+     * the group of worker threads that may only run on the CPUs of the node
+     * and prefer the memory of the node for their allocations. If the CPU
+     * set is also set, the runner is pinned to the CPUs of the set that
+     * belong to the node.
+     *
+     * @param node_ the NUMA node index, or @ref any_node, which is the default,
+     *   to not pin the runner to the NUMA node.
+     *
+     * @note Not all platforms support the NUMA placement.
+     * @see @ref affinity(const std::vector<unsigned int>&) "affinity()"
+     */
+    options& numa_node(int node_)
+    {
+      m_numa_node = node_;
+      return *this;
+    }
+
+    /**
+     * Run the runner on its own dedicated thread.
+     *
+     * The dedicated @ref runner does not share the worker threads with other
+     * runners. It owns a single thread that executes its tasks, one after
+     * another, like an event loop, hence the tasks do not wait for the worker
+     * thread to become available and the dispatch latency does not depend on
+     * the load of other runners. The thread runs with the @ref Priority
+     * "priority class" and the placement of the runner and is terminated
+     * after the runner is destroyed. The dedicated runner is always
+     * sequential and the drain limits do not apply to it.
+     *
+     * @param enable_ true to run the runner on its own thread
+     *
+     * @note Not all platforms support dedicated threads; on such platforms
+     *   the runner shares the worker threads with other runners.
+     * @see @ref busy_poll() "busy_poll()"
+     */
+    options& dedicated_thread(bool enable_)
+    {
+      m_dedicated = enable_;
+      return *this;
+    }
+    /**
+     * Set the busy poll interval of the dedicated thread.
+     *
+     * The dedicated thread that runs out of tasks keeps polling the task queue
+     * for the busy poll interval before it sleeps. The task submitted during
+     * the interval starts within microseconds, without the system call to
+     * wake the thread, at the expense of the CPU time spent polling. The
+     * interval of 0, which is the default, puts the thread to sleep at once.
+     *
+     * @note The busy poll is only effective with the
+     *   @ref dedicated_thread(bool) "dedicated thread".
+     */
+    template <typename RepT, typename PeriodT>
+    options& busy_poll(const std::chrono::duration<RepT, PeriodT>& interval_)
+    {
+      m_busy_poll = static_cast<std::size_t>(
+          std::chrono::duration_cast<std::chrono::microseconds>(interval_).count());
+      return *this;
+    }
+
+    /**
+     * Set the maximal number of tasks executed in a single drain.
+     *
+     * Once the @ref runner's task queue is scheduled to execute on one of
+     * the worker threads it will continue to execute its tasks, one after
+     * another, until either its queue is empty, or the number of executed
+     * tasks reaches the drain limit, or the drain time budget expires. Only
+     * then it will yield the worker thread and reschedule itself. The higher
+     * limit reduces the scheduling overhead per task at the expense of the
+     * fairness towards other runners sharing the same worker threads.
+     *
+     * @param limit_ maximal number of tasks per drain; value 1 yields the
+     *   worker thread after each task.
+     *
+     * @exception cool::ng::exception::illegal_argument thrown if @a limit_ is 0.
+     */
+    options& drain_limit(std::size_t limit_)
+    {
+      if (limit_ == 0)
+        throw exception::illegal_argument("drain limit must be greater than 0");
+      m_drain_limit = limit_;
+      return *this;
+    }
+    /**
+     * Set the time budget of a single drain.
+     *
+     * Once the drain exceeds the time budget, the @ref runner will yield the
+     * worker thread after the completion of the current task. The time budget
+     * of 0 disables the time limit.
+     *
+     * @see @ref drain_limit(std::size_t) "drain_limit"
+     */
+    template <typename RepT, typename PeriodT>
+    options& drain_time(const std::chrono::duration<RepT, PeriodT>& budget_)
+    {
+      m_drain_time = static_cast<std::size_t>(
+          std::chrono::duration_cast<std::chrono::microseconds>(budget_).count());
+      return *this;
+    }
+    /**
+     * Enable the fair scheduling with the specified weight.
+     *
+     * The fair runners share the worker threads in proportion to their
+     * weights, using the deficit round robin. In each turn the runner earns
+     * the drain time budget multiplied by its weight and may execute up to
+     * the drain limit multiplied by its weight tasks. The time its tasks
+     * actually took is charged against the earned time; the runner that
+     * overspent it, for instance with a single long task, pays the debt by
+     * giving up its next turns. This keeps the latency of the low volume
+     * runners bounded even if another runner is flooded with long tasks.
+     * The unused time is forfeited when the runner runs out of tasks.
+     *
+     * @param weight_ the weight of this runner; 0, which is the default,
+     *   disables the fair scheduling.
+     *
+     * @note The drain time budget of 0 disables the time accounting and the
+     *   runner only gets the larger drain limit. Not all platforms support
+     *   the fair scheduling.
+     * @see @ref drain_limit(std::size_t) "drain_limit"
+     */
+    options& fair_share(unsigned int weight_)
+    {
+      m_weight = weight_;
+      return *this;
+    }
+    /**
+     * Set the order of execution of the tasks of different urgency.
+     *
+     * @param policy_ the lane policy, LanePolicy::STRICT by default
+     *
+     * @note The lanes do not apply to the concurrent runners while they
+     *   are running. Not all platforms support the task urgency; on such
+     *   platforms the tasks are executed in the order of submission.
+     * @see @ref Urgency
+     */
+    options& lane_policy(LanePolicy policy_)
+    {
+      m_lanes = policy_;
+      return *this;
+    }
+    /**
+     * Return the order of execution of the tasks of different urgency.
+     */
+    LanePolicy lane_policy() const { return m_lanes; }
+    /**
+     * Execute the tasks in the order of their deadlines.
+     *
+     * The sequential @ref runner with the deadline order always executes the
+     * waiting task with the earliest deadline next, as set by
+     * @ref task::run() "run()", regardless of the order of submission. The
+     * tasks without the deadline are executed after all tasks with the
+     * deadline, and the tasks with the same deadline in the order of
+     * submission. The deadline order replaces the urgency lanes; the
+     * @ref Urgency "urgency" of the tasks is ignored.
+     *
+     * @param enable_ true to execute the tasks in the order of deadlines
+     *
+     * @note The deadline order does not apply to the concurrent runners
+     *   while they are running. Not all platforms support the deadline
+     *   order; on such platforms the tasks are executed in the order of
+     *   submission.
+     * @see @ref on_late(const late_handler&) "on_late()"
+     */
+    options& deadline_order(bool enable_)
+    {
+      m_edf = enable_;
+      return *this;
+    }
+    /**
+     * Return true if the tasks are executed in the order of their deadlines.
+     */
+    bool deadline_order() const { return m_edf; }
+    /**
+     * Set the handler of the tasks that missed their deadline.
+     *
+     * The runner with the @ref deadline_order(bool) "deadline order" checks
+     * the deadline of each task just before it would start. If the deadline
+     * has already passed, the runner calls the handler with the deadline and
+     * discards the task without executing it. Without the handler, which
+     * is the default, the late tasks are executed. The handler is called on
+     * the runner's worker thread, in place of the task, and should not block;
+     * the exceptions it throws are ignored. Its cost is that of a clock read
+     * per task with the deadline.
+     *
+     * @param handler_ the handler of the late tasks
+     */
+    options& on_late(const late_handler& handler_)
+    {
+      m_late = handler_;
+      return *this;
+    }
+    /**
+     * Return the handler of the tasks that missed their deadline.
+     */
+    const late_handler& on_late() const { return m_late; }
+    /**
+     * Enable the load shedding.
+     *
+     * The @ref runner with the load shedding measures the time each task
+     * waits in its queue. When even the shortest wait stays above the target
+     * for the whole interval, the runner is overloaded rather than absorbing
+     * a burst, and starts to shed the tasks just before they would start:
+     * the first task at once and then more and more often, until the wait
+     * falls below the target again. This is the CoDel algorithm, which keeps
+     * the queueing delay near the target under the sustained overload, while
+     * the short bursts pass untouched. The shed tasks are discarded, counted
+     * as dropped in the metrics and reported to the
+     * @ref on_overload(const overload_handler&) "overload handler", if set.
+     * The task is never shed if no other task is waiting behind it.
+     *
+     * @param target_ the acceptable waiting time; the typical value is a few
+     *   percent of the interval, and 0, which is the default, disables the
+     *   load shedding.
+     * @param interval_ the time the waiting time must stay above the target
+     *   before the shedding starts, which should cover the usual bursts;
+     *   @ref default_shed_interval by default.
+     *
+     * @note The load shedding does not apply to the concurrent runners while
+     *   they are running. Not all platforms support the load shedding.
+     */
+    template <typename RepT, typename PeriodT, typename IRepT, typename IPeriodT>
+    options& shed_load(
+        const std::chrono::duration<RepT, PeriodT>& target_
+      , const std::chrono::duration<IRepT, IPeriodT>& interval_)
+    {
+      m_shed_target = static_cast<std::size_t>(
+          std::chrono::duration_cast<std::chrono::microseconds>(target_).count());
+      m_shed_interval = static_cast<std::size_t>(
+          std::chrono::duration_cast<std::chrono::microseconds>(interval_).count());
+      return *this;
+    }
+    /**
+     * Enable the load shedding with the default interval.
+     *
+     * @see @ref shed_load() "shed_load()"
+     */
+    template <typename RepT, typename PeriodT>
+    options& shed_load(const std::chrono::duration<RepT, PeriodT>& target_)
+    {
+      return shed_load(target_, std::chrono::microseconds(default_shed_interval));
+    }
+    /**
+     * Return the acceptable waiting time of the load shedding, 0 if disabled.
+     */
+    std::chrono::microseconds shed_target() const
+    {
+      return std::chrono::microseconds(m_shed_target);
+    }
+    /**
+     * Return the load shedding interval.
+     */
+    std::chrono::microseconds shed_interval() const
+    {
+      return std::chrono::microseconds(m_shed_interval);
+    }
+    /**
+     * Set the handler of the tasks shed by the overloaded runner.
+     *
+     * The handler is called on the runner's worker thread, in place of the
+     * shed task, with the time the task waited in the queue. It should not
+     * block; the exceptions it throws are ignored.
+     *
+     * @param handler_ the handler of the shed tasks
+     *
+     * @see @ref shed_load() "shed_load()"
+     */
+    options& on_overload(const overload_handler& handler_)
+    {
+      m_overload = handler_;
+      return *this;
+    }
+    /**
+     * Return the handler of the tasks shed by the overloaded runner.
+     */
+    const overload_handler& on_overload() const { return m_overload; }
+    /**
+     * Limit the rate of task execution.
+     *
+     * The rate limited @ref runner starts at most @a count_ tasks per
+     * @a interval_, evenly paced, but permits the bursts of up to @a burst_
+     * tasks after the idle time. The runner that runs out of its rate yields
+     * the worker thread and is rescheduled when it may start the next task;
+     * no thread waits on its behalf. Use it to throttle the requests to the
+     * downstream systems instead of sleeping in the tasks.
+     *
+     * @param count_ the number of tasks per interval
+     * @param interval_ the interval
+     * @param burst_ the number of tasks that may start back-to-back; 0, the
+     *   default, permits the burst of @a count_ tasks.
+     *
+     * @exception cool::ng::exception::illegal_argument thrown if @a count_ is
+     *   0 or if @a interval_ is not positive.
+     *
+     * @note The rate limit does not apply to the concurrent runners while
+     *   they are running. Not all platforms support the rate limit.
+     */
+    template <typename RepT, typename PeriodT>
+    options& rate_limit(std::size_t count_, const std::chrono::duration<RepT, PeriodT>& interval_, std::size_t burst_ = 0)
+    {
+      auto interval = std::chrono::duration_cast<std::chrono::microseconds>(interval_).count();
+      if (count_ == 0)
+        throw exception::illegal_argument("rate limit must be greater than 0");
+      if (interval <= 0)
+        throw exception::illegal_argument("rate limit interval must be greater than 0");
+      m_rate_count = count_;
+      m_rate_interval = static_cast<std::size_t>(interval);
+      m_rate_burst = burst_ == 0 ? count_ : burst_;
+      return *this;
+    }
+    /**
+     * Return the number of tasks per rate limit interval, 0 if not limited.
+     */
+    std::size_t rate_limit() const { return m_rate_count; }
+    /**
+     * Return the rate limit interval.
+     */
+    std::chrono::microseconds rate_interval() const
+    {
+      return std::chrono::microseconds(m_rate_interval);
+    }
+    /**
+     * Return the number of tasks the rate limited runner may start back-to-back.
+     */
+    std::size_t rate_burst() const { return m_rate_burst; }
+    /**
+     * Return the weight of the runner, or 0 if the fair scheduling is disabled.
+     */
+    unsigned int fair_share() const { return m_weight; }
+    /**
+     * Return the maximal number of tasks executed in a single drain.
+     */
+    std::size_t drain_limit() const { return m_drain_limit; }
+    /**
+     * Return the time budget of a single drain.
+     */
+    std::chrono::microseconds drain_time() const
+    {
+      return std::chrono::microseconds(m_drain_time);
+    }
+    /**
+     * Enable or disable the collection of the scheduling metrics.
+     *
+     * When enabled, the @ref runner records the time each task was submitted,
+     * started and completed, and keeps the statistics that can be read using
+     * @ref runner::snapshot() "snapshot()". When disabled, which is the
+     * default, the metrics cost a single test per task.
+     *
+     * @param enable_ true to enable the collection of the metrics
+     */
+    options& collect_metrics(bool enable_)
+    {
+      m_metrics = enable_;
+      return *this;
+    }
+    /**
+     * Set the capacity of the task queue and the overflow policy.
+     *
+     * The bounded @ref runner accepts at most @a capacity_ tasks that are
+     * submitted but not yet started. When the queue is full, the @a policy_
+     * decides what happens with the next task:
+     *   - OverflowPolicy::BLOCK blocks the submitting thread until the runner
+     *     starts one of the waiting tasks. Since the stopped runner does not
+     *     start the tasks, the submitting thread remains blocked until the
+     *     runner is started. The task executing on the runner is never
+     *     blocked when submitting to its own runner, as this would deadlock;
+     *     its submission is accepted over the capacity instead. The
+     *     delayed task runs are never blocked either; they are not accepted
+     *     if the queue is full at the time of their submission.
+     *   - OverflowPolicy::REJECT throws
+     *     @ref cool::ng::exception::queue_full "queue_full" exception from
+     *     the submitting call. The compound task that moves to the next
+     *     runner from within its execution, and the delayed task run, have
+     *     no submitting call and report the exception to the exception
+     *     handler of the task instead.
+     *   - OverflowPolicy::DROP_OLDEST discards the oldest task waiting in
+     *     the queue. The concurrent runner can only discard the tasks held
+     *     while it is stopped; when running, it discards the submitted task.
+     *
+     * The batch of tasks submitted in one call is accepted as a whole, or
+     * not at all, and is accepted over the capacity if the queue is empty.
+     *
+     * @param capacity_ maximal number of waiting tasks, or @ref unbounded
+     *   for the queue without limit, which is the default.
+     * @param policy_ behavior when the queue is full, OverflowPolicy::BLOCK
+     *   by default.
+     *
+     * @warning The blocked thread may also be a worker thread executing a
+     *   task of another runner, which in turn may delay that runner.
+     * @note Not all platforms support bounded runners.
+     */
+    options& capacity(std::size_t capacity_, OverflowPolicy policy_ = OverflowPolicy::BLOCK)
+    {
+      m_capacity = capacity_;
+      m_overflow = policy_;
+      return *this;
+    }
+    /**
+     * Return the capacity of the task queue.
+     */
+    std::size_t capacity() const { return m_capacity; }
+    /**
+     * Return the behavior of the bounded task queue when full.
+     */
+    OverflowPolicy overflow() const { return m_overflow; }
+    /**
+     * Return the task scheduling policy.
+     */
+    RunPolicy policy() const { return m_policy; }
+    /**
+     * Return the priority class.
+     */
+    Priority priority() const { return m_priority; }
+    /**
+     * Return the set of CPUs the runner is to be pinned to.
+     */
+    const std::vector<unsigned int>& affinity() const { return m_cpus; }
+    /**
+     * Return the NUMA node the runner is to be pinned to.
+     */
+    int numa_node() const { return m_numa_node; }
+    /**
+     * Return true if the runner is to run on its own dedicated thread.
+     */
+    bool dedicated_thread() const { return m_dedicated; }
+    /**
+     * Return the busy poll interval of the dedicated thread.
+     */
+    std::chrono::microseconds busy_poll() const
+    {
+      return std::chrono::microseconds(m_busy_poll);
+    }
+    /**
+     * Return true if the collection of the scheduling metrics is enabled.
+     */
+    bool collect_metrics() const { return m_metrics; }
+
+   private:
+    std::size_t m_drain_limit;
+    std::size_t m_drain_time;
+    RunPolicy   m_policy;
+    bool        m_metrics;
+    std::size_t m_capacity;
+    OverflowPolicy m_overflow;
+    Priority    m_priority;
+    std::vector<unsigned int> m_cpus;
+    int         m_numa_node;
+    bool        m_dedicated;
+    std::size_t m_busy_poll;
+    unsigned int m_weight;
+    LanePolicy  m_lanes;
+    bool        m_edf;
+    late_handler m_late;
+    std::size_t m_shed_target;
+    std::size_t m_shed_interval;
+    overload_handler m_overload;
+    std::size_t m_rate_count;
+    std::size_t m_rate_interval;
+    std::size_t m_rate_burst;
+  };
+
+  /**
+   * Placement of the runner's worker threads.
+   *
+   * @see @ref location()
+   */
+  struct placement
+  {
+    placement() : numa_node(options::any_node)
+    { /* noop */ }
+
+    /** the CPUs the worker threads may run on, empty if not pinned */
+    std::vector<unsigned int> cpus;
+    /** the NUMA node of the worker threads, or options::any_node if none */
+    int                       numa_node;
+  };
+
+  /**
+   * Snapshot of the runner's scheduling metrics.
+   *
+   * The metrics are collected only if enabled via
+   * @ref options::collect_metrics(bool) "collect_metrics()" option at the
+   * @ref runner construction. The time histograms use logarithmic buckets:
+   * the bucket @c n counts the durations @c d, in nanoseconds, where
+   * 2<sup>n</sup> <= @c d < 2<sup>n+1</sup>. The bucket 0 also counts the
+   * durations shorter than 1 nanosecond and the last bucket also counts all
+   * durations longer than its upper bound.
+   *
+   * @note The values are read one by one while the runner may be executing
+   *   tasks, hence the snapshot is not necessarily consistent. For instance,
+   *   the sum of the wait histogram may differ from the task count.
+   */
+  struct metrics
+  {
+    /**
+     * Number of buckets in each time histogram.
+     */
+    static const std::size_t histogram_size = 40;
+
+    metrics()
+      : enabled(false), depth(0), high_water(0), count(0), dropped(0), wait(), run()
+    { /* noop */ }
+
+    /** true if the metrics are collected by this runner */
+    bool          enabled;
+    /** number of tasks submitted but not yet started */
+    std::size_t   depth;
+    /** the largest observed number of tasks submitted but not yet started */
+    std::size_t   high_water;
+    /** number of completed tasks */
+    uint64_t      count;
+    /** number of tasks discarded without execution */
+    uint64_t      dropped;
+    /** histogram of the time tasks spent waiting in the queue */
+    uint64_t      wait[histogram_size];
+    /** histogram of the task execution time */
+    uint64_t      run[histogram_size];
+  };
+
+ public:
+  using ptr = std::shared_ptr<runner>;
+
  public:
   runner(runner&&) = delete;
   runner& operator=(runner&&) = delete;
   /**
    * Construct a new runner object.
    *
-   * Constructs a new runner object, optionally with the desired task 
-   * scheduling policy.
-   run_queue
-   * @param policy_ optional parameter, set to RunPolicy::SEQUENTIAL by default.
+   * Constructs a new runner object with the default configuration and the
+   * RunPolicy::SEQUENTIAL task scheduling policy.
    *
    * @exception cool::exception::create_failure thrown if a new instance cannot
    *   be created.
@@ -82,6 +843,21 @@ class runner
    *   capable of executing tasks.
    */
   dlldecl runner();
+  /**
+   * Construct a new runner object with the specified configuration.
+   *
+   * @param opts_ runner configuration
+   *
+   * @exception cool::exception::create_failure thrown if a new instance cannot
+   *   be created.
+   * @exception cool::ng::exception::illegal_argument thrown if the runner is
+   *   to be pinned to the NUMA node that does not exist, or to the CPUs of
+   *   which none is available.
+   *
+   * @note The runner object is created in started state and is immediately
+   *   capable of executing tasks.
+   */
+  dlldecl explicit runner(const options& opts_);
 
   /**
    * Copy constructor.
@@ -120,6 +896,37 @@ class runner
    * Every runner object has a process level unique name.
    */
   dlldecl const std::string& name() const;
+  /**
+   * Return the snapshot of the scheduling metrics.
+   *
+   * Returns the current values of this runner's scheduling metrics. If the
+   * collection of the metrics was not enabled at the construction, or is
+   * not supported by the platform, the returned metrics' @c enabled member
+   * is set to false and all values are 0. This method is thread safe and
+   * does not interfere with the task execution.
+   */
+  dlldecl metrics snapshot() const;
+  /**
+   * Return the placement of this runner's worker threads.
+   *
+   * Returns the CPUs and the NUMA node the worker threads executing this
+   * runner's tasks are pinned to. The returned set of CPUs is empty if the
+   * runner is not pinned, or if the platform does not support pinning.
+   */
+  dlldecl placement location() const;
+  /**
+   * Return the number of tasks waiting in the task queue.
+   *
+   * Returns the number of tasks submitted to this runner but not yet started.
+   * The value is approximate as the runner may be executing tasks, and it
+   * does not include the tasks the concurrent runner already handed over to
+   * the worker threads. Unlike the @ref metrics::depth "depth" in the
+   * metrics, the value is available regardless of the metrics collection.
+   *
+   * @note Not all platforms support this query; on such platforms the
+   *   returned value is always 0.
+   */
+  dlldecl std::size_t depth() const;
   /**
    * Return the task queue implementation.
    *
@@ -128,14 +935,6 @@ class runner
    */
   const std::shared_ptr<impl::run_queue>& impl() const;
 
- private:
-  std::shared_ptr<impl::run_queue> m_impl;
-};
-
-
-#if 0
-
-
   /**
    * Returns system-wide runner object with the high priority.
    *
@@ -166,7 +965,10 @@ class runner
    * @note This runner executes tasks sequentially.
    */
   dlldecl static ptr cool_default();
-#endif
+
+ private:
+  std::shared_ptr<impl::run_queue> m_impl;
+};
 
 } } } // namespace
 
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_9c90488a_c24e_4958_9c70_5f6c068c0f69)
+#define      cool_ng_9c90488a_c24e_4958_9c70_5f6c068c0f69
+
+#include <memory>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include "cool/ng/impl/platform.h"
+#include "cool/ng/exception.h"
+#include "cool/ng/ip_address.h"
+#include "cool/ng/async/runner.h"
+
+namespace cool { namespace ng { namespace async {
+
+namespace detail {
+
+// the IP address types use the hash of their common base
+template <typename KeyT, typename = void>
+struct key_hash : public std::hash<KeyT>
+{ /* noop */ };
+
+template <typename KeyT>
+struct key_hash<KeyT, typename std::enable_if<std::is_base_of<ip::address, KeyT>::value>::type>
+  : public std::hash<ip::address>
+{ /* noop */ };
+
+} // namespace detail
+
+/**
+ * A fixed set of sequential runners with the key affinity.
+ *
+ * The runner pool spreads the tasks of many logical sessions over a fixed
+ * number of sequential @ref runner "runners" while preserving the order of
+ * tasks within each session. The session is identified by a key, such as
+ * the connection identifier or the @ref ip::host "IP address" of the peer,
+ * and all tasks with the same key are executed by the same member runner:
+ * @code
+ *   cool::ng::async::runner_pool pool(8);
+ *
+ *   auto task = cool::ng::async::factory::create(
+ *       pool
+ *     , connection_id
+ *     , [] (const cool::ng::async::runner::ptr& r_, const buffer& data_)
+ *       {
+ *         ...
+ *       });
+ * @endcode
+ * The key is mapped to the member runner with the @c std::hash of its type,
+ * except for the IP address types, which use the hash of
+ * @ref ip::address. The hash value is mixed before the selection of the
+ * member runner, so the keys with the consecutive hash values, such as the
+ * integral identifiers, spread evenly over the members.
+ *
+ * The sessions without the established key affinity may be placed on the
+ * member runner with the fewest waiting tasks, using least_loaded().
+ *
+ * All methods of the runner pool are thread safe.
+ */
+class runner_pool
+{
+ public:
+  using ptr = std::shared_ptr<runner_pool>;
+
+ public:
+  runner_pool(const runner_pool&) = delete;
+  runner_pool& operator=(const runner_pool&) = delete;
+  /**
+   * Construct a new runner pool.
+   *
+   * Constructs the runner pool with @a size_ member runners, each created with
+   * the specified configuration. The member runners are always sequential;
+   * the task scheduling policy in @a opts_ is ignored.
+   *
+   * @param size_ number of member runners
+   * @param opts_ configuration of the member runners
+   *
+   * @exception cool::ng::exception::illegal_argument thrown if @a size_ is 0,
+   *   or if the member runners cannot be created with the configuration.
+   */
+  dlldecl explicit runner_pool(std::size_t size_, const runner::options& opts_ = runner::options());
+
+  /**
+   * Return the number of member runners.
+   */
+  std::size_t size() const { return m_runners.size(); }
+  /**
+   * Return the member runner at the specified index.
+   *
+   * @exception cool::ng::exception::illegal_argument thrown if @a index_ is
+   *   not less than size().
+   */
+  dlldecl const runner::ptr& at(std::size_t index_) const;
+  /**
+   * Return the index of the member runner for the key.
+   *
+   * @tparam HashT hash function object type to use instead of the default
+   */
+  template <typename KeyT, typename HashT = detail::key_hash<KeyT>>
+  std::size_t index_of(const KeyT& key_) const
+  {
+    return select(HashT()(key_));
+  }
+  /**
+   * Return the member runner for the key.
+   *
+   * All calls with the keys that compare equal return the same member runner.
+   *
+   * @tparam HashT hash function object type to use instead of the default
+   */
+  template <typename KeyT, typename HashT = detail::key_hash<KeyT>>
+  const runner::ptr& get(const KeyT& key_) const
+  {
+    return m_runners[index_of<KeyT, HashT>(key_)];
+  }
+  /**
+   * Return the number of tasks waiting in the task queue of the member runner.
+   *
+   * @exception cool::ng::exception::illegal_argument thrown if @a index_ is
+   *   not less than size().
+   * @see @ref runner::depth()
+   */
+  dlldecl std::size_t depth(std::size_t index_) const;
+  /**
+   * Return the index of the member runner with the fewest waiting tasks.
+   *
+   * If several member runners have the same number of waiting tasks, the
+   * one with the lowest index is returned. The result is approximate, as
+   * the member runners may be executing tasks.
+   *
+   * @note On the platforms that do not support @ref runner::depth() the
+   *   member runner at index 0 is always returned.
+   */
+  dlldecl std::size_t least_loaded() const;
+
+ private:
+  dlldecl std::size_t select(std::size_t hash_) const;
+
+ private:
+  std::vector<runner::ptr> m_runners;
+};
+
+} } } // namespace
+
+#endif
@@ -27,11 +27,14 @@
 #include <string>
 #include <functional>
 #include <iostream>
+#include <iterator>
+#include <chrono>
 
 #include "cool/ng/impl/platform.h"
 #include "cool/ng/exception.h"
 #include "cool/ng/traits.h"
 #include "cool/ng/async/runner.h"
+#include "cool/ng/async/runner_pool.h"
 #include "cool/ng/impl/async/task.h"
 
 namespace cool { namespace ng {
@@ -685,6 +688,89 @@ struct tag
 
 struct factory;
 
+template <typename ImplT, typename LinkT = typename ImplT::link_type>
+class x_task
+{ /* noop default template */ };
+
+/**
+ * A class template representing the statically typed tasks.
+ *
+ * The statically typed task is what the @ref factory::create() "create()" and
+ * @ref factory::sequence() "sequence()" factory methods return. Unlike the
+ * @ref task, whose compound tasks pass the values between their subtasks in
+ * type erased form, the statically typed task keeps the types of all its
+ * subtasks in its @c impl_type and passes the values between them by
+ * reference, without boxing them on the heap.
+ *
+ * The task exposes the following public member types:
+ *   - @c this_type, the type of this task type
+ *   - @c runner_type, the type of the @ref runner, associated with this task
+ *     type, or the default runner type for the compound tasks
+ *   - @c result_type, the type of the result value of this task type. Result
+ *     type @c void denotes that this task type has no result value.
+ *   - @c impl_type, the type that stores the static information about this
+ *     task type.
+ *
+ * The input of the task, if any, is passed to the @ref run() "run()" method
+ * as its leading argument.
+ */
+template <typename ImplT, typename... InputT>
+class x_task<ImplT, detail::x_link<InputT...>>
+{
+ public:
+  using this_type   = x_task;
+  using impl_type   = ImplT;
+  using runner_type = typename impl_type::runner_type;
+  using result_type = typename impl_type::result_type;
+
+ public:
+  x_task() { /* noop */ }
+ /**
+  * Predicate to check whether the task is empty.
+  */
+  explicit operator bool () const
+  {
+    return !!m_impl;
+  }
+ /**
+  * Schedule task for execution.
+  *
+  * @param input_ the input of the task, if any
+  * @param urgency_ the urgency of the task within its runners; the more urgent
+  *   tasks overtake the less urgent tasks waiting in the same @ref runner.
+  *
+  * @exception cool::ng::exception::queue_full thrown if the runner of the task
+  *   is bounded with OverflowPolicy::REJECT policy and its queue is full
+  * @see @ref Urgency
+  */
+  void run(const InputT&... input_, Urgency urgency_ = Urgency::NORMAL) const
+  {
+    m_impl->run(m_impl, input_..., urgency_);
+  }
+ /**
+  * Schedule task for execution with the deadline.
+  *
+  * @param input_ the input of the task, if any
+  * @param deadline_ the time by which the task should start
+  *
+  * @exception cool::ng::exception::queue_full thrown if the runner of the task
+  *   is bounded with OverflowPolicy::REJECT policy and its queue is full
+  * @see @ref task::run() "task::run()" for the deadline handling
+  */
+  void run(const InputT&... input_, const runner::clock::time_point& deadline_) const
+  {
+    m_impl->run(m_impl, input_..., Urgency::NORMAL, deadline_);
+  }
+
+ private:
+  friend struct factory;
+  x_task(const std::shared_ptr<impl_type>& impl_) : m_impl(impl_)
+  { /* noop */ }
+
+ private:
+  std::shared_ptr<impl_type> m_impl;
+};
+
 /**
  * A class template representing the objects that can be scheduled for
  * execution by one of the @ref runner "runners".
@@ -748,16 +834,6 @@ struct factory;
  * See @ref tag for more details on ech kind of tasks.
  */
 
-template <typename ResultT, typename... InputT>
-class x_task
-{
- public:
-
- private:
-  using impl_type = detail::x_taskinfo<ResultT, InputT...>;
-
-};
-
 template <typename InputT, typename ResultT>
 class task
 {
@@ -778,36 +854,233 @@ class task
   }
  /**
   * Schedule task for execution.
+  *
+  * @param arg_ the input of the task
+  * @param urgency_ the urgency of the task within its runners; the more urgent
+  *   tasks overtake the less urgent tasks waiting in the same @ref runner.
+  *
+  * @exception cool::ng::exception::queue_full thrown if the runner of the task
+  *   is bounded with OverflowPolicy::REJECT policy and its queue is full
+  * @see @ref Urgency
   */
   template <typename T = InputT>
   void run(const typename std::decay<typename std::enable_if<
       !std::is_same<T, void>::value && !std::is_rvalue_reference<T>::value
-    , T>::type>::type& arg_) const
+    , T>::type>::type& arg_, Urgency urgency_ = Urgency::NORMAL) const
   {
-    m_impl->run(m_impl, arg_);
+    m_impl->run(m_impl, arg_, urgency_);
   }
 
   // rvalue reference
   template <typename T = InputT>
   void run(typename std::enable_if<
       !std::is_same<T, void>::value && std::is_rvalue_reference<T>::value
-    , T>::type arg_) const
+    , T>::type arg_, Urgency urgency_ = Urgency::NORMAL) const
   {
-    m_impl->run(m_impl, std::move(arg_));
+    m_impl->run(m_impl, std::move(arg_), urgency_);
   }
  /**
   * Schedule task for execution.
+  *
+  * @param urgency_ the urgency of the task within its runners
+  *
+  * @see @ref Urgency
+  */
+  template <typename T = InputT>
+  typename std::enable_if<std::is_same<T, void>::value, void>::type run(Urgency urgency_ = Urgency::NORMAL) const
+  {
+    m_impl->run(m_impl, urgency_);
+  }
+ /**
+  * Schedule task for execution with the deadline.
+  *
+  * The @ref runner with the @ref runner::options::deadline_order(bool)
+  * "deadline order" executes the waiting task with the earliest deadline
+  * first and may discard the task that missed its deadline, while other
+  * runners ignore the deadline. The deadline applies to all runners the
+  * task visits.
+  *
+  * @param arg_ the input of the task
+  * @param deadline_ the time by which the task should start
+  *
+  * @exception cool::ng::exception::queue_full thrown if the runner of the task
+  *   is bounded with OverflowPolicy::REJECT policy and its queue is full
+  * @see @ref runner::options::on_late(const runner::late_handler&) "on_late()"
+  */
+  template <typename T = InputT>
+  void run(const typename std::decay<typename std::enable_if<
+      !std::is_same<T, void>::value && !std::is_rvalue_reference<T>::value
+    , T>::type>::type& arg_, const runner::clock::time_point& deadline_) const
+  {
+    m_impl->run(m_impl, arg_, Urgency::NORMAL, deadline_);
+  }
+
+  // rvalue reference
+  template <typename T = InputT>
+  void run(typename std::enable_if<
+      !std::is_same<T, void>::value && std::is_rvalue_reference<T>::value
+    , T>::type arg_, const runner::clock::time_point& deadline_) const
+  {
+    m_impl->run(m_impl, std::move(arg_), Urgency::NORMAL, deadline_);
+  }
+ /**
+  * Schedule task for execution with the deadline.
+  *
+  * @param deadline_ the time by which the task should start
+  *
+  * @see @ref runner::options::deadline_order(bool) "deadline_order()"
+  */
+  template <typename T = InputT>
+  typename std::enable_if<std::is_same<T, void>::value, void>::type run(const runner::clock::time_point& deadline_) const
+  {
+    m_impl->run(m_impl, Urgency::NORMAL, deadline_);
+  }
+ /**
+  * Schedule task for execution at the given time.
+  *
+  * The task is submitted to its @ref runner at time @a when_, or as soon as
+  * possible if this time has already passed, and then executes as if
+  * @ref task::run() "run()" was called at that time. The pending delayed runs
+  * share a single timer and cost a timer heap insert each, hence the delayed
+  * runs are suitable for large numbers of short-lived retries and timeouts,
+  * where the @ref cool::ng::async::timer "timer" event source is not.
+  *
+  * @param when_ the time at which to submit the task
+  * @param arg_ the input of the task
+  *
+  * @exception cool::ng::exception::runner_not_available thrown if the
+  *   runner of the task is no longer available
+  *
+  * @note The delayed run cannot be cancelled. If the @ref runner of the task
+  *   is gone at time @a when_, the task is silently dropped. If the runner
+  *   does not accept the task, the task reports the
+  *   @ref cool::ng::exception::queue_full "queue_full" exception to its
+  *   exception handler, if any. The bounded runner whose queue is full does
+  *   not accept the delayed run regardless of its overflow policy, as the
+  *   delayed runs are submitted from a timer that must not block.
+  */
+  template <typename T = InputT>
+  void run_at(const runner::clock::time_point& when_, const typename std::decay<typename std::enable_if<
+      !std::is_same<T, void>::value && !std::is_rvalue_reference<T>::value
+    , T>::type>::type& arg_) const
+  {
+    m_impl->run_at(m_impl, when_, arg_);
+  }
+
+  // rvalue reference
+  template <typename T = InputT>
+  void run_at(const runner::clock::time_point& when_, typename std::enable_if<
+      !std::is_same<T, void>::value && std::is_rvalue_reference<T>::value
+    , T>::type arg_) const
+  {
+    m_impl->run_at(m_impl, when_, std::move(arg_));
+  }
+ /**
+  * Schedule task for execution at the given time.
+  *
+  * @param when_ the time at which to submit the task
+  *
+  * @see @ref run_at(const runner::clock::time_point&, const T&) "run_at()"
+  */
+  template <typename T = InputT>
+  typename std::enable_if<std::is_same<T, void>::value, void>::type run_at(const runner::clock::time_point& when_) const
+  {
+    m_impl->run_at(m_impl, when_);
+  }
+ /**
+  * Schedule task for execution after the given delay.
+  *
+  * Has the same effect as @ref run_at(const runner::clock::time_point&, const T&) "run_at()"
+  * with the time @a delay_ from now.
+  *
+  * @param delay_ the delay after which to submit the task
+  * @param arg_ the input of the task
+  *
+  * @exception cool::ng::exception::runner_not_available thrown if the
+  *   runner of the task is no longer available
+  */
+  template <typename RepT, typename PeriodT, typename T = InputT>
+  void run_after(const std::chrono::duration<RepT, PeriodT>& delay_, const typename std::decay<typename std::enable_if<
+      !std::is_same<T, void>::value && !std::is_rvalue_reference<T>::value
+    , T>::type>::type& arg_) const
+  {
+    m_impl->run_at(m_impl, delayed(delay_), arg_);
+  }
+
+  // rvalue reference
+  template <typename RepT, typename PeriodT, typename T = InputT>
+  void run_after(const std::chrono::duration<RepT, PeriodT>& delay_, typename std::enable_if<
+      !std::is_same<T, void>::value && std::is_rvalue_reference<T>::value
+    , T>::type arg_) const
+  {
+    m_impl->run_at(m_impl, delayed(delay_), std::move(arg_));
+  }
+ /**
+  * Schedule task for execution after the given delay.
+  *
+  * @param delay_ the delay after which to submit the task
+  *
+  * @see @ref run_after(const std::chrono::duration<RepT, PeriodT>&, const T&) "run_after()"
+  */
+  template <typename RepT, typename PeriodT, typename T = InputT>
+  typename std::enable_if<std::is_same<T, void>::value, void>::type run_after(const std::chrono::duration<RepT, PeriodT>& delay_) const
+  {
+    m_impl->run_at(m_impl, delayed(delay_));
+  }
+ /**
+  * Schedule the task for execution once for each input value in the range.
+  *
+  * Has the same effect as the calls to @ref task::run() "run()" for each
+  * value in the range, in the range order, but builds the execution contexts
+  * for all runs first and then submits them to the @ref runner together, thus
+  * sharing the submission cost among all runs. Use it when a burst of inputs,
+  * for example the messages received in a single read, is to be processed by
+  * the same task.
+  *
+  * @param range_ a range of values convertible to the task's input type; any
+  *   type for which @c std::begin() and @c std::end() are defined.
+  *
+  * @exception cool::ng::exception::runner_not_available thrown if the
+  *   runner of the task is no longer available
+  * @exception cool::ng::exception::queue_full thrown if the runner of the task
+  *   is bounded with OverflowPolicy::REJECT policy and has no room for all runs
+  */
+  template <typename RangeT, typename T = InputT>
+  typename std::enable_if<!std::is_same<T, void>::value, void>::type run_many(const RangeT& range_) const
+  {
+    m_impl->run_many(m_impl, std::begin(range_), std::end(range_));
+  }
+ /**
+  * Schedule the task for execution once for each input value in the range
+  * [first_, last_).
+  *
+  * @see @ref run_many(const RangeT&) "run_many()"
+  */
+  template <typename IteratorT, typename T = InputT>
+  typename std::enable_if<!std::is_same<T, void>::value, void>::type run_many(IteratorT first_, IteratorT last_) const
+  {
+    m_impl->run_many(m_impl, first_, last_);
+  }
+ /**
+  * Schedule the task without input for execution @a count_ times.
+  *
+  * @see @ref run_many(const RangeT&) "run_many()"
   */
   template <typename T = InputT>
-  typename std::enable_if<std::is_same<T, void>::value, void>::type run() const
+  typename std::enable_if<std::is_same<T, void>::value, void>::type run_many(std::size_t count_) const
   {
-    m_impl->run(m_impl);
+    m_impl->run_many(m_impl, count_);
   }
 
  private:
   friend struct factory;
   task(const std::shared_ptr<impl_type> impl_) : m_impl(impl_)
   { /* noop */ }
+  template <typename RepT, typename PeriodT>
+  static runner::clock::time_point delayed(const std::chrono::duration<RepT, PeriodT>& delay_)
+  {
+    return runner::clock::now() + std::chrono::duration_cast<runner::clock::duration>(delay_);
+  }
 
  private:
   std::shared_ptr<impl_type> m_impl;
@@ -830,15 +1103,16 @@ struct factory {
    * @see @ref tag::simple "simple" task
    */
   template <typename RunnerT, typename CallableT>
-  inline static task<
-      typename traits::arg_type<1, CallableT>::type
+  inline static x_task<typename detail::x_simple_for<
+      RunnerT
     , typename traits::functional<CallableT>::result_type
-  > create(const std::weak_ptr<RunnerT>& r_, const CallableT& f_)
+    , typename traits::arg_type<1, CallableT>::type
+  >::type> create(const std::weak_ptr<RunnerT>& r_, const CallableT& f_)
   {
     using result_type = typename traits::functional<CallableT>::result_type;
     using input_type = typename traits::arg_type<1, CallableT>::type;
-    using task_type = task<input_type, result_type>;
-    using taskinfo_type = detail::taskinfo<tag::simple, RunnerT, input_type, result_type>;
+    using taskinfo_type = typename detail::x_simple_for<RunnerT, result_type, input_type>::type;
+    using task_type = x_task<taskinfo_type>;
 
     // Make diagnostics a bit more user friendly - do some compile time checks
     // user callable must accept one or two parameters ...
@@ -863,18 +1137,48 @@ struct factory {
      || (traits::functional<CallableT>::template arg<0>::info::is_lref::value
           && traits::functional<CallableT>::template arg<0>::info::is_const::value)
       , "The first parameter to user Callable must either be by value or const lvalue reference");
+    // the input is passed to the Callable as const lvalue reference
+    static_assert(
+        !std::is_rvalue_reference<input_type>::value
+     && (!std::is_lvalue_reference<input_type>::value
+          || std::is_const<typename std::remove_reference<input_type>::type>::value)
+      , "The second parameter to user Callable must either be by value or const lvalue reference");
 
-    return task_type(std::shared_ptr<typename task_type::impl_type>(new taskinfo_type(r_, f_)));
+    return task_type(std::make_shared<taskinfo_type>(r_, f_));
   }
 
   template <typename RunnerT, typename CallableT>
-  inline static task<
-      typename traits::arg_type<1, CallableT>::type
+  inline static x_task<typename detail::x_simple_for<
+      RunnerT
     , typename traits::functional<CallableT>::result_type
-  > create(const std::shared_ptr<RunnerT>& r_, const CallableT& f_)
+    , typename traits::arg_type<1, CallableT>::type
+  >::type> create(const std::shared_ptr<RunnerT>& r_, const CallableT& f_)
   {
     return factory::create(std::weak_ptr<RunnerT>(r_), f_);
   }
+  /**
+   * Factory method to create @ref tag::simple "simple" tasks bound to the
+   * member runner of the runner pool.
+   *
+   * The task is bound to the member runner of @a p_ selected by the key
+   * @a k_, hence all tasks created for the same key are executed by the
+   * same runner, in the order of their submission.
+   *
+   * @param p_ @ref runner_pool "runner pool" to select the runner from
+   * @param k_ key to select the runner by
+   * @param f_ user Callable runner should invoke during task execution
+   *
+   * @see @ref runner_pool::get()
+   */
+  template <typename KeyT, typename CallableT>
+  inline static x_task<typename detail::x_simple_for<
+      runner
+    , typename traits::functional<CallableT>::result_type
+    , typename traits::arg_type<1, CallableT>::type
+  >::type> create(const runner_pool& p_, const KeyT& k_, const CallableT& f_)
+  {
+    return factory::create(p_.get(k_), f_);
+  }
   // IMPLEMENTATION_NOTE:
   //   Compound tasks do not need a runner of their own hence the
   //   default_runner_type is used as a type constant for all compounds.
@@ -884,29 +1188,22 @@ struct factory {
   /**
    * Factory method for creating @ref tag::sequential "sequential" compound tasks.
    *
+   * The sequence of simple tasks of the same runner type is fused into a
+   * single task whose single context calls the user Callables back-to-back.
+   *
    * @param t_ two or more tasks to run in sequence
    *
    * @see @ref tag::sequential "sequential" compound task
    */
   template <typename... TaskT>
-  inline static task<
-      typename detail::traits::get_first<TaskT...>::type::input_type
-    , typename detail::traits::get_sequence_result_type<TaskT...>::type
+  inline static x_task<
+    typename detail::x_sequence<typename TaskT::impl_type...>::type
   > sequence(const TaskT&... t_)
   {
-    static_assert(
-        sizeof...(t_) > 1
-      , "It takes at least two tasks to create a sequential compound task");
-    static_assert(
-        detail::traits::is_chain<typename std::decay<TaskT>::type...>::result::value
-      , "The type of the parameter of each task in the sequence must match the return type of the preceding task.");
-
-    using result_type = typename detail::traits::get_sequence_result_type<TaskT...>::type;
-    using input_type = typename detail::traits::get_first<TaskT...>::type::input_type;
-    using task_type = task<input_type, result_type>;
-    using taskinfo_type = detail::taskinfo<tag::sequential, detail::default_runner_type, input_type, result_type>;
+    using sequence_type = detail::x_sequence<typename TaskT::impl_type...>;
+    using task_type = x_task<typename sequence_type::type>;
 
-    return task_type(std::shared_ptr<typename task_type::impl_type>(new taskinfo_type(t_.m_impl...)));
+    return task_type(sequence_type::create(t_.m_impl...));
   }
 
   /**
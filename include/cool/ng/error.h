@@ -58,6 +58,7 @@ enum class errc
          not_found,           //!< The item was not found
          already_exists,      //!< The item already exists
          no_context,          //!< The expected context for the asynchronous or delayed  operation does not exist.
+         queue_full,          //!< The @ref async::runner "runner's" task queue is full and did not accept the task
 };
 
 /**
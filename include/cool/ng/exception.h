@@ -417,6 +417,36 @@ class no_context final : public base
   }
 };
 
+/**
+ * @ingroup excool
+ * Exception class denoting that the @ref async::runner "runner's" task queue
+ * is full and did not accept the task.
+ *
+ * @note The @ref code() method will return @ref error::errc::queue_full "queue_full".
+ */
+class queue_full final : public base
+{
+ public:
+  /**
+   * Construct a new exception object.
+   *
+   * @param msg_ optional user message
+   * @param backtrace_ optional flag to set to @c false if the stack backtrace is not
+   *                   wanted; default value is @c true.
+   */
+  queue_full(const std::string& msg_ = "", bool backtrace_ = true)
+    : base(msg_, backtrace_)
+  { /* noop */ }
+  std::error_code code() const NOEXCEPT_ override
+  {
+    return make_error_code(cool::ng::error::errc::queue_full);
+  }
+  const char* name() const NOEXCEPT_ override
+  {
+    return "queue_full";
+  }
+};
+
 
 /**
  * @ingroup excool
@@ -114,7 +114,7 @@ class task_context<tag::conditional, RunnerT, InputT, ResultT>
     , const std::shared_ptr<task>& else_
     , const any& input_)
   {
-    auto aux = new this_type(stack_, task_, if_, else_);
+    auto aux = new (stack_) this_type(stack_, task_, if_, else_);
     stack_->push(aux);
 
     aux->set_input(input_);
@@ -183,8 +183,8 @@ class task_context<tag::conditional, RunnerT, InputT, ResultT>
   void prepare_next_task(const std::shared_ptr<task>& t_)
   {
     auto ctx = t_->create_context(m_stack, t_, m_input);
-    ctx->set_res_reporter(std::bind(&this_type::result_report, this, std::placeholders::_1));
-    ctx->set_exc_reporter(std::bind(&this_type::exception_report, this, std::placeholders::_1));
+    ctx->set_res_reporter(result_reporter::bind<this_type, &this_type::result_report>(this));
+    ctx->set_exc_reporter(exception_reporter::bind<this_type, &this_type::exception_report>(this));
   }
 
  private:
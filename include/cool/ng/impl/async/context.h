@@ -25,12 +25,17 @@
 #define      cool_ng_41352af7_f2d7_4732_8200_beef75dc84b2
 
 #include <cstddef>
+#include <chrono>
 #include <memory>
 #include <tuple>
 #include <functional>
 #include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <new>
 
 #include "cool/ng/exception.h"
+#include "cool/ng/async/runner.h"
 namespace cool { namespace ng {  namespace async {
 
 class runner;
@@ -50,94 +55,208 @@ namespace detail {
 class any
 {
  private:
-  class valueholder
+  // the values of small, nothrow move constructible types are stored in the
+  // buffer within the any, others in a heap allocated object
+  using buffer = std::aligned_storage<2 * sizeof(void*), alignof(void*)>::type;
+
+  template <typename T>
+  struct is_inline : public std::integral_constant<bool,
+         sizeof(T) <= sizeof(buffer)
+      && alignof(buffer) % alignof(T) == 0
+      && std::is_nothrow_move_constructible<T>::value>
+  { };
+
+  // type specific operations on the stored value; the address of the handler
+  // is the type tag of the stored value
+  struct handler
   {
-   public:
-    virtual ~valueholder() { /* noop */ }
-    virtual const std::type_info& type() const = 0;
-    virtual std::unique_ptr<valueholder> clone() = 0;
+    const std::type_info& (*type)();
+    void (*destroy)(any&);
+    // moves the value to the empty any and leaves the source any empty
+    void (*transfer)(any& from_, any& to_);
+    // moves the value to the empty any and leaves the moved-from value
+    // in the source any
+    void (*clone)(any& from_, any& to_);
   };
 
-  template <typename ValueType>
-  class value : public valueholder
+  // moves the value if its type is MoveConstructible, otherwise copies it
+  template <typename T>
+  static typename std::conditional<std::is_move_constructible<T>::value, T&&, const T&>::type
+  move_or_copy(T& v_)
+  { return std::move(v_); }
+
+  template <typename T, bool Inline = is_inline<T>::value>
+  struct manager
   {
-   public:
-    using value_type = ValueType;
-
-    value(const ValueType& v_) : m_v(v_)
-    { /* noop */ }
-    template <typename ValueT>
-    value(ValueT && v_,
-        typename std::enable_if<std::is_move_constructible<ValueT>::value>::type* = 0)
-      : m_v(std::move(v_))
-    { /* noop */ }
-
-    const std::type_info& type() const override
+    static T* get(any& a_)
+    { return reinterpret_cast<T*>(&a_.m_buffer); }
+    template <typename ArgT>
+    static void create(any& a_, ArgT&& v_)
+    { new (&a_.m_buffer) T(std::forward<ArgT>(v_)); }
+    static void destroy(any& a_)
+    { get(a_)->~T(); }
+    static void transfer(any& from_, any& to_)
     {
-      return typeid(ValueType);
+      create(to_, std::move(*get(from_)));
+      destroy(from_);
     }
+    static void clone(any& from_, any& to_)
+    { create(to_, move_or_copy(*get(from_))); }
+    static const std::type_info& type()
+    { return typeid(T); }
 
-    std::unique_ptr<valueholder> clone() override
-    {
-      return std::unique_ptr<value>(new value(std::move(m_v)));
-    }
+    static const handler table;
+  };
 
-   private:
-    template <typename T>
-    friend T* any_cast(any*);
-    ValueType m_v;
+  template <typename T>
+  struct manager<T, false>
+  {
+    static T* get(any& a_)
+    { return static_cast<T*>(a_.m_pointer); }
+    template <typename ArgT>
+    static void create(any& a_, ArgT&& v_)
+    { a_.m_pointer = new T(std::forward<ArgT>(v_)); }
+    static void destroy(any& a_)
+    { delete get(a_); }
+    static void transfer(any& from_, any& to_)
+    { to_.m_pointer = from_.m_pointer; }
+    static void clone(any& from_, any& to_)
+    { create(to_, move_or_copy(*get(from_))); }
+    static const std::type_info& type()
+    { return typeid(T); }
+
+    static const handler table;
   };
 
+  template <typename ValueT>
+  using enable_for_value = typename std::enable_if<
+      !std::is_same<typename std::decay<ValueT>::type, any>::value>::type;
+
  public:
   // -- ctors and assignments
-  any()
-  { /* noop */ }
-  any(any&& other_) : m_value(std::move(other_.m_value))
-  { /* noop */ }
-  template <typename ValueT> any(const ValueT& value_)
-    : m_value(new value<typename std::decay<ValueT>::type>(value_))
+  any() : m_handler(nullptr)
   { /* noop */ }
-  template <typename ValueT> any(ValueT&& value_
+  any(any&& other_) : m_handler(nullptr)
+  { take(other_); }
+  template <typename ValueT, typename = enable_for_value<ValueT>> any(const ValueT& value_)
+    : m_handler(nullptr)
+  { create<typename std::decay<ValueT>::type>(value_); }
+  template <typename ValueT, typename = enable_for_value<ValueT>> any(ValueT&& value_
     , typename std::enable_if<!std::is_const<ValueT>::value && std::is_move_constructible<ValueT>::value>::type* = 0)
-        : m_value(new value<typename std::decay<ValueT>::type>(std::move(value_)))
-  { /* noop */ }
+        : m_handler(nullptr)
+  { create<typename std::decay<ValueT>::type>(move_or_copy(value_)); }
   any& operator =(any&& other_)
-  { m_value = std::move(other_.m_value); return *this; }
-  template <typename ValueT>
+  {
+    if (&other_ != this)
+    {
+      clear();
+      take(other_);
+    }
+    return *this;
+  }
+  template <typename ValueT, typename = enable_for_value<ValueT>>
   any& operator =(ValueT&& value_)
   {
-    m_value.reset(new value<typename std::decay<ValueT>::type>(std::move(value_)));
+    clear();
+    create<typename std::decay<ValueT>::type>(move_or_copy(value_));
     return *this;
   }
-  any(const any& other_) : m_value( other_.m_value ? other_.m_value->clone() : nullptr)
-  { /* noop */ }
+  // copy moves the value from the other any, as the value type need not be
+  // CopyConstructible; the other any keeps the moved-from value
+  any(const any& other_) : m_handler(nullptr)
+  {
+    if (other_.m_handler != nullptr)
+    {
+      other_.m_handler->clone(const_cast<any&>(other_), *this);
+      m_handler = other_.m_handler;
+    }
+  }
   any& operator =(const any& other_)
   {
     any(other_).swap(*this);
     return *this;
   };
+  ~any()
+  { clear(); }
 
   // -- observers
   bool empty() const
-  { return static_cast<bool>(m_value); }
+  { return m_handler == nullptr; }
 
   // -- modifiers
   any& swap(any& other_)
-  { std::swap(m_value, other_.m_value); return *this; }
+  {
+    any aux(std::move(other_));
+    other_ = std::move(*this);
+    *this = std::move(aux);
+    return *this;
+  }
   void clear()
-  { m_value.reset(); }
+  {
+    if (m_handler != nullptr)
+    {
+      m_handler->destroy(*this);
+      m_handler = nullptr;
+    }
+  }
 
  private:
+  template <typename T, typename ArgT>
+  void create(ArgT&& v_)
+  {
+    manager<T>::create(*this, std::forward<ArgT>(v_));
+    m_handler = &manager<T>::table;
+  }
+  void take(any& other_)
+  {
+    if (other_.m_handler != nullptr)
+    {
+      other_.m_handler->transfer(other_, *this);
+      m_handler = other_.m_handler;
+      other_.m_handler = nullptr;
+    }
+  }
+
   template <typename T>
   friend T* any_cast(any*);
-  std::unique_ptr<valueholder> m_value;
+
+  const handler* m_handler;   // nullptr if empty
+  union
+  {
+    buffer m_buffer;
+    void*  m_pointer;
+  };
+};
+
+template <typename T, bool Inline>
+const any::handler any::manager<T, Inline>::table = {
+    &any::manager<T, Inline>::type
+  , &any::manager<T, Inline>::destroy
+  , &any::manager<T, Inline>::transfer
+  , &any::manager<T, Inline>::clone
+};
+
+template <typename T>
+const any::handler any::manager<T, false>::table = {
+    &any::manager<T, false>::type
+  , &any::manager<T, false>::destroy
+  , &any::manager<T, false>::transfer
+  , &any::manager<T, false>::clone
 };
 
+// the handler addresses are compared first; the type_info comparison is
+// only needed if the any was filled in another module, which has its own
+// copy of the handler
 template <typename T> inline T* any_cast(any* v_)
 {
-  return v_ != nullptr && v_->m_value->type() == typeid(T)
-    ? &static_cast<any::value<typename std::remove_cv<T>::type>*>(v_->m_value.get())->m_v
-    : 0;
+  using value_type = typename std::remove_cv<T>::type;
+  using manager_type = any::manager<value_type>;
+
+  if (v_ == nullptr || v_->m_handler == nullptr)
+    return nullptr;
+  if (v_->m_handler != &manager_type::table && v_->m_handler->type() != typeid(value_type))
+    return nullptr;
+  return manager_type::get(*v_);
 }
 
 template <typename T> inline const T* any_cast(const any* v_)
@@ -249,6 +368,23 @@ ResultT invoke_callable(const std::shared_ptr<RunnerT>& runner_, const FunctionT
   >::apply(runner_, callable_, params_);
 }
 
+//
+// COMPILE TIME INDEX SEQUENCE, a C++11 replacement for std::index_sequence
+//
+template <std::size_t... I>
+struct indices
+{ };
+
+template <std::size_t N, std::size_t... I>
+struct make_indices : make_indices<N - 1, N - 1, I...>
+{ };
+
+template <std::size_t... I>
+struct make_indices<0, I...>
+{
+  using type = indices<I...>;
+};
+
 } // namespace helpers
 
 
@@ -296,20 +432,88 @@ public:
   }
 };
 
+// ---- ----
+// ---- Callback that never allocates - a pointer to a function and a pointer
+// ---- to the object passed to the function as its first parameter. Used to
+// ---- connect the child contexts to their parents, which would otherwise
+// ---- cost a std::function with a bound member function, usually allocated
+// ---- on the heap, for each child context.
+// ---- ----
+template <typename... ArgT>
+class callback
+{
+ public:
+  using function_type = void (*)(void*, ArgT...);
+
+ public:
+  callback() : m_function(nullptr), m_object(nullptr)
+  { /* noop */ }
+  callback(function_type function_, void* object_) : m_function(function_), m_object(object_)
+  { /* noop */ }
+
+  // callback that calls the member function MethodT of the object_
+  template <typename T, void (T::*MethodT)(ArgT...)>
+  static callback bind(T* object_)
+  {
+    return callback(&call<T, MethodT>, object_);
+  }
+
+  explicit operator bool() const
+  {
+    return m_function != nullptr;
+  }
+  void operator ()(ArgT... args_) const
+  {
+    m_function(m_object, std::forward<ArgT>(args_)...);
+  }
+
+ private:
+  template <typename T, void (T::*MethodT)(ArgT...)>
+  static void call(void* object_, ArgT... args_)
+  {
+    (static_cast<T*>(object_)->*MethodT)(std::forward<ArgT>(args_)...);
+  }
+
+ private:
+  function_type m_function;
+  void*         m_object;
+};
+
 // ==== =====
 // ====
 // ==== Runtime task information (execution context) interfaces
 // ====
 // ==== ====
+class context_stack;
+
 class context
 {
 public:
-  using result_reporter    = std::function<void(const any&)>;
-  using exception_reporter = std::function<void(const std::exception_ptr&)>;
+  using result_reporter    = callback<const any&>;
+  using exception_reporter = callback<const std::exception_ptr&>;
 
 public:
   virtual ~context() { /* noop */ }
 
+  // contexts are allocated from the context stack they will run on, if given,
+  // and from the heap otherwise
+  static void* operator new(std::size_t size_)
+  {
+    return allocate(nullptr, size_);
+  }
+  static void* operator new(std::size_t size_, context_stack* stack_)
+  {
+    return allocate(stack_, size_);
+  }
+  static void operator delete(void* p_, std::size_t size_)
+  {
+    release(p_, size_);
+  }
+  static void operator delete(void* p_, context_stack*)
+  {
+    release(p_, 0);
+  }
+
   // returns pointer to runner that is supposed to execute this context
   virtual std::weak_ptr<async::runner> get_runner() const = 0;
   // entry point to this context; to enter when context starts execute
@@ -322,6 +526,19 @@ public:
   virtual void set_input(const any&) = 0;
   virtual void set_res_reporter(const result_reporter& arg_) = 0;
   virtual void set_exc_reporter(const exception_reporter& arg_) = 0;
+  // returns the exception reporter, empty if not set
+  virtual exception_reporter get_exc_reporter() const = 0;
+
+ private:
+  // each block starts with the header that remembers where the block is from
+  union header
+  {
+    context_stack*  m_stack;
+    std::max_align_t m_align;
+  };
+
+  static void* allocate(context_stack* stack_, std::size_t size_);
+  static void release(void* p_, std::size_t size_);
 };
 
 // ---- execution context stack interface
@@ -330,11 +547,21 @@ public:
 class context_stack : public  work
 {
  public:
+  context_stack()
+    : m_urgency(Urgency::NORMAL)
+    , m_deadline(std::chrono::steady_clock::time_point::max())
+  { /* noop */ }
   work_type type() const override
   {
     return work_type::task_work;
   }
   virtual ~context_stack() { /* noop */ }
+  // urgency of the task, kept for all runners the context stack visits
+  Urgency urgency() const           { return m_urgency; }
+  void urgency(Urgency arg_)        { m_urgency = arg_; }
+  // deadline of the task, time_point::max() if none
+  const std::chrono::steady_clock::time_point& deadline() const   { return m_deadline; }
+  void deadline(const std::chrono::steady_clock::time_point& arg_) { m_deadline = arg_; }
   // pushes new context to the top of the stack
   virtual void push(context*) = 0;
   // returns top of the stack
@@ -343,8 +570,38 @@ class context_stack : public  work
   virtual context* pop() = 0;
   // returns true if stack is empty
   virtual bool empty() const = 0;
+  // allocates the memory for the context that will run on this stack; the
+  // contexts are released in roughly the reverse order of their allocation
+  // and always before the stack itself is destroyed
+  virtual void* allocate(std::size_t size_)          { return ::operator new(size_); }
+  // releases the memory allocated by allocate(); the size_ may be 0 if unknown
+  virtual void deallocate(void* p_, std::size_t)     { ::operator delete(p_); }
+
+ private:
+  Urgency m_urgency;
+  std::chrono::steady_clock::time_point m_deadline;
 };
 
+inline void* context::allocate(context_stack* stack_, std::size_t size_)
+{
+  size_ += sizeof(header);
+  auto h = static_cast<header*>(stack_ == nullptr ? ::operator new(size_) : stack_->allocate(size_));
+  h->m_stack = stack_;
+  return h + 1;
+}
+
+inline void context::release(void* p_, std::size_t size_)
+{
+  if (p_ == nullptr)
+    return;
+
+  auto h = static_cast<header*>(p_) - 1;
+  if (h->m_stack == nullptr)
+    ::operator delete(h);
+  else
+    h->m_stack->deallocate(h, size_ == 0 ? 0 : size_ + sizeof(header));
+}
+
 
 // ==== =====
 // ====
@@ -372,6 +629,10 @@ class task_context_base : public context
   {
     m_exc_reporter = arg_;
   }
+  exception_reporter get_exc_reporter() const override
+  {
+    return m_exc_reporter;
+  }
   void set_input(const any& input_) override
   {
 //    m_input = input_;
@@ -269,12 +269,12 @@ class task_context<tag::intercept, RunnerT, InputT, ResultT>
     , const typename task_type::catch_vector_type& catchers_
     , const any& input_)
   {
-    auto aux = new this_type(stack_, task_, catchers_);
+    auto aux = new (stack_) this_type(stack_, task_, catchers_);
     stack_->push(aux);
 
     auto sub_ctx = subtask_->create_context(stack_, subtask_, input_);
-    sub_ctx->set_res_reporter(std::bind(&this_type::result_report, aux, std::placeholders::_1));
-    sub_ctx->set_exc_reporter(std::bind(&this_type::exception_report, aux, std::placeholders::_1));
+    sub_ctx->set_res_reporter(result_reporter::bind<this_type, &this_type::result_report>(aux));
+    sub_ctx->set_exc_reporter(exception_reporter::bind<this_type, &this_type::exception_report>(aux));
 
     return aux;
   }
@@ -317,8 +317,8 @@ class task_context<tag::intercept, RunnerT, InputT, ResultT>
       if (m_catchers[i]->try_catch(
           e_
         , m_stack
-        , std::bind(&this_type::result_report, this, std::placeholders::_1)
-        , std::bind(&this_type::final_exception_report, this, std::placeholders::_1)))
+        , result_reporter::bind<this_type, &this_type::result_report>(this)
+        , exception_reporter::bind<this_type, &this_type::final_exception_report>(this)))
       {
         // exception was caught and it's processing pushed to execution stack
         return;
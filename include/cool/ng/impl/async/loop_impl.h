@@ -117,7 +117,7 @@ class task_context<tag::loop, default_runner_type, InputT, ResultT>
     , const std::shared_ptr<task>& task_
     , const any& input_)
   {
-    auto aux = new this_type(stack_, task_);
+    auto aux = new (stack_) this_type(stack_, task_);
     stack_->push(aux);
 
     aux->set_input(input_);
@@ -177,8 +177,8 @@ class task_context<tag::loop, default_runner_type, InputT, ResultT>
       return false;
 
     auto ctx = t_->create_context(m_stack, t_, m_input);
-    ctx->set_res_reporter(std::bind(&this_type::body_result_report, this, std::placeholders::_1));
-    ctx->set_exc_reporter(std::bind(&this_type::exception_report, this, std::placeholders::_1));
+    ctx->set_res_reporter(result_reporter::bind<this_type, &this_type::body_result_report>(this));
+    ctx->set_exc_reporter(exception_reporter::bind<this_type, &this_type::exception_report>(this));
     return true;
   }
 
@@ -186,8 +186,8 @@ class task_context<tag::loop, default_runner_type, InputT, ResultT>
   {
     auto t_ = m_task->get_subtask(0);
     auto ctx = t_->create_context(m_stack, t_, m_input);
-    ctx->set_res_reporter(std::bind(&this_type::predicate_result_report, this, std::placeholders::_1));
-    ctx->set_exc_reporter(std::bind(&this_type::exception_report, this, std::placeholders::_1));
+    ctx->set_res_reporter(result_reporter::bind<this_type, &this_type::predicate_result_report>(this));
+    ctx->set_exc_reporter(exception_reporter::bind<this_type, &this_type::exception_report>(this));
   }
 
  private:
@@ -79,7 +79,7 @@ class task_context<tag::repeat, default_runner_type, std::size_t, ResultT>
     , const std::shared_ptr<task>& task_
     , const std::size_t& input_)
   {
-    auto aux = new this_type(stack_, task_, input_);
+    auto aux = new (stack_) this_type(stack_, task_, input_);
     stack_->push(aux);
 
     aux->set_input(input_);
@@ -130,8 +130,8 @@ class task_context<tag::repeat, default_runner_type, std::size_t, ResultT>
   void prepare_next_task(const std::shared_ptr<task>& t_)
   {
     auto ctx = t_->create_context(m_stack, t_, m_counter);
-    ctx->set_res_reporter(std::bind(&this_type::result_report, this, std::placeholders::_1));
-    ctx->set_exc_reporter(std::bind(&this_type::exception_report, this, std::placeholders::_1));
+    ctx->set_res_reporter(result_reporter::bind<this_type, &this_type::result_report>(this));
+    ctx->set_exc_reporter(exception_reporter::bind<this_type, &this_type::exception_report>(this));
   }
 
 private:
@@ -27,207 +27,634 @@
 
 // ---- -----------------------------------------------------------------------
 // ----
-// ---- Static task information
+// ---- Statically typed sequence
+// ----
+// ---- The result of each subtask is passed to the next subtask as its
+// ---- concrete type, through the chain of links built when the sequence is
+// ---- created. The link of each subtask knows the link of the next subtask,
+// ---- or, for the last subtask, the sequence context, and the result
+// ---- reporters are kept with the links, hence the values are neither boxed
+// ---- into any nor checked at run time.
 // ----
 // ---- -----------------------------------------------------------------------
 
-template <typename InputT, typename ResultT>
-class taskinfo<tag::sequential, default_runner_type, InputT, ResultT> : public base::taskinfo<InputT, ResultT>
+// common part of the sequence contexts
+class x_sequence_context : public task_context_base
 {
  public:
-  using tag           = tag::sequential;
-  using this_type     = taskinfo;
-  using runner_type   = default_runner_type;
-  using result_type   = ResultT;
-  using input_type    = InputT;
-  using context_type  = task_context<tag, runner_type, input_type, result_type>;
+  x_sequence_context(context_stack* stack_, const std::shared_ptr<task>& task_, context* parent_)
+    : task_context_base(stack_, task_), m_parent(parent_)
+  { /* noop */ }
+
+  std::weak_ptr<async::runner> get_runner() const override
+  {
+    return m_task->get_runner();
+  }
+  const char* name() const override
+  {
+    return "context::sequential";
+  }
+  bool will_execute() const override
+  {
+    return false;
+  }
 
-  using subtasks_vector_type = std::vector<std::shared_ptr<detail::task>>;
+  context_stack* stack() const
+  {
+    return m_stack;
+  }
+  // the subtask failed; the sequence ends and reports the exception
+  void fail(const std::exception_ptr& e_)
+  {
+    auto reporter = m_exc_reporter;
+    m_stack->pop();
+    delete this;
+    if (reporter)
+      reporter(e_);
+  }
 
+ protected:
+  context* m_parent;    // context to report the result to, if any
+};
+
+template <typename ResultT>
+class context_impl<tag::sequential, default_runner_type, ResultT> : public x_sequence_context
+{
  public:
-#if !defined(WINDOWS_TARGET) || (_MSC_VER > 1800)
-  template <typename... TaskT>
-  explicit inline taskinfo(const std::shared_ptr<TaskT>&... tasks_)
-      : m_subtasks( { tasks_ ... } )
-  { /* noop */ }
-#else
-  // Visual Studio 2013 has hickups with the above arg pack ctor - it
-  // requires separate ctors for each number of arguments. Hence a sequence of
-  // up to 5 tasks is supported
-  template <
-      typename T1
-    , typename T2
-  > explicit inline taskinfo(
-      const std::shared_ptr<T1>& t1
-    , const std::shared_ptr<T2>& t2)
-  {
-    m_subtasks.push_back(t1);
-    m_subtasks.push_back(t2);
-  }
-  template <
-      typename T1
-    , typename T2
-    , typename T3
-  > explicit inline taskinfo(
-      const std::shared_ptr<T1>& t1
-    , const std::shared_ptr<T2>& t2
-    , const std::shared_ptr<T3>& t3)
-  {
-    m_subtasks.push_back(t1);
-    m_subtasks.push_back(t2);
-    m_subtasks.push_back(t3);
-  }
-  template <
-      typename T1
-    , typename T2
-    , typename T3
-    , typename T4
-  > explicit inline taskinfo(
-      const std::shared_ptr<T1>& t1
-    , const std::shared_ptr<T2>& t2
-    , const std::shared_ptr<T3>& t3
-    , const std::shared_ptr<T4>& t4)
-  {
-    m_subtasks.push_back(t1);
-    m_subtasks.push_back(t2);
-    m_subtasks.push_back(t3);
-    m_subtasks.push_back(t4);
-  }
-  template <
-      typename T1
-    , typename T2
-    , typename T3
-    , typename T4
-    , typename T5
-  > explicit inline taskinfo(
-      const std::shared_ptr<T1>& t1
-    , const std::shared_ptr<T2>& t2
-    , const std::shared_ptr<T3>& t3
-    , const std::shared_ptr<T4>& t4
-    , const std::shared_ptr<T5>& t5)
-  {
-    m_subtasks.push_back(t1);
-    m_subtasks.push_back(t2);
-    m_subtasks.push_back(t3);
-    m_subtasks.push_back(t4);
-    m_subtasks.push_back(t5);
+  using this_type            = context_impl;
+  using result_reporter_type = typename helpers::get_result_reporter<ResultT>::type;
+
+  static this_type* create(
+      context_stack* stack_
+    , const std::shared_ptr<task>& task_
+    , context* parent_
+    , const result_reporter_type& reporter_)
+  {
+    auto aux = new (stack_) this_type(stack_, task_, parent_, reporter_);
+    stack_->push(aux);
+    return aux;
   }
-#endif
-  inline context* create_context(
+
+  // the last subtask completed
+  void finish(const ResultT& res_)
+  {
+    auto reporter = m_reporter;
+    auto parent = m_parent;
+    m_stack->pop();
+    delete this;
+    if (reporter)
+      reporter(parent, res_);
+  }
+
+ private:
+  context_impl(context_stack* stack_, const std::shared_ptr<task>& task_, context* parent_, const result_reporter_type& reporter_)
+    : x_sequence_context(stack_, task_, parent_), m_reporter(reporter_)
+  { /* noop */ }
+
+ private:
+  const result_reporter_type m_reporter;
+};
+
+template <>
+class context_impl<tag::sequential, default_runner_type, void> : public x_sequence_context
+{
+ public:
+  using this_type            = context_impl;
+  using result_reporter_type = helpers::get_result_reporter<void>::type;
+
+  static this_type* create(
       context_stack* stack_
-    , const std::shared_ptr<task>& self_
-    , const any& input_) const override
+    , const std::shared_ptr<task>& task_
+    , context* parent_
+    , const result_reporter_type& reporter_)
   {
-    auto aux = context_type::create(stack_, self_, input_);
+    auto aux = new (stack_) this_type(stack_, task_, parent_, reporter_);
+    stack_->push(aux);
     return aux;
   }
 
-  inline std::weak_ptr<runner> get_runner() const override
+  // the last subtask completed
+  void finish()
+  {
+    auto reporter = m_reporter;
+    auto parent = m_parent;
+    m_stack->pop();
+    delete this;
+    if (reporter)
+      reporter(parent);
+  }
+
+ private:
+  context_impl(context_stack* stack_, const std::shared_ptr<task>& task_, context* parent_, const result_reporter_type& reporter_)
+    : x_sequence_context(stack_, task_, parent_), m_reporter(reporter_)
+  { /* noop */ }
+
+ private:
+  const result_reporter_type m_reporter;
+};
+
+// result reporters of the sequence subtasks, either passing the result to the
+// next subtask or completing the sequence
+template <typename ResultT>
+struct x_sequence_reporter
+{
+  using type      = typename helpers::get_result_reporter<ResultT>::type;
+  using link_type = typename x_link_for<ResultT>::type;
+
+  static type to_next(const link_type* next_)
+  {
+    return type(&next, const_cast<link_type*>(next_));
+  }
+  static type to_end()
+  {
+    return type(&end, nullptr);
+  }
+
+ private:
+  static void next(void* next_, context* seq_, const ResultT& res_)
+  {
+    static_cast<const link_type*>(next_)->start(static_cast<x_sequence_context*>(seq_)->stack(), seq_, res_);
+  }
+  static void end(void*, context* seq_, const ResultT& res_)
+  {
+    static_cast<context_impl<tag::sequential, default_runner_type, ResultT>*>(seq_)->finish(res_);
+  }
+};
+
+template <>
+struct x_sequence_reporter<void>
+{
+  using type      = helpers::get_result_reporter<void>::type;
+  using link_type = x_link_for<void>::type;
+
+  static type to_next(const link_type* next_)
+  {
+    return type(&next, const_cast<link_type*>(next_));
+  }
+  static type to_end()
+  {
+    return type(&end, nullptr);
+  }
+
+ private:
+  static void next(void* next_, context* seq_)
+  {
+    static_cast<const link_type*>(next_)->start(static_cast<x_sequence_context*>(seq_)->stack(), seq_);
+  }
+  static void end(void*, context* seq_)
+  {
+    static_cast<context_impl<tag::sequential, default_runner_type, void>*>(seq_)->finish();
+  }
+};
+
+// link of the subtask of type TaskT
+template <typename TaskT, typename LinkT = typename TaskT::link_type>
+class x_sequence_step
+{ /* noop default template */ };
+
+template <typename TaskT, typename... InputT>
+class x_sequence_step<TaskT, x_link<InputT...>> : public x_link<InputT...>
+{
+ public:
+  using result_reporter_type = typename TaskT::result_reporter_type;
+
+  x_sequence_step(const std::shared_ptr<TaskT>& task_, const result_reporter_type& reporter_)
+    : m_task(task_), m_reporter(reporter_)
+  { /* noop */ }
+
+  void start(context_stack* stack_, context* parent_, const InputT&... input_) const override
+  {
+    auto ctx = m_task->create_context(stack_, m_task, parent_, m_reporter, input_...);
+    ctx->set_exc_reporter(context::exception_reporter::bind<
+        x_sequence_context, &x_sequence_context::fail>(static_cast<x_sequence_context*>(parent_)));
+  }
+
+ private:
+  std::shared_ptr<TaskT> m_task;
+  result_reporter_type   m_reporter;
+};
+
+template <typename ResultT, typename... InputT>
+class x_taskinfo<tag::sequential, default_runner_type, ResultT, InputT...> : public task
+{
+ public:
+  using this_type            = x_taskinfo;
+  using runner_type          = default_runner_type;
+  using result_type          = ResultT;
+  using result_reporter_type = typename helpers::get_result_reporter<ResultT>::type;
+  using context_type         = context_impl<tag::sequential, default_runner_type, ResultT>;
+  using link_type            = x_link<InputT...>;
+
+ public:
+  template <typename... TaskT>
+  explicit x_taskinfo(const std::shared_ptr<TaskT>&... tasks_)
+  {
+    m_first = chain(tasks_...);
+  }
+
+  std::weak_ptr<runner> get_runner() const override
+  {
+    return m_runner;
+  }
+
+  // type erased input must carry std::tuple<InputT...>
+  context* create_context(
+        context_stack* stack_
+      , const std::shared_ptr<task>& self_
+      , const any& input_) const override
+  {
+    return create_context(
+        stack_
+      , self_
+      , any_cast<const std::tuple<InputT...>&>(input_)
+      , typename helpers::make_indices<sizeof...(InputT)>::type());
+  }
+
+  // creates the context that reports the result to the parent_ context
+  context* create_context(
+        context_stack* stack_
+      , const std::shared_ptr<task>& self_
+      , context* parent_
+      , const result_reporter_type& reporter_
+      , const InputT&... input_) const
+  {
+    auto ctx = context_type::create(stack_, self_, parent_, reporter_);
+    m_first->start(stack_, ctx, input_...);
+    return ctx;
+  }
+
+  void run(
+      const std::shared_ptr<this_type>& self_
+    , const InputT&... input_
+    , Urgency urgency_ = Urgency::NORMAL
+    , const runner::clock::time_point& deadline_ = runner::clock::time_point::max()) const
   {
-    return m_subtasks[0]->get_runner();
+    auto stack = new default_task_stack();
+    stack->urgency(urgency_);
+    stack->deadline(deadline_);
+    create_context(stack, self_, nullptr, result_reporter_type(), input_...);
+    kickstart(stack);
   }
 
-  inline std::size_t get_subtask_count() const override
+ private:
+  template <std::size_t... I>
+  context* create_context(
+        context_stack* stack_
+      , const std::shared_ptr<task>& self_
+      , const std::tuple<InputT...>& input_
+      , helpers::indices<I...>) const
   {
-    return m_subtasks.size();
+    return create_context(stack_, self_, nullptr, result_reporter_type(), std::get<I>(input_)...);
   }
 
-  inline std::shared_ptr<task> get_subtask(std::size_t index) const override
+  // builds the links from the last subtask to the first
+  template <typename TaskT>
+  const typename TaskT::link_type* chain(const std::shared_ptr<TaskT>& task_)
   {
-    return m_subtasks[index];
+    static_assert(
+        std::is_same<typename TaskT::result_type, ResultT>::value
+      , "The result type of the sequence must be the result type of its last task.");
+
+    m_runner = task_->get_runner();
+    auto aux = new x_sequence_step<TaskT>(task_, x_sequence_reporter<ResultT>::to_end());
+    m_links.emplace_back(aux);
+    return aux;
+  }
+
+  template <typename TaskT, typename NextT, typename... TaskTs>
+  const typename TaskT::link_type* chain(
+      const std::shared_ptr<TaskT>& task_
+    , const std::shared_ptr<NextT>& next_
+    , const std::shared_ptr<TaskTs>&... tasks_)
+  {
+    static_assert(
+        std::is_same<typename NextT::link_type, typename x_link_for<typename TaskT::result_type>::type>::value
+      , "The parameter type of each task in the sequence must match the return type of the preceding task.");
+
+    auto next = chain(next_, tasks_...);
+    m_runner = task_->get_runner();
+    auto aux = new x_sequence_step<TaskT>(task_, x_sequence_reporter<typename TaskT::result_type>::to_next(next));
+    m_links.emplace_back(aux);
+    return aux;
   }
 
  private:
-  subtasks_vector_type m_subtasks;
+  std::vector<std::unique_ptr<x_link_base>> m_links;
+  const link_type*                          m_first;   // link of the first subtask
+  std::weak_ptr<runner>                     m_runner;  // runner of the first subtask
 };
 
 // ---- -----------------------------------------------------------------------
 // ----
-// ---- Runtime task context
+// ---- Fused sequence
+// ----
+// ---- The sequence of simple tasks of the same runner type is fused into a
+// ---- single task with a single context. The context calls the callables of
+// ---- the subtasks back-to-back and keeps their results in a tuple within the
+// ---- context itself, without the subtask contexts, the links and the result
+// ---- reporters. The runners of the subtasks are still checked at run time;
+// ---- if the next subtask runs on another runner, the context stays on the
+// ---- top of the stack, its runner becomes the runner of the next subtask,
+// ---- and the context stack is passed to that runner as usual.
 // ----
 // ---- -----------------------------------------------------------------------
-template <typename RunnerT, typename InputT, typename ResultT>
-class task_context<tag::sequential, RunnerT, InputT, ResultT>
-  : public task_context_base
+
+namespace helpers {
+
+// input of the I-th subtask of the fused sequence; the sequence input for the
+// first and the result of the preceding subtask for all others
+template <std::size_t I>
+struct step_input
 {
- public:
-  using this_type  = task_context;
-  using base       = task_context_base;
+  template <typename InputT, typename ResultsT>
+  static auto get(const InputT&, const ResultsT& results_) -> decltype(std::get<I - 1>(results_).as_input())
+  {
+    return std::get<I - 1>(results_).as_input();
+  }
+};
+template <>
+struct step_input<0>
+{
+  template <typename InputT, typename ResultsT>
+  static const InputT& get(const InputT& input_, const ResultsT&)
+  {
+    return input_;
+  }
+};
 
- private:
-  inline task_context(context_stack* st_, const std::shared_ptr<task>& t_)
-    : base(st_, t_), m_next_task(0), m_num_tasks(t_->get_subtask_count())
-  { /* noop */ }
+// is_fusable<TaskT...>::value is true if all tasks are simple tasks of the
+// same runner type
+template <typename RunnerT, typename TaskT>
+struct is_simple_on : public std::false_type
+{ };
+template <typename RunnerT, typename ResultT, typename... InputT>
+struct is_simple_on<RunnerT, x_taskinfo<tag::simple, RunnerT, ResultT, InputT...>> : public std::true_type
+{ };
+
+template <typename RunnerT, typename... TaskT>
+struct all_simple_on : public std::true_type
+{ };
+template <typename RunnerT, typename TaskT, typename... TaskTs>
+struct all_simple_on<RunnerT, TaskT, TaskTs...> : public std::integral_constant<bool,
+       is_simple_on<RunnerT, TaskT>::value
+    && all_simple_on<RunnerT, TaskTs...>::value>
+{ };
+
+template <typename TaskT, typename... TaskTs>
+struct is_fusable : public all_simple_on<typename TaskT::runner_type, TaskT, TaskTs...>
+{ };
+
+// is_x_chain<TaskT...>::value is true if each task accepts the result of the
+// preceding task
+template <typename... TaskT>
+struct is_x_chain : public std::true_type
+{ };
+template <typename TaskT, typename NextT, typename... TaskTs>
+struct is_x_chain<TaskT, NextT, TaskTs...> : public std::integral_constant<bool,
+       std::is_same<typename NextT::link_type, typename x_link_for<typename TaskT::result_type>::type>::value
+    && is_x_chain<NextT, TaskTs...>::value>
+{ };
+
+} // namespace helpers
+
+template <typename LinkT, typename... TaskT>
+class x_fused_taskinfo
+{ /* noop default template */ };
 
+template <typename LinkT, typename... TaskT>
+class x_fused_context
+{ /* noop default template */ };
+
+template <typename... InputT, typename... TaskT>
+class x_fused_context<x_link<InputT...>, TaskT...> : public task_context_base
+{
  public:
-  inline static this_type* create(
+  using this_type            = x_fused_context;
+  using task_type            = x_fused_taskinfo<x_link<InputT...>, TaskT...>;
+  using runner_type          = typename task_type::runner_type;
+  using result_reporter_type = typename task_type::result_reporter_type;
+
+  static this_type* create(
       context_stack* stack_
     , const std::shared_ptr<task>& task_
-    , const any& input_)
+    , context* parent_
+    , const result_reporter_type& reporter_
+    , const InputT&... input_)
   {
-    auto aux = new this_type(stack_, task_);
+    auto aux = new (stack_) this_type(stack_, task_, parent_, reporter_, input_...);
     stack_->push(aux);
-
-    aux->set_input(input_);
-    aux->prepare_next_task();
-
     return aux;
   }
 
-  // context interface
-  inline std::weak_ptr<async::runner> get_runner() const override
+  // the runner of the subtask to run next
+  std::weak_ptr<async::runner> get_runner() const override
   {
-    return m_task->get_runner();
+    return get_task()->get_runner(m_step);
   }
   const char* name() const override
   {
-    return "context::sequential";
+    return "context::fused";
   }
   bool will_execute() const override
   {
-    return m_next_task < m_num_tasks;
+    return true;
   }
 
-  void result_report(const any& res_)
+  void entry_point(const std::shared_ptr<async::runner>& r_, context*) override
   {
-    if (m_next_task == m_num_tasks)
+    try
     {
-      m_stack->pop();
-      if (m_res_reporter)
-        m_res_reporter(res_);
-      delete this;
+      auto runner = std::dynamic_pointer_cast<runner_type>(r_);
+      if (!runner)
+        throw exception::bad_runner_cast();
+
+      run_from(runner, std::integral_constant<std::size_t, 0>());
+      if (m_step < sizeof...(TaskT))
+        return;   // the next subtask runs on another runner
     }
-    else
+    catch (...)
     {
-      m_input = res_;
-      prepare_next_task();
+      m_stack->pop();
+      if (m_exc_reporter)
+        m_exc_reporter(std::current_exception());
+      delete this;
+      return;
     }
-  }
 
-  void exception_report(const std::exception_ptr& e)
-  {
     m_stack->pop();
-    if (m_exc_reporter)
-      m_exc_reporter(e);
+    std::get<sizeof...(TaskT) - 1>(m_results).report(m_reporter, m_parent);
     delete this;
   }
 
-  bool prepare_next_task()
+ private:
+  x_fused_context(
+      context_stack* stack_
+    , const std::shared_ptr<task>& task_
+    , context* parent_
+    , const result_reporter_type& reporter_
+    , const InputT&... input_)
+    : task_context_base(stack_, task_)
+    , m_input(input_...)
+    , m_step(0)
+    , m_parent(parent_)
+    , m_reporter(reporter_)
+  { /* noop */ }
+
+  const task_type* get_task() const
   {
-    if (m_next_task < m_num_tasks)
+    return static_cast<const task_type*>(m_task.get());
+  }
+
+  // runs the subtasks from the I-th on, for as long as they run on the runner r_
+  template <std::size_t I>
+  void run_from(const std::shared_ptr<runner_type>& r_, std::integral_constant<std::size_t, I>)
+  {
+    if (m_step == I)
     {
-      auto t_ = m_task->get_subtask(m_next_task);
-      auto ctx = t_->create_context(m_stack, t_, m_input);
-      ctx->set_res_reporter(std::bind(&this_type::result_report, this, std::placeholders::_1));
-      ctx->set_exc_reporter(std::bind(&this_type::exception_report, this, std::placeholders::_1));
-      m_next_task++;
-      return true;
+      std::get<I>(m_results).invoke(
+          r_
+        , std::get<I>(get_task()->functions())
+        , helpers::step_input<I>::get(m_input, m_results));
+      if (++m_step == sizeof...(TaskT) || !get_task()->runs_on(m_step, r_))
+        return;
     }
-    return false;
+    run_from(r_, std::integral_constant<std::size_t, I + 1>());
+  }
+  void run_from(const std::shared_ptr<runner_type>&, std::integral_constant<std::size_t, sizeof...(TaskT)>)
+  { /* noop */ }
+
+ private:
+  std::tuple<InputT...>                                        m_input;
+  std::tuple<helpers::result_slot<typename TaskT::result_type>...> m_results;
+  std::size_t                                                  m_step;      // subtask to run next
+  context*                                                     m_parent;    // context to report the result to, if any
+  const result_reporter_type                                   m_reporter;
+};
+
+template <typename... InputT, typename... TaskT>
+class x_fused_taskinfo<x_link<InputT...>, TaskT...> : public task
+{
+ public:
+  using this_type            = x_fused_taskinfo;
+  using runner_type          = typename traits::get_first<TaskT...>::type::runner_type;
+  using result_type          = typename traits::get_sequence_result_type<TaskT...>::type;
+  using result_reporter_type = typename helpers::get_result_reporter<result_type>::type;
+  using context_type         = x_fused_context<x_link<InputT...>, TaskT...>;
+  using link_type            = x_link<InputT...>;
+
+  static_assert(
+      helpers::is_fusable<TaskT...>::value
+    , "Only the simple tasks of the same runner type can be fused.");
+  static_assert(
+      helpers::is_x_chain<TaskT...>::value
+    , "The parameter type of each task in the sequence must match the return type of the preceding task.");
+
+ public:
+  explicit x_fused_taskinfo(const std::shared_ptr<TaskT>&... tasks_)
+    : m_functions(tasks_->function()...)
+    , m_runners{{ tasks_->get_runner()... }}
+  { /* noop */ }
+
+  std::weak_ptr<runner> get_runner() const override
+  {
+    return m_runners[0];
+  }
+  std::weak_ptr<runner> get_runner(std::size_t step_) const
+  {
+    return m_runners[step_];
+  }
+  // true if the subtask step_ runs on the runner r_
+  bool runs_on(std::size_t step_, const std::shared_ptr<runner>& r_) const
+  {
+    return !m_runners[step_].owner_before(r_) && !r_.owner_before(m_runners[step_]);
+  }
+  const std::tuple<typename TaskT::function_type...>& functions() const
+  {
+    return m_functions;
+  }
+
+  // type erased input must carry std::tuple<InputT...>
+  context* create_context(
+        context_stack* stack_
+      , const std::shared_ptr<task>& self_
+      , const any& input_) const override
+  {
+    return create_context(
+        stack_
+      , self_
+      , any_cast<const std::tuple<InputT...>&>(input_)
+      , typename helpers::make_indices<sizeof...(InputT)>::type());
+  }
+
+  // creates the context that reports the result to the parent_ context
+  context* create_context(
+        context_stack* stack_
+      , const std::shared_ptr<task>& self_
+      , context* parent_
+      , const result_reporter_type& reporter_
+      , const InputT&... input_) const
+  {
+    return context_type::create(stack_, self_, parent_, reporter_, input_...);
+  }
+
+  void run(
+      const std::shared_ptr<this_type>& self_
+    , const InputT&... input_
+    , Urgency urgency_ = Urgency::NORMAL
+    , const runner::clock::time_point& deadline_ = runner::clock::time_point::max()) const
+  {
+    auto stack = new default_task_stack();
+    stack->urgency(urgency_);
+    stack->deadline(deadline_);
+    create_context(stack, self_, nullptr, result_reporter_type(), input_...);
+    kickstart(stack);
   }
 
  private:
-  std::size_t       m_next_task;
-  const std::size_t m_num_tasks;
+  template <std::size_t... I>
+  context* create_context(
+        context_stack* stack_
+      , const std::shared_ptr<task>& self_
+      , const std::tuple<InputT...>& input_
+      , helpers::indices<I...>) const
+  {
+    return create_context(stack_, self_, nullptr, result_reporter_type(), std::get<I>(input_)...);
+  }
+
+ private:
+  std::tuple<typename TaskT::function_type...>       m_functions;
+  std::array<std::weak_ptr<runner>, sizeof...(TaskT)> m_runners;
+};
+
+// ---- Selects the implementation of the sequence of tasks TaskT...; the fused
+// ---- sequence if possible, the statically typed sequence otherwise
+template <typename ResultT, typename LinkT>
+struct x_sequential_for
+{ /* noop default template */ };
+template <typename ResultT, typename... InputT>
+struct x_sequential_for<ResultT, x_link<InputT...>>
+{
+  using type = x_taskinfo<tag::sequential, default_runner_type, ResultT, InputT...>;
 };
 
+template <typename... TaskT>
+struct x_sequence
+{
+  static_assert(
+      sizeof...(TaskT) > 1
+    , "It takes at least two tasks to create a sequential compound task");
+
+  using first_type = typename traits::get_first<TaskT...>::type;
+  using type = typename std::conditional<
+      helpers::is_fusable<TaskT...>::value
+    , x_fused_taskinfo<typename first_type::link_type, TaskT...>
+    , typename x_sequential_for<
+          typename traits::get_sequence_result_type<TaskT...>::type
+        , typename first_type::link_type>::type
+  >::type;
+
+  static std::shared_ptr<type> create(const std::shared_ptr<TaskT>&... tasks_)
+  {
+    return std::make_shared<type>(tasks_...);
+  }
+};
@@ -33,11 +33,203 @@
 
 
 
+namespace helpers {
+
+// result reporters get the context to report to as the first parameter
+template<typename ResultT> struct get_result_reporter
+{
+  using type = callback<context*, const ResultT&>;
+};
+template<> struct get_result_reporter<void>
+{
+  using type = callback<context*>;
+};
+
+// the result of the task, stored in place once the task completes
+template <typename T>
+class result_slot
+{
+ public:
+  result_slot() : m_set(false)
+  { /* noop */ }
+  result_slot(const result_slot&) = delete;
+  result_slot& operator =(const result_slot&) = delete;
+  ~result_slot()
+  {
+    if (m_set)
+      reinterpret_cast<T*>(&m_value)->~T();
+  }
+
+  template <typename RunnerT, typename FunctionT, typename TupleT>
+  void invoke(const std::shared_ptr<RunnerT>& r_, const FunctionT& f_, const TupleT& input_)
+  {
+    new (&m_value) T(invoke_callable<T>(r_, f_, input_));
+    m_set = true;
+  }
+  // the result as the input of the next subtask
+  std::tuple<const T&> as_input() const
+  {
+    return std::tuple<const T&>(value());
+  }
+  template <typename ReporterT>
+  void report(const ReporterT& reporter_, context* parent_) const
+  {
+    if (reporter_)
+      reporter_(parent_, value());
+  }
+
+ private:
+  const T& value() const
+  {
+    return *reinterpret_cast<const T*>(&m_value);
+  }
+
+ private:
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type m_value;
+  bool m_set;
+};
+
+template <>
+class result_slot<void>
+{
+ public:
+  template <typename RunnerT, typename FunctionT, typename TupleT>
+  void invoke(const std::shared_ptr<RunnerT>& r_, const FunctionT& f_, const TupleT& input_)
+  {
+    invoke_callable<void>(r_, f_, input_);
+  }
+  std::tuple<> as_input() const
+  {
+    return std::tuple<>();
+  }
+  template <typename ReporterT>
+  void report(const ReporterT& reporter_, context* parent_) const
+  {
+    if (reporter_)
+      reporter_(parent_);
+  }
+};
+
+} // namespace helpers
+
+// ---- Link of the statically typed compound task; starts the subtask that
+// ---- accepts the input of types InputT...
+class x_link_base
+{
+ public:
+  virtual ~x_link_base() { /* noop */ }
+};
+
+template <typename... InputT>
+class x_link : public x_link_base
+{
+ public:
+  // creates the context of the subtask on the top of the stack; the subtask
+  // reports its result and exceptions to the parent_ context
+  virtual void start(context_stack* stack_, context* parent_, const InputT&... input_) const = 0;
+};
+
+template <typename ResultT>
+struct x_link_for
+{
+  using type = x_link<ResultT>;
+};
+template <>
+struct x_link_for<void>
+{
+  using type = x_link<>;
+};
+
 template <typename RunnerT, typename ResultT, typename... InputT>
-class x_taskinfo<tag::simple, RunnerT, ResultT, InputT...> // : public base::taskinfo<InputT, ResultT>
+class x_taskinfo<tag::simple, RunnerT, ResultT, InputT...> : public task
 {
  public:
-  using function_type = std::function<ResultT(const std::shared_ptr<RunnerT>&, const typename std::decay<InputT>::type&...)>;
+  using this_type            = x_taskinfo;
+  using runner_type          = RunnerT;
+  using result_type          = ResultT;
+  using function_type        = std::function<ResultT(const std::shared_ptr<RunnerT>&, const typename std::decay<InputT>::type&...)>;
+  using result_reporter_type = typename helpers::get_result_reporter<ResultT>::type;
+  using context_type         = context_impl<tag::simple, RunnerT, ResultT, InputT...>;
+  using link_type            = x_link<InputT...>;
+
+ public:
+  x_taskinfo(const std::weak_ptr<RunnerT>& r_, const function_type& f_)
+    : m_runner(r_), m_function(f_)
+  { /* noop */ }
+
+  std::weak_ptr<runner> get_runner() const override
+  {
+    return m_runner;
+  }
+  const function_type& function() const
+  {
+    return m_function;
+  }
+
+  // type erased input must carry std::tuple<InputT...>
+  context* create_context(
+        context_stack* stack_
+      , const std::shared_ptr<task>& self_
+      , const any& input_) const override
+  {
+    return create_context(
+        stack_
+      , self_
+      , any_cast<const std::tuple<InputT...>&>(input_)
+      , typename helpers::make_indices<sizeof...(InputT)>::type());
+  }
+
+  // creates the context that reports the result to the parent_ context
+  context* create_context(
+        context_stack* stack_
+      , const std::shared_ptr<task>& self_
+      , context* parent_
+      , const result_reporter_type& reporter_
+      , const InputT&... input_) const
+  {
+    return context_type::create(stack_, self_, m_function, reporter_, parent_, input_...);
+  }
+
+  void run(
+      const std::shared_ptr<this_type>& self_
+    , const InputT&... input_
+    , Urgency urgency_ = Urgency::NORMAL
+    , const runner::clock::time_point& deadline_ = runner::clock::time_point::max()) const
+  {
+    auto stack = new default_task_stack();
+    stack->urgency(urgency_);
+    stack->deadline(deadline_);
+    create_context(stack, self_, nullptr, result_reporter_type(), input_...);
+    kickstart(stack);
+  }
+
+ private:
+  template <std::size_t... I>
+  context* create_context(
+        context_stack* stack_
+      , const std::shared_ptr<task>& self_
+      , const std::tuple<InputT...>& input_
+      , helpers::indices<I...>) const
+  {
+    return create_context(stack_, self_, nullptr, result_reporter_type(), std::get<I>(input_)...);
+  }
+
+ private:
+  std::weak_ptr<RunnerT> m_runner;
+  function_type          m_function;
+};
+
+// ---- statically typed simple task of the user Callable with the input of
+// ---- type InputT, or with no input if InputT is void
+template <typename RunnerT, typename ResultT, typename InputT>
+struct x_simple_for
+{
+  using type = x_taskinfo<tag::simple, RunnerT, ResultT, typename std::decay<InputT>::type>;
+};
+template <typename RunnerT, typename ResultT>
+struct x_simple_for<RunnerT, ResultT, void>
+{
+  using type = x_taskinfo<tag::simple, RunnerT, ResultT>;
 };
 
 #if 0
@@ -89,19 +281,6 @@ class taskinfo<tag::simple, RunnerT, InputT, ResultT> : public base::taskinfo<In
 // ----
 // ---- -----------------------------------------------------------------------
 
-namespace helpers {
-
-template<typename ResultT> struct get_result_reporter
-{
-  using type = std::function<void(context*, const ResultT&)>;
-};
-template<> struct get_result_reporter<void>
-{
-  using type = std::function<void(context*)>;
-};
-
-} // namespace helpers
-
 template <typename RunnerT, typename ResultT, typename... InputT>
 class context_impl<tag::simple, RunnerT, ResultT, InputT...>
   : public task_context_base
@@ -120,7 +299,19 @@ class context_impl<tag::simple, RunnerT, ResultT, InputT...>
     , const result_reporter_type& res_reporter_
     , const InputT&... input_)
   {
-    auto aux = new this_type(stack_, task_, function_, res_reporter_, input_...);
+    return create(stack_, task_, function_, res_reporter_, nullptr, input_...);
+  }
+
+  // the result is reported to the parent_ context
+  inline static this_type* create(
+      context_stack* stack_
+    , const std::shared_ptr<task>& task_
+    , const typename task_type::function_type& function_
+    , const result_reporter_type& res_reporter_
+    , context* parent_
+    , const InputT&... input_)
+  {
+    auto aux = new (stack_) this_type(stack_, task_, function_, res_reporter_, parent_, input_...);
     if (stack_ != nullptr)
       stack_->push(aux);
     return aux;
@@ -148,53 +339,22 @@ class context_impl<tag::simple, RunnerT, ResultT, InputT...>
        , const std::shared_ptr<task>& t_
        , const typename task_type::function_type& f_
        , const result_reporter_type& res_reporter_
+       , context* parent_
        , const InputT&... input_)
      : task_context_base(st_, t_)
      , param_store<InputT...>(input_...)
      , m_user_func(f_)
      , m_result_reporter(res_reporter_)
+     , m_parent(parent_)
    { /* noop */ }
 
   private:
    const typename task_type::function_type&  m_user_func;
-   const result_reporter_type& m_result_reporter;
+   const result_reporter_type  m_result_reporter;
+   context*                    m_parent;     // context to report the result to, if any
 };
 
 
-template <typename ResultT, typename TupleT>
-struct callable_invoker
-{
-  template<typename EntryPointT, typename RunnerT, typename ReporterT>
-  static void invoke(
-      const EntryPointT& ep_
-    , context* rep_ctx_
-    , const std::shared_ptr<RunnerT>& r_
-    , const ReporterT& rep_
-    , const TupleT& input_)
-  {
-    if (rep_)
-      rep_(rep_ctx_, helpers::invoke_callable<ResultT>(r_, ep_, input_));
-    else
-      helpers::invoke_callable<ResultT>(r_, ep_, input_);
-  }
-};
-
-template <typename TupleT>
-struct callable_invoker<void, TupleT>
-{
-  template<typename EntryPointT, typename RunnerT, typename ReporterT>
-  static void invoke(
-      const EntryPointT& ep_
-    , context* rep_ctx_
-    , const std::shared_ptr<RunnerT>& r_
-    , const ReporterT& rep_
-    , const TupleT& input_)
-  {
-    helpers::invoke_callable<void>(r_, ep_, input_);
-    if (rep_)
-      rep_(rep_ctx_);
-  }
-};
 // ----
 // ---- Entry point for simple task
 // ----
@@ -202,18 +362,48 @@ template <typename RunnerT, typename ResultT, typename... InputT>
 void context_impl<tag::simple, RunnerT, ResultT, InputT...>::entry_point(
     const std::shared_ptr<async::runner>& r_, context* ctx_)
 {
+  // remove self from the context stack and release the context before
+  // reporting the result, as the reporter may push the context of the next
+  // task to the stack and should reuse the memory this context occupied
+  if (m_stack != nullptr)
+    m_stack->pop();
+
+  helpers::result_slot<ResultT> result;
+  auto parent = m_parent;
+  auto reporter = m_result_reporter;
+  auto exc_reporter = m_exc_reporter;
+  std::exception_ptr error;
+
   try
   {
     auto runner = std::dynamic_pointer_cast<RunnerT>(r_);
     if (!runner)
       throw exception::bad_runner_cast();
 
-    callable_invoker<ResultT, decltype(store_type::m_arguments)>::invoke(m_user_func, nullptr, runner, m_result_reporter, store_type::m_arguments);
+    result.invoke(runner, m_user_func, store_type::m_arguments);
   }
   catch (...)
   {
+    error = std::current_exception();
+  }
 
+  // the context without the stack is owned by its creator
+  if (m_stack != nullptr)
+    delete this;
+
+  if (!error)
+  {
+    try
+    {
+      result.report(reporter, parent);
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
   }
+  if (error && exc_reporter)
+    exc_reporter(error);
 }
 
 
@@ -249,7 +439,7 @@ class task_context<tag::simple, RunnerT, InputT, ResultT>
     , const typename task_type::function_type& f_
     , const any& i_)
   {
-    auto aux = new this_type(stack_, task_, f_);
+    auto aux = new (stack_) this_type(stack_, task_, f_);
     aux->set_input(i_);
     if (stack_ != nullptr)
       stack_->push(aux);
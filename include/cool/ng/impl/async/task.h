@@ -29,6 +29,7 @@
 #include <functional>
 #include <type_traits>
 #include <vector>
+#include <array>
 #include <stack>
 #include <typeinfo>
 #include <stdexcept>
@@ -189,26 +190,140 @@ class task_context : public context { };
 
 // ---- Task execution kick-starter
 dlldecl void kickstart(context_stack*);
+// ---- Delayed kick-starter; the context stack is enqueued at the given time
+dlldecl void kickstart(context_stack*, const runner::clock::time_point&);
+// ---- Kick-starter for several context stacks at once; consecutive stacks
+// ---- starting on the same runner are enqueued in a single queue operation
+dlldecl void kickstart(context_stack* const*, std::size_t);
 
 // ---- Default implementation of task stack
+// ----
+// ---- The contexts of the task run are allocated from the small arena within
+// ---- the stack, sized for a simple task or a flat sequence, and, once the
+// ---- arena is full, from a single heap chunk the stack allocates on demand.
+// ---- Both are bump allocators that return the memory of the released
+// ---- context to the free space only if it was the last allocated one, which
+// ---- is the common case as the contexts come and go in the stack order. The
+// ---- contexts that fit neither are allocated from the heap. The stacks are
+// ---- recycled through the library's pool, thus the task run whose contexts
+// ---- fit the arena does not allocate.
+// ----
+// ---- The bump allocators do not track the released blocks. The memory of
+// ---- the context released out of the stack order, while a context allocated
+// ---- after it is still alive, is not reused until the stack is destroyed,
+// ---- and neither is the free space of the arena below it. The same holds
+// ---- for the chunk. The stack has a single chunk, hence the contexts of the
+// ---- task run that releases its contexts out of order may end up on the
+// ---- heap.
 class default_task_stack : public context_stack
 {
+  static constexpr std::size_t arena_size = 320;
+  static constexpr std::size_t chunk_size = 1024;
+  static constexpr std::size_t inline_depth = 8;
+  static constexpr std::size_t alignment = alignof(std::max_align_t);
+
+  // bump allocator over the memory block
+  struct region
+  {
+    unsigned char* m_base;
+    std::size_t    m_size;
+    std::size_t    m_used;
+
+    bool contains(const unsigned char* p_) const
+    {
+      return p_ >= m_base && p_ < m_base + m_size;
+    }
+    void* allocate(std::size_t size_)
+    {
+      if (size_ > m_size - m_used)
+        return nullptr;
+      auto ret = m_base + m_used;
+      m_used += size_;
+      return ret;
+    }
+    void deallocate(unsigned char* p_, std::size_t size_)
+    {
+      if (size_ != 0 && p_ + size_ == m_base + m_used)
+        m_used -= size_;
+    }
+  };
+
 public:
+  default_task_stack(const default_task_stack&) = delete;
+  default_task_stack& operator =(const default_task_stack&) = delete;
+  default_task_stack() : m_depth(0)
+  {
+    m_arena = region { m_memory, arena_size, 0 };
+    m_chunk = region { nullptr, 0, 0 };
+  }
   ~default_task_stack()
   {
     while (!empty())
       delete pop();
+    ::operator delete(m_chunk.m_base);
+  }
+  void push(context* arg_) override
+  {
+    if (m_depth < inline_depth)
+      m_inline[m_depth] = arg_;
+    else
+      m_overflow.push_back(arg_);
+    ++m_depth;
+  }
+  context* pop() override
+  {
+    auto aux = top();
+    if (--m_depth >= inline_depth)
+      m_overflow.pop_back();
+    return aux;
   }
-  void push(context* arg_) override  { m_stack.push(arg_); }
-  context* pop() override            { auto aux = m_stack.top(); m_stack.pop(); return aux; }
-  context* top() const override      { return m_stack.top(); }
-  bool empty() const override        { return m_stack.empty(); }
+  context* top() const override
+  {
+    return m_depth > inline_depth ? m_overflow.back() : m_inline[m_depth - 1];
+  }
+  bool empty() const override        { return m_depth == 0; }
 
-private:
-  std::stack<context*> m_stack;
-};
+  void* allocate(std::size_t size_) override
+  {
+    size_ = round_up(size_);
+    auto ret = m_arena.allocate(size_);
+    if (ret != nullptr)
+      return ret;
+
+    if (m_chunk.m_base == nullptr && size_ <= chunk_size)
+      m_chunk = region { static_cast<unsigned char*>(::operator new(chunk_size)), chunk_size, 0 };
+    ret = m_chunk.allocate(size_);
+    return ret != nullptr ? ret : ::operator new(size_);
+  }
+  void deallocate(void* p_, std::size_t size_) override
+  {
+    auto p = static_cast<unsigned char*>(p_);
+    if (m_arena.contains(p))
+      m_arena.deallocate(p, round_up(size_));
+    else if (m_chunk.contains(p))
+      m_chunk.deallocate(p, round_up(size_));
+    else
+      ::operator delete(p_);
+  }
 
+  // default task stacks are recycled by the library's pool
+  dlldecl static void* operator new(std::size_t);
+  dlldecl static void operator delete(void*);
 
+private:
+  static std::size_t round_up(std::size_t size_)
+  {
+    return (size_ + alignment - 1) / alignment * alignment;
+  }
+
+private:
+  alignas(alignment) unsigned char m_memory[arena_size];
+  region                m_arena;
+  region                m_chunk;     // allocated once the arena is full
+  std::size_t           m_depth;
+  context*              m_inline[inline_depth];
+  std::vector<context*> m_overflow;
+};
 
 namespace base {
 
@@ -225,10 +340,14 @@ class taskinfo : public detail::task
       const std::shared_ptr<this_type>& self_
     , const typename std::decay<typename std::enable_if<
           !std::is_same<T, void>::value && !std::is_rvalue_reference<T>::value
-        , T>::type>::type& i_)
+        , T>::type>::type& i_
+    , Urgency urgency_ = Urgency::NORMAL
+    , const runner::clock::time_point& deadline_ = runner::clock::time_point::max())
   {
     any input = i_;
     auto stack = new default_task_stack();
+    stack->urgency(urgency_);
+    stack->deadline(deadline_);
     create_context(stack, self_, input);
     kickstart(stack);
   }
@@ -239,21 +358,127 @@ class taskinfo : public detail::task
       const std::shared_ptr<this_type>& self_
     , typename std::enable_if<
         !std::is_same<T, void>::value && std::is_rvalue_reference<T>::value
-      , T>::type i_)
+      , T>::type i_
+    , Urgency urgency_ = Urgency::NORMAL
+    , const runner::clock::time_point& deadline_ = runner::clock::time_point::max())
   {
     any input(std::move(i_));
     auto stack = new default_task_stack();
+    stack->urgency(urgency_);
+    stack->deadline(deadline_);
     create_context(stack, self_, input);
     kickstart(stack);
   }
 
   template <typename T = InputT>
-  typename std::enable_if<std::is_same<T, void>::value, void>::type run(const std::shared_ptr<this_type>& self_)
+  typename std::enable_if<std::is_same<T, void>::value, void>::type run(
+      const std::shared_ptr<this_type>& self_
+    , Urgency urgency_ = Urgency::NORMAL
+    , const runner::clock::time_point& deadline_ = runner::clock::time_point::max())
   {
     auto stack = new default_task_stack();
+    stack->urgency(urgency_);
+    stack->deadline(deadline_);
     create_context(stack, self_, any());
     kickstart(stack);
   }
+
+  // delayed run, the context stack is submitted at when_
+  template <typename T = InputT>
+  inline void run_at(
+      const std::shared_ptr<this_type>& self_
+    , const runner::clock::time_point& when_
+    , const typename std::decay<typename std::enable_if<
+          !std::is_same<T, void>::value && !std::is_rvalue_reference<T>::value
+        , T>::type>::type& i_)
+  {
+    any input = i_;
+    auto stack = new default_task_stack();
+    create_context(stack, self_, input);
+    kickstart(stack, when_);
+  }
+
+  // delayed run, rvalue reference argument
+  template <typename T = InputT>
+  inline void run_at(
+      const std::shared_ptr<this_type>& self_
+    , const runner::clock::time_point& when_
+    , typename std::enable_if<
+        !std::is_same<T, void>::value && std::is_rvalue_reference<T>::value
+      , T>::type i_)
+  {
+    any input(std::move(i_));
+    auto stack = new default_task_stack();
+    create_context(stack, self_, input);
+    kickstart(stack, when_);
+  }
+
+  // delayed run without input
+  template <typename T = InputT>
+  typename std::enable_if<std::is_same<T, void>::value, void>::type run_at(
+      const std::shared_ptr<this_type>& self_
+    , const runner::clock::time_point& when_)
+  {
+    auto stack = new default_task_stack();
+    create_context(stack, self_, any());
+    kickstart(stack, when_);
+  }
+
+  // one run for each input value in the range
+  template <typename IteratorT, typename T = InputT>
+  typename std::enable_if<!std::is_same<T, void>::value, void>::type run_many(
+      const std::shared_ptr<this_type>& self_
+    , IteratorT first_
+    , IteratorT last_)
+  {
+    using value_type = typename std::decay<T>::type;
+
+    std::vector<context_stack*> stacks;
+    try
+    {
+      for ( ; first_ != last_; ++first_)
+      {
+        std::unique_ptr<context_stack> stack(new default_task_stack());
+        create_context(stack.get(), self_, any(value_type(*first_)));
+        stacks.push_back(stack.get());
+        stack.release();
+      }
+    }
+    catch (...)
+    {
+      for (auto s : stacks)
+        delete s;
+      throw;
+    }
+    kickstart(stacks.data(), stacks.size());
+  }
+
+  // count_ runs of the task without input
+  template <typename T = InputT>
+  typename std::enable_if<std::is_same<T, void>::value, void>::type run_many(
+      const std::shared_ptr<this_type>& self_
+    , std::size_t count_)
+  {
+    std::vector<context_stack*> stacks;
+    stacks.reserve(count_);
+    try
+    {
+      for (std::size_t i = 0; i < count_; ++i)
+      {
+        std::unique_ptr<context_stack> stack(new default_task_stack());
+        create_context(stack.get(), self_, any());
+        stacks.push_back(stack.get());
+        stack.release();
+      }
+    }
+    catch (...)
+    {
+      for (auto s : stacks)
+        delete s;
+      throw;
+    }
+    kickstart(stacks.data(), stacks.size());
+  }
 };
 
 } // namespace
@@ -262,8 +487,8 @@ class taskinfo : public detail::task
 #define __COOL_INCLUDE_TASK_IMPL_FILES__
 
 #include "simple_impl.h"
-#if 0
 #include "sequential_impl.h"
+#if 0
 #include "intercept_impl.h"
 #include "conditional_impl.h"
 #include "repeat_impl.h"
@@ -27,6 +27,7 @@
 #include <iostream>
 #include <string>
 #include <cstdint>
+#include <functional>
 
 #if defined(WINDOWS_TARGET)
 # include <winsock2.h>
@@ -2254,6 +2255,45 @@ inline std::istream& operator >>(std::istream& is_, service& svc_)
 
 } } } // namespaces cool::ng::ip
 
+namespace std {
+
+/**
+ * @ingroup ip
+ * Standard template specialization for @ref cool::ng::ip::address "IP addresses".
+ *
+ * The hash is consistent with the address @ref cool::ng::ip::address::equals()
+ * "comparison"; the @ref cool::ng::ip::ipv6::host "IPv6 host" address that
+ * @ref cool::ng::ip::attribute::ipv4originated "originated" in the IPv4
+ * address space hashes the same as the IPv4 host address it compares equal to.
+ * To hash the derived address types use this specialization explicitly, eg.
+ * <tt>std::hash<cool::ng::ip::address>()(host)</tt>.
+ */
+template <>
+struct hash<cool::ng::ip::address>
+{
+  std::size_t operator ()(const cool::ng::ip::address& addr_) const
+  {
+    auto data = static_cast<const uint8_t*>(addr_);
+    auto size = addr_.size();
+
+    if (addr_.kind() == cool::ng::ip::kind::host
+        && addr_.version() == cool::ng::ip::version::ipv6
+        && addr_.is(cool::ng::ip::attribute::ipv4originated))
+    {
+      data += 12;
+      size = 4;
+    }
+
+    // FNV-1a
+    uint64_t ret = 14695981039346656037ULL;
+    for (std::size_t i = 0; i < size; ++i)
+      ret = (ret ^ data[i]) * 1099511628211ULL;
+    return static_cast<std::size_t>(ret);
+  }
+};
+
+} // namespace
+
 #if COOL_DONT_POLLUTE_GLOBAL_NAMESPACE != 1
 using cool::ng::ip::operator "" _ip;
 using cool::ng::ip::operator "" _ipv4;
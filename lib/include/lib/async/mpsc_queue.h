@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_948af69a_9693_4be1_896b_60f2a8f55e11)
+#define      cool_ng_948af69a_9693_4be1_896b_60f2a8f55e11
+
+#include <atomic>
+
+/*
+  Notes on mpsc_queue:
+
+  The mpsc_queue is an intrusive, lock-free, unbounded FIFO queue that permits
+  any number of concurrent producers but only one consumer at a time. It is
+  internal to Cool.NG library and is the task queue of the run_queue
+  implementations that do not rely on the platform provided queues.
+
+  The queue elements must derive from mpsc_node, which carries the link to the
+  next element. The queue does not own its elements and does not allocate any
+  memory; the push() and pop() thus never take a lock nor call the allocator.
+  The implementation follows the well known algorithm by Dmitry Vyukov where
+  the producers only contend on a single atomic exchange of the head pointer.
+
+  The consumer side is not thread safe. The user of the queue must guarantee
+  that at most one thread calls pop() or empty() at any time. Note that pop()
+  may return nullptr even if the queue is not empty; this happens when the
+  producer was preempted between the exchange of the head pointer and linking
+  the previous head to the new element. The consumer that knows, for instance
+  from the separate element count, that the queue is not empty, should retry.
+
+  Several elements can be pushed in a single operation. The producer first
+  links the elements into a chain using link() and then pushes the chain with
+  push(first, last). The cost of such push is the same as the cost of the
+  push of a single element and the elements of the chain are not interleaved
+  with the elements pushed by other producers.
+*/
+
+namespace cool { namespace ng { namespace async { namespace impl {
+
+class mpsc_node
+{
+ public:
+  mpsc_node() : m_next(nullptr)
+  { /* noop */ }
+
+ private:
+  template <typename T> friend class mpsc_queue;
+  std::atomic<mpsc_node*> m_next;
+};
+
+template <typename T>
+class mpsc_queue
+{
+ public:
+  mpsc_queue() : m_head(&m_stub), m_tail(&m_stub)
+  { /* noop */ }
+  mpsc_queue(const mpsc_queue&) = delete;
+  mpsc_queue& operator =(const mpsc_queue&) = delete;
+
+  // --- producer side, thread safe
+  void push(T* item_)
+  {
+    push_node(static_cast<mpsc_node*>(item_));
+  }
+  // pushes the chain of elements linked by link()
+  void push(T* first_, T* last_)
+  {
+    push_chain(static_cast<mpsc_node*>(first_), static_cast<mpsc_node*>(last_));
+  }
+  // links next_ after prev_; the elements must not be in the queue yet
+  static void link(T* prev_, T* next_)
+  {
+    static_cast<mpsc_node*>(prev_)->m_next.store(static_cast<mpsc_node*>(next_), std::memory_order_relaxed);
+  }
+
+  // --- consumer side, single thread only
+  T* pop()
+  {
+    mpsc_node* tail = m_tail;
+    mpsc_node* next = tail->m_next.load(std::memory_order_acquire);
+
+    if (tail == &m_stub)
+    {
+      if (next == nullptr)
+        return nullptr;
+      m_tail = next;
+      tail = next;
+      next = next->m_next.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr)
+    {
+      m_tail = next;
+      return static_cast<T*>(tail);
+    }
+
+    // the tail is the last element; if the head moved in the meantime the
+    // producer is still linking the new element and we have to come back
+    if (tail != m_head.load(std::memory_order_acquire))
+      return nullptr;
+
+    push_node(&m_stub);
+    next = tail->m_next.load(std::memory_order_acquire);
+    if (next != nullptr)
+    {
+      m_tail = next;
+      return static_cast<T*>(tail);
+    }
+    return nullptr;
+  }
+
+  bool empty() const
+  {
+    return m_tail == &m_stub && m_stub.m_next.load(std::memory_order_acquire) == nullptr;
+  }
+
+ private:
+  void push_node(mpsc_node* node_)
+  {
+    push_chain(node_, node_);
+  }
+  void push_chain(mpsc_node* first_, mpsc_node* last_)
+  {
+    last_->m_next.store(nullptr, std::memory_order_relaxed);
+    auto prev = m_head.exchange(last_, std::memory_order_acq_rel);
+    prev->m_next.store(first_, std::memory_order_release);
+  }
+
+ private:
+  std::atomic<mpsc_node*> m_head;   // producers push here
+  mpsc_node*              m_tail;   // consumer pops here
+  mpsc_node               m_stub;
+};
+
+} } } }// namespace
+
+#endif
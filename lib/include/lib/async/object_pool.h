@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_3b1f6e2c_57d4_4c0a_9e61_0f8a2d4c7b95)
+#define      cool_ng_3b1f6e2c_57d4_4c0a_9e61_0f8a2d4c7b95
+
+#include <cstddef>
+#include <new>
+#include <mutex>
+#include <vector>
+#include <utility>
+
+/*
+  Notes on object_pool:
+
+  The object_pool is a fixed size memory block allocator for the objects of
+  type T that are allocated and released at high rates, such as run_queue
+  task contexts. It is internal to Cool.NG library. The class T opts in by
+  providing the class specific operator new and operator delete that call
+  object_pool<T>::allocate() and object_pool<T>::deallocate().
+
+  Each thread keeps its own cache of free blocks, thus the allocation and the
+  release of the block are, in the common case, a pop or a push on the
+  thread's private list, without synchronization. Since the objects are often
+  allocated on one thread and released on another, the threads exchange the
+  free blocks through the shared depot, in batches of BatchSize blocks: the
+  thread whose cache grows over twice the batch size moves one batch into the
+  depot and the thread whose cache is empty takes one batch from the depot
+  before it resorts to the global allocator. The depot mutex is thus taken at
+  most once per BatchSize allocations or releases.
+
+  The thread returns its cache into the depot when it exits. The depot keeps
+  at most DepotLimit batches and returns the blocks of the batches over this
+  limit to the global allocator; the memory held by the pool is bounded by
+  the depot limit and the thread caches or, without the limit, which is the
+  default, by the peak number of simultaneously allocated objects.
+*/
+
+namespace cool { namespace ng { namespace async { namespace impl {
+
+template <typename T, std::size_t BatchSize = 64, std::size_t DepotLimit = static_cast<std::size_t>(-1)>
+class object_pool
+{
+  struct block
+  {
+    block* m_next;
+  };
+
+  static_assert(sizeof(T) >= sizeof(block), "object too small for object_pool");
+  static_assert(BatchSize > 0, "batch size must be greater than 0");
+
+  // shared store of free block batches, each batch a chain of at most
+  // BatchSize blocks kept together with its length
+  class depot
+  {
+   public:
+    void put(block* batch_, std::size_t count_)
+    {
+      {
+        std::unique_lock<std::mutex> l(m_mutex);
+        if (m_batches.size() < DepotLimit)
+        {
+          m_batches.push_back(std::make_pair(batch_, count_));
+          return;
+        }
+      }
+
+      // the depot is full, release the batch to the global allocator
+      while (batch_ != nullptr)
+      {
+        auto aux = batch_;
+        batch_ = batch_->m_next;
+        ::operator delete(aux);
+      }
+    }
+    // returns the batch and sets count_ to its length, or returns nullptr
+    // and sets count_ to 0 if the depot is empty
+    block* get(std::size_t& count_)
+    {
+      std::unique_lock<std::mutex> l(m_mutex);
+      if (m_batches.empty())
+      {
+        count_ = 0;
+        return nullptr;
+      }
+      auto ret = m_batches.back();
+      m_batches.pop_back();
+      count_ = ret.second;
+      return ret.first;
+    }
+
+   private:
+    std::mutex                                  m_mutex;
+    std::vector<std::pair<block*, std::size_t>> m_batches;
+  };
+
+  // thread's private cache of free blocks
+  class cache
+  {
+   public:
+    cache() : m_head(nullptr), m_count(0)
+    { /* noop */ }
+    ~cache()
+    {
+      // hand over all blocks, the last batch may be incomplete
+      while (m_head != nullptr)
+        detach_batch();
+    }
+
+    void* allocate()
+    {
+      if (m_head == nullptr)
+      {
+        m_head = get_depot().get(m_count);
+        if (m_head == nullptr)
+          return ::operator new(sizeof(T));
+      }
+      auto ret = m_head;
+      m_head = m_head->m_next;
+      --m_count;
+      return ret;
+    }
+
+    void deallocate(void* p_)
+    {
+      auto b = static_cast<block*>(p_);
+      b->m_next = m_head;
+      m_head = b;
+      if (++m_count >= 2 * BatchSize)
+        detach_batch();
+    }
+
+   private:
+    // moves up to BatchSize blocks from the head of the cache to the depot
+    void detach_batch()
+    {
+      auto ret = m_head;
+      auto last = m_head;
+      std::size_t n = 1;
+      for ( ; n < BatchSize && last->m_next != nullptr; ++n)
+        last = last->m_next;
+      m_head = last->m_next;
+      last->m_next = nullptr;
+      m_count -= n;
+      get_depot().put(ret, n);
+    }
+
+   private:
+    block*      m_head;
+    std::size_t m_count;
+  };
+
+ public:
+  static void* allocate()
+  {
+    return get_cache().allocate();
+  }
+  static void deallocate(void* p_)
+  {
+    if (p_ != nullptr)
+      get_cache().deallocate(p_);
+  }
+
+ private:
+  static depot& get_depot()
+  {
+    // never destroyed; thread caches may return blocks during process exit
+    static depot* depot_ = new depot();
+    return *depot_;
+  }
+  static cache& get_cache()
+  {
+    static thread_local cache cache_;
+    return cache_;
+  }
+};
+
+} } } }// namespace
+
+#endif
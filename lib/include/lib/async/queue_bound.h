@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_99beccd6_ab80_4d1c_8d67_7d2f993c76e2)
+#define      cool_ng_99beccd6_ab80_4d1c_8d67_7d2f993c76e2
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include <algorithm>
+
+#include "cool/ng/exception.h"
+#include "cool/ng/async/runner.h"
+
+/*
+  Notes on queue_bound:
+
+  The queue_bound keeps the number of tasks submitted to the bounded run_queue
+  but not yet started, and applies the overflow policy when the run_queue is
+  full. It is internal to Cool.NG library.
+
+  The run_queue calls admit() before it accepts the tasks and leave() when the
+  task is either started or discarded. Depending on the overflow policy, the
+  admit() will block the calling thread until the run_queue has room, throw
+  queue_full exception, or accept the tasks and return the number of the
+  oldest tasks the run_queue should discard. The batch of tasks is admitted as
+  a whole, and is admitted over the capacity if the run_queue is empty, which
+  permits batches larger than the capacity.
+
+  The thread executing the task of the bounded run_queue registers the queue's
+  bound as current(). The admit() never blocks the task submitting to its own
+  run_queue, as the run_queue could not proceed until the task completes.
+  Such submission is admitted over the capacity.
+
+  The threads that must never block, such as the timer thread of the
+  timer_service, mark themselves as non_blocking(). The admit() throws
+  queue_full exception on such thread instead of blocking it.
+
+  The admit() and leave() are lock-free unless there are blocked threads. The
+  queue_bound is reference counted for the same reason as queue_metrics is.
+*/
+
+namespace cool { namespace ng { namespace async { namespace impl {
+
+class queue_bound
+{
+ public:
+  static queue_bound* create(std::size_t capacity_, OverflowPolicy policy_)
+  {
+    return new queue_bound(capacity_, policy_);
+  }
+  queue_bound(const queue_bound&) = delete;
+  queue_bound& operator =(const queue_bound&) = delete;
+
+  queue_bound* add_ref()
+  {
+    m_refs.fetch_add(1, std::memory_order_relaxed);
+    return this;
+  }
+  void release()
+  {
+    if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete this;
+  }
+
+  // returns the bound of the run_queue whose task is executing on this thread
+  static queue_bound*& current()
+  {
+    static thread_local queue_bound* current_ = nullptr;
+    return current_;
+  }
+
+  // true if the submissions from this thread must not block
+  static bool& non_blocking()
+  {
+    static thread_local bool non_blocking_ = false;
+    return non_blocking_;
+  }
+
+  OverflowPolicy policy() const { return m_policy; }
+
+  // Admits count_ tasks. Returns the number of the oldest tasks to discard.
+  std::size_t admit(std::size_t count_)
+  {
+    switch (m_policy)
+    {
+      case OverflowPolicy::DROP_OLDEST:
+      {
+        auto pending = m_pending.fetch_add(count_) + count_;
+        return pending > m_capacity ? std::min(pending - m_capacity, count_) : 0;
+      }
+
+      case OverflowPolicy::REJECT:
+        if (!try_admit(count_))
+          throw exception::queue_full();
+        return 0;
+
+      case OverflowPolicy::BLOCK:
+        if (!try_admit(count_))
+        {
+          if (non_blocking())
+            throw exception::queue_full();
+          wait_admit(count_);
+        }
+        return 0;
+    }
+    return 0;
+  }
+
+  // one task left the queue, either started or discarded
+  void leave()
+  {
+    m_pending.fetch_sub(1);
+    if (m_waiters.load() > 0)
+    {
+      std::unique_lock<std::mutex> l(m_lock);
+      m_cv.notify_all();
+    }
+  }
+
+ private:
+  queue_bound(std::size_t capacity_, OverflowPolicy policy_)
+    : m_refs(1), m_pending(0), m_waiters(0), m_capacity(capacity_), m_policy(policy_)
+  { /* noop */ }
+
+  bool try_admit(std::size_t count_)
+  {
+    auto pending = m_pending.load();
+    do
+    {
+      if (pending != 0 && pending + count_ > m_capacity)
+        return false;
+    }
+    while (!m_pending.compare_exchange_weak(pending, pending + count_));
+
+    return true;
+  }
+
+  void wait_admit(std::size_t count_)
+  {
+    if (current() == this)
+    {
+      m_pending.fetch_add(count_);
+      return;
+    }
+
+    std::unique_lock<std::mutex> l(m_lock);
+    ++m_waiters;
+    m_cv.wait(l, [this, count_] () { return try_admit(count_); });
+    --m_waiters;
+  }
+
+ private:
+  std::atomic<std::size_t> m_refs;
+  std::atomic<std::size_t> m_pending;
+  std::atomic<int>         m_waiters;
+  const std::size_t        m_capacity;
+  const OverflowPolicy     m_policy;
+  std::mutex               m_lock;
+  std::condition_variable  m_cv;
+};
+
+} } } }// namespace
+
+#endif
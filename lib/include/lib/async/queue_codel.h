@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_fe790296_273d_4e5d_8bfa_8763097acf79)
+#define      cool_ng_fe790296_273d_4e5d_8bfa_8763097acf79
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+/*
+  Notes on queue_codel:
+
+  The queue_codel decides which tasks of the run_queue created with the load
+  shedding enabled are to be shed, following the CoDel (controlled delay)
+  algorithm as described in RFC 8289. It is internal to Cool.NG library.
+
+  The run_queue calls shed() for each task just before it would start, with
+  the time the task was enqueued. The sojourn time, the time the task spent
+  waiting in the queue, is compared against the target. The queue_codel
+  enters the dropping state once the sojourn time stays above the target for
+  the whole interval, which means that even the shortest wait in the interval
+  was too long and the queue is not just absorbing a burst. In the dropping
+  state it sheds a task, and schedules the next shedding at the interval
+  divided by the square root of the number of tasks shed so far, until the
+  sojourn time falls below the target. The shedding rate thus increases
+  until the queue drains to the target delay. The dropping state resumes
+  with the previous shedding rate if it is re-entered soon after it was
+  left. The task is never shed if no other task waits behind it.
+
+  The queue_codel is not thread safe. The run_queue only calls it from the
+  holder of the BUSY bit.
+*/
+
+namespace cool { namespace ng { namespace async { namespace impl {
+
+class queue_codel
+{
+ public:
+  using clock = std::chrono::steady_clock;
+
+ public:
+  queue_codel(const clock::duration& target_, const clock::duration& interval_)
+    : m_target(target_), m_interval(interval_), m_first_above(), m_drop_next()
+    , m_count(0), m_last_count(0), m_dropping(false)
+  { /* noop */ }
+
+  // Returns true if the task enqueued at enqueued_ is to be shed. The last_
+  // is true if no other task is waiting behind it.
+  bool shed(const clock::time_point& enqueued_, const clock::time_point& now_, bool last_)
+  {
+    bool ok = ok_to_drop(now_ - enqueued_, now_, last_);
+
+    if (m_dropping)
+    {
+      if (!ok)
+      {
+        m_dropping = false;
+        return false;
+      }
+      if (now_ < m_drop_next)
+        return false;
+
+      ++m_count;
+      m_drop_next = control_law(m_drop_next);
+      return true;
+    }
+
+    if (!ok)
+      return false;
+
+    // resume with the previous rate if the dropping state was left recently
+    auto delta = m_count - m_last_count;
+    m_count = delta > 1 && now_ - m_drop_next < m_interval * 16 ? delta : 1;
+    m_last_count = m_count;
+    m_drop_next = control_law(now_);
+    m_dropping = true;
+    return true;
+  }
+
+  bool dropping() const { return m_dropping; }
+
+ private:
+  bool ok_to_drop(const clock::duration& sojourn_, const clock::time_point& now_, bool last_)
+  {
+    if (sojourn_ < m_target || last_)
+    {
+      m_first_above = clock::time_point();
+      return false;
+    }
+    if (m_first_above == clock::time_point())
+    {
+      m_first_above = now_ + m_interval;
+      return false;
+    }
+    return now_ >= m_first_above;
+  }
+
+  clock::time_point control_law(const clock::time_point& t_) const
+  {
+    return t_ + std::chrono::duration_cast<clock::duration>(
+        m_interval / std::sqrt(static_cast<double>(m_count)));
+  }
+
+ private:
+  const clock::duration m_target;
+  const clock::duration m_interval;
+  clock::time_point     m_first_above;  // end of interval above the target, or epoch if below
+  clock::time_point     m_drop_next;    // time of the next shedding
+  uint32_t              m_count;        // tasks shed since entering the dropping state
+  uint32_t              m_last_count;   // m_count at the last entry to the dropping state
+  bool                  m_dropping;
+};
+
+} } } }// namespace
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_6e0c9a47_2f3b_4d81_a5c6_91d7e4b08f23)
+#define      cool_ng_6e0c9a47_2f3b_4d81_a5c6_91d7e4b08f23
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "cool/ng/async/runner.h"
+
+/*
+  Notes on queue_metrics:
+
+  The queue_metrics collects the scheduling metrics of a single run_queue
+  that was created with the metrics collection enabled. It is internal to
+  Cool.NG library.
+
+  The run_queue calls on_enqueue() when a task is submitted, on_start() just
+  before the task is executed and on_finish() just after the task completes.
+  The task discarded without execution is counted by on_drop() instead.
+  All counters are atomic and updated with the relaxed memory order, thus any
+  thread may read the snapshot at any time without disturbing the run_queue.
+
+  The queue_metrics is reference counted. The run_queue holds one reference
+  and each measured task context holds another until its completion, so the
+  metrics outlive the run_queue if the concurrent run_queue is destroyed
+  while its tasks are still running.
+*/
+
+namespace cool { namespace ng { namespace async { namespace impl {
+
+class queue_metrics
+{
+ public:
+  using clock = std::chrono::steady_clock;
+
+ public:
+  static queue_metrics* create()
+  {
+    return new queue_metrics();
+  }
+  queue_metrics(const queue_metrics&) = delete;
+  queue_metrics& operator =(const queue_metrics&) = delete;
+
+  queue_metrics* add_ref()
+  {
+    m_refs.fetch_add(1, std::memory_order_relaxed);
+    return this;
+  }
+  void release()
+  {
+    if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete this;
+  }
+
+  void on_enqueue(std::size_t count_ = 1)
+  {
+    auto depth = m_depth.fetch_add(count_, std::memory_order_relaxed) + count_;
+    auto high = m_high_water.load(std::memory_order_relaxed);
+    while (depth > high && !m_high_water.compare_exchange_weak(high, depth, std::memory_order_relaxed))
+      ;
+  }
+  void on_start(const clock::time_point& enqueued_, const clock::time_point& now_)
+  {
+    m_depth.fetch_sub(1, std::memory_order_relaxed);
+    m_wait[bucket(now_ - enqueued_)].fetch_add(1, std::memory_order_relaxed);
+  }
+  void on_drop()
+  {
+    m_depth.fetch_sub(1, std::memory_order_relaxed);
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+  void on_finish(const clock::time_point& started_, const clock::time_point& now_)
+  {
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_run[bucket(now_ - started_)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void snapshot(runner::metrics& m_) const
+  {
+    m_.enabled = true;
+    m_.depth = m_depth.load(std::memory_order_relaxed);
+    m_.high_water = m_high_water.load(std::memory_order_relaxed);
+    m_.count = m_count.load(std::memory_order_relaxed);
+    m_.dropped = m_dropped.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < runner::metrics::histogram_size; ++i)
+    {
+      m_.wait[i] = m_wait[i].load(std::memory_order_relaxed);
+      m_.run[i] = m_run[i].load(std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  queue_metrics() : m_refs(1), m_depth(0), m_high_water(0), m_count(0), m_dropped(0)
+  {
+    for (std::size_t i = 0; i < runner::metrics::histogram_size; ++i)
+    {
+      m_wait[i] = 0;
+      m_run[i] = 0;
+    }
+  }
+
+  // index of the highest bit set in the duration in nanoseconds
+  static std::size_t bucket(const clock::duration& d_)
+  {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d_).count();
+    if (ns <= 1)
+      return 0;
+
+    auto v = static_cast<uint64_t>(ns);
+#if defined(__GNUC__) || defined(__clang__)
+    std::size_t ret = 63 - __builtin_clzll(v);
+#else
+    std::size_t ret = 0;
+    while (v >>= 1)
+      ++ret;
+#endif
+    return ret < runner::metrics::histogram_size ? ret : runner::metrics::histogram_size - 1;
+  }
+
+ private:
+  std::atomic<std::size_t> m_refs;
+  std::atomic<std::size_t> m_depth;
+  std::atomic<std::size_t> m_high_water;
+  std::atomic<uint64_t>    m_count;
+  std::atomic<uint64_t>    m_dropped;
+  std::atomic<uint64_t>    m_wait[runner::metrics::histogram_size];
+  std::atomic<uint64_t>    m_run[runner::metrics::histogram_size];
+};
+
+} } } }// namespace
+
+#endif
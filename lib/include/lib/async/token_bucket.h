@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_8c16b958_12c9_40d9_9d0a_22d81c83a88a)
+#define      cool_ng_8c16b958_12c9_40d9_9d0a_22d81c83a88a
+
+#include <chrono>
+#include <cstddef>
+#include <algorithm>
+
+/*
+  Notes on token_bucket:
+
+  The token_bucket paces the tasks of the rate limited run_queue. It is
+  internal to Cool.NG library.
+
+  The bucket holds up to burst tokens and is refilled with one token per
+  period, the rate limit interval divided by the number of tasks per
+  interval. The run_queue takes a token before it starts each task; if the
+  bucket is empty, it waits until next(), the time the next token becomes
+  available.
+
+  Rather than counting the tokens the bucket keeps the theoretical arrival
+  time of the next task, as in the generic cell rate algorithm: the task may
+  start if its start time is not more than burst - 1 periods ahead of the
+  theoretical arrival time, and its start advances the theoretical arrival
+  time by one period. This needs no periodic refill and no division on the
+  execution path.
+
+  The token_bucket is not thread safe. The run_queue only calls it from the
+  holder of the BUSY bit.
+*/
+
+namespace cool { namespace ng { namespace async { namespace impl {
+
+class token_bucket
+{
+ public:
+  using clock = std::chrono::steady_clock;
+
+ public:
+  token_bucket(std::size_t count_, const clock::duration& interval_, std::size_t burst_)
+    : m_period(interval_ / static_cast<clock::duration::rep>(count_))
+    , m_tolerance(m_period * static_cast<clock::duration::rep>(burst_ - 1))
+    , m_tat()
+  { /* noop */ }
+
+  // takes a token, if available at now_
+  bool take(const clock::time_point& now_)
+  {
+    auto tat = std::max(m_tat, now_);
+    if (tat - now_ > m_tolerance)
+      return false;
+
+    m_tat = tat + m_period;
+    return true;
+  }
+  // time at which the next token becomes available
+  clock::time_point next() const
+  {
+    return m_tat - m_tolerance;
+  }
+
+ private:
+  const clock::duration m_period;      // time to refill one token
+  const clock::duration m_tolerance;   // burst - 1 periods
+  clock::time_point     m_tat;         // theoretical arrival time of the next task
+};
+
+} } } }// namespace
+
+#endif
@@ -21,6 +21,19 @@
  * IN THE SOFTWARE.
  */
 
+#include <thread>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include "thread_pool.h"
+#include "timer_service.h"
+#if !defined(POSIX_POOL)
+# include <dispatch/dispatch.h>
+#endif
+
 #include "cool/ng/async/runner.h"
 #include "cool/ng/exception.h"
 #include "run_queue.h"
@@ -29,79 +42,773 @@ namespace cool { namespace ng { namespace async { namespace impl {
 
 namespace {
 
-dispatch_queue_t& get_global_queue()
+thread_pool* create_thread(const runner::options& opts_)
+{
+  if (!opts_.dedicated_thread())
+    return nullptr;
+  return thread_pool::create_dedicated(opts_.priority(), opts_.affinity(), opts_.numa_node(), opts_.busy_poll());
+}
+
+void get_pool_location(thread_pool* pool_, runner::placement& p_)
+{
+  p_.cpus = pool_->cpus();
+  p_.numa_node = pool_->numa_node();
+}
+
+#if defined(POSIX_POOL)
+
+// the target is the dedicated thread or the thread_pool of the run_queue's
+// priority and placement
+void* get_target(const runner::options& opts_, thread_pool* thread_)
+{
+  if (thread_ != nullptr)
+    return thread_;
+  return &thread_pool::get(opts_.priority(), opts_.affinity(), opts_.numa_node());
+}
+
+void get_location(void* target_, thread_pool*, runner::placement& p_)
+{
+  get_pool_location(static_cast<thread_pool*>(target_), p_);
+}
+
+inline void submit(void* target_, thread_pool*, run_queue::executor exe_, void* data_)
+{
+  static_cast<thread_pool*>(target_)->submit(exe_, data_);
+}
+
+inline void resubmit(void* target_, thread_pool*, run_queue::executor exe_, void* data_)
+{
+  static_cast<thread_pool*>(target_)->resubmit(exe_, data_);
+}
+
+#else
+
+dispatch_queue_t get_global_queue(Priority priority_)
+{
+  // in the order of Priority enumerators
+  static const dispatch_queue_t global_[] = {
+      ::dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0)
+    , ::dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0)
+    , ::dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0)
+    , ::dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0)
+  };
+
+  return global_[static_cast<int>(priority_)];
+}
+
+// the target is the global queue of the run_queue's priority; libdispatch
+// does not support the placement of its worker threads. The run_queue with
+// the dedicated thread submits to its thread instead.
+void* get_target(const runner::options& opts_, thread_pool*)
+{
+  return get_global_queue(opts_.priority());
+}
+
+void get_location(void*, thread_pool* thread_, runner::placement& p_)
+{
+  if (thread_ != nullptr)
+    get_pool_location(thread_, p_);
+}
+
+inline void submit(void* target_, thread_pool* thread_, run_queue::executor exe_, void* data_)
 {
-  static dispatch_queue_t global_ = ::dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+  if (thread_ != nullptr)
+    thread_->submit(exe_, data_);
+  else
+    ::dispatch_async_f(static_cast<dispatch_queue_t>(target_), data_, exe_);
+}
 
-  return global_;
+inline void resubmit(void* target_, thread_pool* thread_, run_queue::executor exe_, void* data_)
+{
+  if (thread_ != nullptr)
+    thread_->resubmit(exe_, data_);
+  else
+    ::dispatch_async_f(static_cast<dispatch_queue_t>(target_), data_, exe_);
 }
 
+#endif
+
 } // anonymous namespace
 
-run_queue::pointer run_queue::create(const std::string& name_)
+const char run_queue::default_prefix[] = "si.digiverse.cool.ng.runner";
+
+run_queue::settings::settings(const runner::options& opts_, bool shared_)
+    : m_drain_limit(opts_.dedicated_thread() ? static_cast<std::size_t>(-1) : opts_.drain_limit())
+    , m_drain_time(opts_.dedicated_thread() ? std::chrono::microseconds(0) : opts_.drain_time())
+    , m_concurrent(opts_.policy() == RunPolicy::CONCURRENT && !opts_.dedicated_thread())
+    , m_shared(shared_)
+    , m_thread(create_thread(opts_))
+    , m_target(get_target(opts_, m_thread))
+    , m_metrics(opts_.collect_metrics() ? queue_metrics::create() : nullptr)
+    , m_bound(opts_.capacity() != runner::options::unbounded
+          ? queue_bound::create(opts_.capacity(), opts_.overflow())
+          : nullptr)
+    , m_drops(0)
+    , m_weight(opts_.dedicated_thread() ? 0 : opts_.fair_share())
+    , m_deficit(0)
+    , m_weighted(opts_.lane_policy() == LanePolicy::WEIGHTED)
+    , m_deadlines(opts_.deadline_order() ? new deadlines(opts_.on_late()) : nullptr)
+    , m_codel(opts_.shed_target().count() > 0
+          ? new queue_codel(opts_.shed_target(), opts_.shed_interval())
+          : nullptr)
+    , m_overload(opts_.on_overload())
+    , m_bucket(opts_.rate_limit() > 0
+          ? new token_bucket(opts_.rate_limit(), opts_.rate_interval(), opts_.rate_burst())
+          : nullptr)
+{ /* noop */ }
+
+run_queue::settings::~settings()
+{
+  if (m_metrics != nullptr)
+    m_metrics->release();
+  if (m_bound != nullptr)
+    m_bound->release();
+  if (m_thread != nullptr)
+    thread_pool::destroy(m_thread);
+  delete m_deadlines;
+  delete m_codel;
+  delete m_bucket;
+}
+
+namespace {
+
+// heap order, the entry with the earliest deadline and, among the entries
+// with the same deadline, the earliest arrival on the top
+template <typename T>
+inline bool later(const T& a_, const T& b_)
 {
-  auto ret = std::make_shared<run_queue>(name_);
-  ret->m_self = ret;
+  return a_.m_deadline > b_.m_deadline || (a_.m_deadline == b_.m_deadline && a_.m_seq > b_.m_seq);
+}
+
+} // anonymous namespace
+
+void run_queue::deadlines::push(context* ctx_)
+{
+  m_heap.push_back(entry { ctx_->m_deadline, m_seq++, ctx_ });
+  std::push_heap(m_heap.begin(), m_heap.end(), later<entry>);
+}
+
+run_queue::context* run_queue::deadlines::pop()
+{
+  std::pop_heap(m_heap.begin(), m_heap.end(), later<entry>);
+  auto ret = m_heap.back().m_context;
+  m_heap.pop_back();
   return ret;
 }
 
+// the clock is only read for the contexts that have a deadline and only if
+// there is someone to report them to
+bool run_queue::deadlines::is_late(const context* ctx_) const
+{
+  return m_handler
+      && ctx_->m_deadline != time_point::max()
+      && ctx_->m_deadline < runner::clock::now();
+}
+
+// Returns the settings shared by all run_queues with the same configuration,
+// or, if the run_queue needs any of the optional facilities, its own settings
+run_queue::settings* run_queue::get_settings(const runner::options& opts_)
+{
+  if (opts_.collect_metrics()
+      || opts_.capacity() != runner::options::unbounded
+      || opts_.dedicated_thread()
+      || opts_.fair_share() > 0
+      || opts_.deadline_order()
+      || opts_.shed_target().count() > 0
+      || opts_.rate_limit() > 0)
+    return new settings(opts_, false);
+
+  // never destroyed, the run_queues may still be destroyed during the
+  // static destruction
+  using key = std::tuple<std::size_t, std::size_t, RunPolicy, Priority, std::vector<unsigned int>, int, LanePolicy>;
+  static std::mutex* mutex_ = new std::mutex();
+  static std::map<key, settings*>* shared_ = new std::map<key, settings*>();
+
+  auto k = std::make_tuple(
+      opts_.drain_limit()
+    , static_cast<std::size_t>(opts_.drain_time().count())
+    , opts_.policy()
+    , opts_.priority()
+    , opts_.affinity()
+    , opts_.numa_node()
+    , opts_.lane_policy());
+
+  std::unique_lock<std::mutex> l(*mutex_);
+  auto it = shared_->find(k);
+  if (it != shared_->end())
+    return it->second;
+
+  auto ret = new settings(opts_, true);
+  shared_->emplace(k, ret);
+  return ret;
+}
+
+run_queue::pointer run_queue::create(const std::string& name_)
+{
+  return create(runner::options(), name_);
+}
+
+run_queue::pointer run_queue::create(const runner::options& opts_, const std::string& name_)
+{
+  return std::make_shared<run_queue>(name_, opts_);
+}
+
 void run_queue::release(const pointer& q_)
 {
-  q_->m_self.reset();
   q_->start();
 }
 
-run_queue::run_queue(const std::string& name_)
-    : named(name_)
-    , m_status(EMPTY_ACTIVE_NOT_BUSY)
+void run_queue::schedule(const time_point& when_, executor exe_, void* data_)
+{
+  timer_service::schedule(when_, exe_, data_);
+}
+
+run_queue::run_queue(const std::string& name_, const runner::options& opts_)
+    : m_status(ACTIVE)
+    , m_size(0)
+    , m_lanes(nullptr)
+    , m_settings(get_settings(opts_))
+    , m_name(nullptr)
 {
+  // the names with the default prefix are only created when asked for
+  if (name_ != default_prefix)
+    m_name = new std::string(name_ + "-" + std::to_string(id()));
 }
 
 run_queue::~run_queue()
 {
-  /* noop */
+  // the drain holds a reference to the queue, so it is only possible to get
+  // here with tasks still enqueued if the queue was never released
+  while (m_size > 0)
+    discard(pop_next());
+
+  if (!m_settings->m_shared)
+    delete m_settings;
+  delete m_lanes.load();
+  delete m_name.load();
+}
+
+const std::string& run_queue::name() const
+{
+  auto ret = m_name.load(std::memory_order_acquire);
+  if (ret != nullptr)
+    return *ret;
+
+  std::unique_ptr<std::string> name(new std::string(std::string(default_prefix) + "-" + std::to_string(id())));
+  if (m_name.compare_exchange_strong(ret, name.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+    ret = name.release();
+  return *ret;
+}
+
+run_queue::context* run_queue::make_context(executor exe_, deleter del_, deleter discard_, void* data_, const time_point& deadline_)
+{
+  auto ret = new context(exe_, del_, discard_, data_, this, deadline_);
+
+  if (m_settings->m_bound != nullptr)
+    ret->m_bound = m_settings->m_bound->add_ref();
+
+  if (m_settings->m_metrics != nullptr)
+  {
+    ret->m_metrics = m_settings->m_metrics->add_ref();
+    ret->m_enqueued = queue_metrics::clock::now();
+    m_settings->m_metrics->on_enqueue();
+  }
+  else if (m_settings->m_codel != nullptr)
+  {
+    ret->m_enqueued = queue_metrics::clock::now();
+  }
+
+  return ret;
+}
+
+// Executes and deletes the context
+void run_queue::execute(context* ctx_)
+{
+  auto metrics = ctx_->m_metrics;
+  auto bound = ctx_->m_bound;
+  queue_bound* outer = nullptr;
+
+  if (bound != nullptr)
+  {
+    bound->leave();
+    outer = queue_bound::current();
+    queue_bound::current() = bound;
+  }
+
+  if (metrics == nullptr)
+  {
+    // try/catch to intercept all exceptions thrown from the user code
+    try { (*(ctx_->m_executor))(ctx_->m_data); } catch (...) { /* noop */ }
+  }
+  else
+  {
+    auto start = queue_metrics::clock::now();
+    metrics->on_start(ctx_->m_enqueued, start);
+    try { (*(ctx_->m_executor))(ctx_->m_data); } catch (...) { /* noop */ }
+    metrics->on_finish(start, queue_metrics::clock::now());
+  }
+
+  if (bound != nullptr)
+    queue_bound::current() = outer;
+
+  delete ctx_;
+}
+
+// Deletes the context without execution
+void run_queue::discard(context* ctx_)
+{
+  if (ctx_->m_bound != nullptr)
+    ctx_->m_bound->leave();
+  if (ctx_->m_metrics != nullptr)
+    ctx_->m_metrics->on_drop();
+
+  if (ctx_->m_discard != nullptr && ctx_->m_data != nullptr)
+  {
+    (*ctx_->m_discard)(ctx_->m_data);
+    ctx_->m_data = nullptr;
+  }
+
+  delete ctx_;
+}
+
+// Discards the context that missed its deadline and reports it to the late
+// handler
+void run_queue::late(context* ctx_)
+{
+  auto deadline = ctx_->m_deadline;
+  discard(ctx_);
+  try { m_settings->m_deadlines->m_handler(deadline); } catch (...) { /* noop */ }
+}
+
+// Discards the context shed by the overloaded queue and reports it to the
+// overload handler
+void run_queue::overload(context* ctx_, const queue_codel::clock::time_point& now_)
+{
+  auto sojourn = now_ - ctx_->m_enqueued;
+  discard(ctx_);
+  if (m_settings->m_overload)
+    try { m_settings->m_overload(sojourn); } catch (...) { /* noop */ }
+}
+
+// Executes the context, unless it missed its deadline or is shed by the
+// overloaded queue. Must only be called by the holder of the BUSY bit.
+void run_queue::process(context* ctx_)
+{
+  auto& s = *m_settings;
+
+  if (s.m_deadlines != nullptr && s.m_deadlines->is_late(ctx_))
+  {
+    late(ctx_);
+    return;
+  }
+
+  if (s.m_codel != nullptr)
+  {
+    auto now = queue_codel::clock::now();
+    if (s.m_codel->shed(ctx_->m_enqueued, now, m_size.load() == 0))
+    {
+      overload(ctx_, now);
+      return;
+    }
+  }
+
+  execute(ctx_);
+}
+
+// Returns the mpsc_queue of the urgency lane, creating the lanes on the
+// first use. The run_queue with the deadline order has no lanes.
+mpsc_queue<run_queue::context>& run_queue::fifo(Urgency urgency_)
+{
+  if (urgency_ == Urgency::NORMAL || m_settings->m_deadlines != nullptr)
+    return m_fifo;
+
+  auto ret = m_lanes.load(std::memory_order_acquire);
+  if (ret == nullptr)
+  {
+    std::unique_ptr<lanes> aux(new lanes());
+    if (m_lanes.compare_exchange_strong(ret, aux.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+      ret = aux.release();
+  }
+  return ret->fifo(m_fifo, static_cast<int>(urgency_));
 }
 
-void run_queue::enqueue(executor exe_, deleter del_, void* data_)
+void run_queue::enqueue(executor exe_, deleter del_, void* data_, deleter discard_, Urgency urgency_, time_point deadline_)
 {
+  std::size_t drop = m_settings->m_bound != nullptr ? m_settings->m_bound->admit(1) : 0;
+  auto ctx = make_context(exe_, del_, discard_, data_, deadline_);
+
+  if (m_settings->m_concurrent && is_active())
   {
-    std::unique_lock<std::mutex> l(m_mutex);
-    m_fifo.push_back(context(exe_, del_, data_, m_self));
-    m_status &= ~EMPTY;
+    // the older contexts are already with the worker threads
+    if (drop > 0)
+      discard(ctx);
+    else
+      submit(m_settings->m_target, m_settings->m_thread, run_one, ctx);
+    return;
   }
 
+  fifo(urgency_).push(ctx);
+  ++m_size;
+  if (drop > 0)
+    m_settings->m_drops += drop;
+
   check_submit_next();
 }
 
-bool run_queue::check_submit_next()
+void run_queue::enqueue_batch(executor exe_, deleter del_, void* const* data_, std::size_t count_, deleter discard_, Urgency urgency_, time_point deadline_)
 {
-  int expect = NOT_EMPTY_ACTIVE_NOT_BUSY;
-  if (m_status.compare_exchange_strong(expect, NOT_EMPTY_ACTIVE_BUSY))
+  if (count_ == 0)
+    return;
+
+  std::size_t drop = m_settings->m_bound != nullptr ? m_settings->m_bound->admit(count_) : 0;
+
+  if (m_settings->m_concurrent && is_active())
   {
-    std::unique_lock<std::mutex> l(m_mutex);
-    m_running = m_fifo.front();
-    m_fifo.pop_front();
-    if (m_fifo.empty())
-      m_status |= EMPTY;
-    ::dispatch_async_f(get_global_queue(), &m_running, run_next);
+    for (std::size_t i = 0; i < count_; ++i)
+    {
+      auto ctx = make_context(exe_, del_, discard_, data_[i], deadline_);
+      if (i < drop)
+        discard(ctx);
+      else
+        submit(m_settings->m_target, m_settings->m_thread, run_one, ctx);
+    }
+    return;
+  }
 
-    return true;
+  // link all contexts into a chain first and then push the chain at once
+  auto first = make_context(exe_, del_, discard_, data_[0], deadline_);
+  auto last = first;
+  for (std::size_t i = 1; i < count_; ++i)
+  {
+    auto ctx = make_context(exe_, del_, discard_, data_[i], deadline_);
+    mpsc_queue<context>::link(last, ctx);
+    last = ctx;
+  }
+
+  fifo(urgency_).push(first, last);
+  m_size += static_cast<uint32_t>(count_);
+  if (drop > 0)
+    m_settings->m_drops += drop;
+
+  check_submit_next();
+}
+
+// Tries to acquire the BUSY status bit on behalf of the calling thread. If
+// successfull, the calling thread becomes the consumer of the task queue and
+// will submit the next context for execution. The concurrent queue submits
+// all its contexts and releases the BUSY bit immediately. The queue yielding
+// the worker thread after the drain resubmits itself behind the work of other
+// queues rather than to take the worker thread back immediately.
+bool run_queue::check_submit_next(bool yield_)
+{
+  if (m_settings->m_bound != nullptr)
+    pay_drops();
+
+  while (m_size.load() > 0)
+  {
+    int expect = ACTIVE;
+    if (!m_status.compare_exchange_strong(expect, ACTIVE | BUSY))
+      return false;
+
+    if (m_settings->m_bound != nullptr)
+      drop_oldest();
+
+    // the queue may have been drained by the previous owner of the BUSY bit
+    // between the size check and the acquisition of the BUSY bit
+    if (m_size.load() > 0)
+    {
+      if (!m_settings->m_concurrent)
+      {
+        // keeps the queue alive until the end of the drain
+        m_keep_alive = shared_from_this();
+        if (yield_)
+          resubmit(m_settings->m_target, m_settings->m_thread, run_next, pop_next());
+        else
+          submit(m_settings->m_target, m_settings->m_thread, run_next, pop_next());
+        return true;
+      }
+
+      while (m_size.load() > 0 && is_active())
+        submit(m_settings->m_target, m_settings->m_thread, run_one, pop_next());
+    }
+
+    m_status &= ~BUSY;
   }
 
   return false;
 }
 
+// Discards the oldest contexts owed to the DROP_OLDEST overflow policy. If the
+// BUSY bit is held by another thread, the holder will discard them instead.
+// Unlike check_submit_next() this works also while the queue is stopped.
+void run_queue::pay_drops()
+{
+  while (m_settings->m_drops.load() > 0)
+  {
+    if ((m_status.fetch_or(BUSY) & BUSY) != 0)
+      return;
+
+    drop_oldest();
+    m_status &= ~BUSY;
+  }
+}
+
+// Must only be called by the holder of the BUSY bit. The debt exceeding the
+// number of enqueued contexts is forgiven, as the contexts it was meant for
+// have already started. The contexts are discarded from the least urgent
+// lane first.
+void run_queue::drop_oldest()
+{
+  if (m_settings->m_drops.load() == 0)
+    return;
+
+  for (auto n = m_settings->m_drops.exchange(0); n > 0 && m_size.load() > 0; --n)
+    discard(pop_next(true));
+}
+
+// Must only be called by the holder of the BUSY bit and only if the queue is
+// known not to be empty. With lowest_ set the context is taken from the least
+// urgent lane that is not empty.
+// Must only be called by the holder of the BUSY bit, which is the only
+// consumer of the mpsc_queues and the only user of the heap
+bool run_queue::has_preferred(Urgency urgency_, const time_point& deadline_)
+{
+  if (m_settings->m_concurrent || m_size.load() == 0)
+    return false;
+
+  if (m_settings->m_deadlines != nullptr)
+  {
+    auto& d = *m_settings->m_deadlines;
+    return !m_fifo.empty() || (!d.empty() && !(deadline_ < d.m_heap.front().m_deadline));
+  }
+
+  auto l = m_lanes.load(std::memory_order_acquire);
+  for (int i = 0; i < static_cast<int>(urgency_); ++i)
+  {
+    if (l != nullptr)
+    {
+      if (!l->fifo(m_fifo, i).empty())
+        return true;
+    }
+    else if (i == static_cast<int>(Urgency::NORMAL) && !m_fifo.empty())
+      return true;
+  }
+  return false;
+}
+
+run_queue::context* run_queue::pop_next(bool lowest_)
+{
+  if (m_settings->m_deadlines != nullptr)
+    return pop_deadline();
+
+  context* ret;
+
+  // pop may fail if producer is just in the middle of push; it's short one
+  for (;;)
+  {
+    auto l = m_lanes.load(std::memory_order_acquire);
+    if ((ret = l == nullptr ? m_fifo.pop() : pop_lanes(l, lowest_)) != nullptr)
+      break;
+    std::this_thread::yield();
+  }
+
+  --m_size;
+  return ret;
+}
+
+// Moves the contexts from the mpsc_queue to the heap and pops the context
+// with the earliest deadline. Must only be called by the holder of the BUSY
+// bit and only if the queue is known not to be empty.
+run_queue::context* run_queue::pop_deadline()
+{
+  auto& d = *m_settings->m_deadlines;
+
+  for (;;)
+  {
+    context* ctx;
+    while ((ctx = m_fifo.pop()) != nullptr)
+      d.push(ctx);
+    if (!d.empty())
+      break;
+
+    // pop may fail if producer is just in the middle of push; it's short one
+    std::this_thread::yield();
+  }
+
+  --m_size;
+  return d.pop();
+}
+
+// Pops the next context from the lanes as set by the lane policy, or returns
+// nullptr if all lanes appear empty. Must only be called by the holder of the
+// BUSY bit.
+run_queue::context* run_queue::pop_lanes(lanes* lanes_, bool lowest_)
+{
+  // contexts per round of each lane, in the order of Urgency enumerators
+  static const unsigned int weights_[lanes::count] = { 8, 4, 2, 1 };
+  context* ret;
+
+  if (lowest_)
+  {
+    for (int i = lanes::count - 1; i >= 0; --i)
+      if ((ret = lanes_->fifo(m_fifo, i).pop()) != nullptr)
+        return ret;
+    return nullptr;
+  }
+
+  if (!m_settings->m_weighted)
+  {
+    for (int i = 0; i < lanes::count; ++i)
+      if ((ret = lanes_->fifo(m_fifo, i).pop()) != nullptr)
+        return ret;
+    return nullptr;
+  }
+
+  // the lane that is out of credit or out of contexts passes the turn to the
+  // next lane of the round
+  for (int i = 0; i < lanes::count; ++i)
+  {
+    if (lanes_->m_credit == 0)
+    {
+      lanes_->m_lane = (lanes_->m_lane + 1) % lanes::count;
+      lanes_->m_credit = weights_[lanes_->m_lane];
+    }
+
+    if ((ret = lanes_->fifo(m_fifo, lanes_->m_lane).pop()) != nullptr)
+    {
+      --lanes_->m_credit;
+      return ret;
+    }
+    lanes_->m_credit = 0;
+  }
+  return nullptr;
+}
+
+// Executes the context and then continues with the next contexts from the
+// queue until the queue is empty or stopped, or one of drain limits is hit.
+// The fair queue also stops when its deficit is spent. Must only be called by
+// the holder of the BUSY bit.
+void run_queue::drain(context* ctx_)
+{
+  using clock = std::chrono::steady_clock;
+
+  auto& s = *m_settings;
+  const bool fair = s.m_weight > 0;
+  const bool timed = s.m_drain_time.count() > 0;
+  const std::size_t limit = fair ? s.m_drain_limit * s.m_weight : s.m_drain_limit;
+
+  clock::time_point start;
+  clock::time_point deadline;
+  if (timed)
+  {
+    start = clock::now();
+    deadline = start + s.m_drain_time;
+  }
+
+  for (std::size_t count = 1; ; ++count)
+  {
+    process(ctx_);
+
+    if (s.m_bound != nullptr)
+      drop_oldest();
+
+    if (fair && timed)
+    {
+      // charge the task against the deficit
+      auto now = clock::now();
+      s.m_deficit -= std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+      start = now;
+    }
+
+    if (m_size.load() == 0 || !is_active())
+    {
+      // unused deficit is forfeited, the debt is kept
+      if (fair && s.m_deficit > 0)
+        s.m_deficit = 0;
+      break;
+    }
+    if (count >= limit)
+      break;
+    if (fair ? timed && s.m_deficit <= 0 : timed && clock::now() >= deadline)
+      break;
+    if (s.m_bucket != nullptr && !s.m_bucket->take(clock::now()))
+      break;
+
+    ctx_ = pop_next();
+  }
+}
+
+// Adds the quantum to the fair queue's deficit at the start of its turn and
+// returns false if the queue is to give up the turn to pay its debt. Must only
+// be called by the holder of the BUSY bit.
+bool run_queue::take_turn()
+{
+  auto& s = *m_settings;
+  if (s.m_drain_time.count() == 0)
+    return true;
+
+  s.m_deficit += std::chrono::duration_cast<std::chrono::nanoseconds>(s.m_drain_time).count() * s.m_weight;
+  return s.m_deficit > 0;
+}
+
 void run_queue::run_next(void* data_)
 {
   auto ctx = static_cast<context*>(data_);
   auto queue = ctx->m_queue;
 
-  // try/catch to intercept all exceptions thrown from the user code
-  try { (*(ctx->m_executor))(ctx->m_data); } catch (...) { /* noop */ }
-  ctx->clear();
+  // the queue in debt keeps the BUSY bit, the reference and the context
+  // and waits for its next turn behind the work of other queues
+  if (queue->m_settings->m_weight > 0 && !queue->take_turn())
+  {
+    resubmit(queue->m_settings->m_target, queue->m_settings->m_thread, run_next, ctx);
+    return;
+  }
+
+  run_drain(data_);
+}
+
+// Takes the token for the first context, if the queue is rate limited, and
+// drains the queue
+void run_queue::run_drain(void* data_)
+{
+  auto ctx = static_cast<context*>(data_);
+  auto queue = ctx->m_queue;
+
+  // the queue out of tokens keeps the BUSY bit, the reference and the
+  // context and waits on the timer, rather than on the worker thread
+  auto bucket = queue->m_settings->m_bucket;
+  if (bucket != nullptr && !bucket->take(token_bucket::clock::now()))
+  {
+    timer_service::schedule(bucket->next(), wake, ctx);
+    return;
+  }
+
+  queue->drain(ctx);
 
+  // the queue may cease to exist once the BUSY bit is released, unless the
+  // drain is resubmitted
+  auto self = std::move(queue->m_keep_alive);
   queue->m_status &= ~BUSY;
-  queue->check_submit_next();
+  queue->check_submit_next(true);
+}
+
+// Called from the timer thread when the next token of the rate limited
+// queue is due
+void run_queue::wake(void* data_)
+{
+  auto& s = *static_cast<context*>(data_)->m_queue->m_settings;
+  submit(s.m_target, s.m_thread, run_drain, data_);
+}
+
+// Executes a single context of the concurrent queue
+void run_queue::run_one(void* data_)
+{
+  execute(static_cast<context*>(data_));
+}
+
+void run_queue::location(runner::placement& p_) const
+{
+  get_location(m_settings->m_target, m_settings->m_thread, p_);
 }
 
 void run_queue::stop()
@@ -26,10 +26,18 @@
 
 #include <atomic>
 #include <memory>
-#include <mutex>
-#include <deque>
-#include <dispatch/dispatch.h>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <vector>
 #include "cool/ng/bases.h"
+#include "cool/ng/async/runner.h"
+#include "lib/async/mpsc_queue.h"
+#include "lib/async/object_pool.h"
+#include "lib/async/queue_metrics.h"
+#include "lib/async/queue_bound.h"
+#include "lib/async/queue_codel.h"
+#include "lib/async/token_bucket.h"
 
 /*
   Notes on run_queue:
@@ -51,6 +59,12 @@
   create() method to create a new run_queue. Do not use ctor directly; the ctor
   is public only to permit the use of std::make_shared inside create().
 
+  1.1.1 create(const runner::options& opts_, const std::string& name_)
+
+  Creates a run_queue with a given name and configuration and returns a shared
+  pointer to it. The configuration parameters not supported by the run_queue
+  implementation are ignored.
+
   1.1.1 release(const std::shared_ptr& queue_)
 
   Releases the run_queue. Note that without calling this method the run_queue may
@@ -64,7 +78,7 @@
 
   1.2 Posting Tasks to Execute
 
-  1.2.1 enqueue(executor exe_, deleter del_, void* data_)
+  1.2.1 enqueue(executor exe_, deleter del_, void* data_, deleter discard_, Urgency urgency_, time_point deadline_)
 
   Enqueues the request to call the execution function exe_ with the data pointer
   specified as data_ as soon as possible but after the previous request posted to
@@ -76,9 +90,67 @@
   enqueueing a new task after a call to release() is platform dependent and
   undefined.
 
+  If the request is discarded without the execution, the data will be deleted
+  by the discard function discard_ instead, or, if discard_ is nullptr, by the
+  deletion function del_. This permits the execution function to take over the
+  ownership of the data while the run_queue can still delete the data it did
+  not execute.
+
+  The request is placed in the lane of its urgency urgency_. The sequential
+  run_queue executes the requests of the more urgent lanes ahead of the
+  requests of the less urgent lanes, either strictly or in weighted rounds,
+  as set by the lane policy, and the requests of the same lane in the order
+  of their submission. See 3. for details.
+
+  The run_queue created with the deadline order ignores the urgency and
+  executes the request with the earliest deadline deadline_ first instead.
+  The requests without the deadline, denoted by time_point::max(), come
+  after all requests with the deadline and the requests with the same
+  deadline are executed in the order of their submission. If the run_queue
+  has the late handler set and the deadline of the request has passed by the
+  time it would start, the request is discarded instead and the handler is
+  called with its deadline.
+
+  The run_queue created with the load shedding enabled sheds the requests
+  while it is overloaded, as decided by the CoDel algorithm from the time
+  the requests wait in the queue. The shed request is discarded and the
+  overload handler, if set, is called with its waiting time.
+
+  If the run_queue is bounded and full, enqueue() will either block, throw
+  queue_full exception or discard the oldest request, as set by the overflow
+  policy (see 1.4). If enqueue() throws, the ownership of data remains with
+  the caller.
+
   enqueue() is thread safe. This method, or any other thread-safe methods, may
   be called simultaneously from multiple threads.
 
+  1.2.2 enqueue_batch(executor exe_, deleter del_, void* const* data_, std::size_t count_, deleter discard_, Urgency urgency_, time_point deadline_)
+
+  Enqueues count_ requests to call the execution function exe_, one for each
+  of the data pointers in the data_ array, as if enqueue() was called for
+  each of them in the array order. The requests of the batch are enqueued
+  in a single queue operation, all in the lane of urgency urgency_ and with
+  the deadline deadline_, and are not interleaved with the requests enqueued
+  by other threads.
+
+  enqueue_batch() is thread safe. This method, or any other thread-safe
+  methods, may be called simultaneously from multiple threads.
+
+  The bounded run_queue admits the batch as a whole, or not at all.
+
+  1.2.3 schedule(const time_point& when_, executor exe_, void* data_)
+
+  This method is static. Requests the call of the function exe_ with the data
+  pointer data_ at time when_, or as soon as possible if when_ has already
+  passed. The call is not associated with any run_queue and is made from the
+  timer thread of the timer_service, hence exe_ must be short and must not
+  block; it is meant to enqueue the delayed work to its run_queue. The
+  bounded run_queue with OverflowPolicy::BLOCK throws queue_full exception
+  instead of blocking the timer thread when full. The request costs a heap
+  insert and cannot be cancelled.
+
+  schedule() is thread safe.
+
   1.3 Starting and Stopping the Task Execution
 
   When created, the run_queue is active and will be executing the tasks as soon as
@@ -113,6 +185,38 @@
   is_active() is thread safe. This method, or any other thread-safe methods, may
   be called simultaneously from multiple threads.
 
+  1.3.4 has_preferred(Urgency urgency_, time_point deadline_)
+
+  Returns true if the sequential run_queue holds the waiting requests that
+  it would execute before the request of urgency urgency_ and deadline
+  deadline_ enqueued now: the requests of the more urgent lanes or, with the
+  deadline order, the requests with the earlier or the same deadline. The
+  run_queue with the deadline order also returns true if it holds the
+  requests not yet sorted by the deadline. The concurrent run_queue always
+  returns false.
+
+  has_preferred() is not thread safe. It may only be called from the request
+  the run_queue is executing, as it inspects the queues only the executing
+  thread may consume.
+
+  1.4 Bounded run_queue
+
+  The run_queue created with the capacity set in runner::options is bounded:
+  it keeps at most capacity requests that are enqueued but not yet started.
+  When full, the run_queue applies the overflow policy to the new requests:
+
+    - OverflowPolicy::BLOCK blocks the enqueueing thread until the run_queue
+      starts one of the waiting requests. The request enqueued by the task
+      executing on the same run_queue is accepted over the capacity instead,
+      as blocking it would deadlock the run_queue.
+    - OverflowPolicy::REJECT throws queue_full exception.
+    - OverflowPolicy::DROP_OLDEST accepts the new request and discards the
+      oldest waiting request of the least urgent lane, or, with the
+      deadline order, the request with the earliest deadline. The active
+      concurrent run_queue hands its requests over to the worker threads
+      at once and cannot get them back, hence it discards the new request
+      instead.
+
   2. Behavior on Destruction
 
   The call to release(), which is mandatory before the queue instance is
@@ -122,79 +226,333 @@
   moment of when the run_queue instance will cease to exist is platform dependent
   and thus undefined, it will certainly no longer exist immediatelly after the
   execution of the last task completes.
+
+  3. Implementation Notes
+
+  The enqueued tasks are kept in the intrusive lock-free mpsc_queue, with the
+  queue node embedded in the task context. Producers never take a lock; they
+  push the context, increment the element count and try to acquire the BUSY
+  status bit. The thread that acquires the BUSY bit becomes the only consumer
+  of the queue until it submits the popped context to the worker threads and,
+  after the execution of the context, clears the BUSY bit again.
+
+  The worker threads are provided either by the libdispatch global queue
+  (GCD_DEQUE task runner implementation) or by the library's own thread_pool
+  (POSIX_POOL task runner implementation). The run_queue submits its work to
+  the global queue, or to the thread_pool, of its priority class and, with
+  the thread_pool, of its placement. Only the thread_pool steals the work
+  between its worker threads; with GCD_DEQUE the concurrent run_queue hands
+  its contexts to the global queue and libdispatch decides which thread runs
+  them, hence the work stealing and the preference for the submitting
+  worker thread require the POSIX_POOL task runner implementation.
+
+  The run_queue created with the dedicated thread option owns a private
+  thread_pool with a single worker thread and submits its work there instead,
+  with either task runner implementation. Since no other run_queue shares the
+  thread the drain limits are not applied; the run_queue is also always
+  sequential. The private thread_pool is destroyed with the run_queue.
+
+  To save the scheduling round trip per task, the worker thread executing the
+  context will continue to pop and execute the subsequent contexts from the
+  queue for as long as the queue is active, not empty, and the drain limits
+  (number of tasks and time budget) set at the creation are not exceeded.
+  Since the worker keeps the BUSY bit for the entire drain the sequential
+  execution guarantee is preserved. After the drain the run_queue resubmits
+  itself behind the work already waiting for the worker threads, to give the
+  other run_queues sharing the worker threads their turn.
+
+  The contexts do not hold a reference to the run_queue. Instead, the thread
+  acquiring the BUSY bit to submit the run_queue to the worker threads also
+  acquires a reference to the run_queue and holds it until the BUSY bit is
+  released at the end of the drain, or passes it on to the next drain. The
+  reference counter is thus touched once per drain rather than twice per
+  task. The contexts themselves are allocated from the object_pool.
+
+  The run_queue created with the metrics collection enabled owns the
+  queue_metrics object and stamps each context with the time of enqueue.
+  Otherwise the contexts' metrics pointer is nullptr and the execution path
+  only tests it.
+
+  The bounded run_queue owns the queue_bound object that counts the contexts
+  not yet started and applies the overflow policy. The producer that must
+  discard the oldest contexts cannot pop them from the mpsc_queue unless it
+  holds the BUSY bit; it thus records the number of contexts to discard in
+  m_drops and the holder of the BUSY bit, either the producer itself or the
+  current drain, discards them before it takes the next context.
+
+  The applications may create a run_queue for each of a large number of
+  objects, such as connections, hence the idle run_queue is kept small. The
+  configuration and the optional facilities (metrics, bound, dedicated
+  thread and fair scheduling) are kept in the settings object. The
+  run_queues that use none of the optional facilities share the settings
+  with all run_queues of the same configuration; the others own theirs. The
+  name of the run_queue with the default prefix is only created on the first
+  call to name(). The run_queue does not keep a reference to itself; the
+  references are held by the runner and, while the run_queue has work, by
+  the drain. The memory for the task contexts comes from the object_pool and
+  is only taken while the tasks are waiting or executing. The idle runner
+  takes 136 bytes on 64-bit platforms, which is more than the few dozen
+  bytes aimed at. The run_queue itself takes 96 bytes:
+
+    - 8 bytes for the id,
+    - 16 bytes for the weak self-reference of std::enable_shared_from_this,
+    - 8 bytes for the status bits and the separate 32 bit element count,
+    - 24 bytes for the mpsc_queue with its stub node,
+    - 16 bytes for the drain's reference (m_keep_alive), and
+    - 24 bytes for the lanes, settings and name pointers.
+
+  The control block of std::make_shared adds 16 bytes and the runner 24
+  bytes. The 32 bytes of the two references are there because the runner API
+  hands out the run_queue as std::shared_ptr and the drain must keep the
+  run_queue alive after its runner is gone; an intrusive reference count in
+  their place would bring the idle runner down to about 100 bytes, but every
+  path that releases the BUSY bit would then have to take part in the
+  destruction of the run_queue.
+
+  The fair run_queue (see runner::options::fair_share()) schedules its drains
+  with the deficit round robin. Each drain, or turn, adds the drain time
+  budget multiplied by the weight to the run_queue's deficit and the drain
+  subtracts the measured execution time of each task. The drain ends when
+  the deficit is spent, or after the drain limit multiplied by the weight
+  tasks. The positive deficit left when the run_queue runs empty is
+  forfeited while the negative deficit, the debt, is carried to the next
+  turns. If the deficit is still not positive at the start of the turn, the
+  drain resubmits itself behind the work of other run_queues without
+  executing anything, keeping the BUSY bit and the popped context. The
+  deficit is only touched by the holder of the BUSY bit. The fair run_queue
+  owns its settings.
+
+  The requests of Urgency::NORMAL, which is the urgency of all requests
+  unless specified otherwise, are kept in the run_queue's mpsc_queue. The
+  mpsc_queues of the other urgency lanes are kept in the lanes object that
+  is only created by the first request of urgency other than NORMAL; the
+  run_queue that never sees such request pays a single pointer for the
+  lanes. The element count covers all lanes. The holder of the BUSY bit
+  pops the next context from the most urgent lane that is not empty with
+  LanePolicy::STRICT, or, with LanePolicy::WEIGHTED, from the lane being
+  served in the current round until it has taken its share of contexts or
+  is empty. The lane that is empty only because its producer is in the
+  middle of the push is skipped; the order among the requests of different
+  lanes submitted at the same time is not defined anyway. The contexts
+  owed to the DROP_OLDEST overflow policy are taken from the least urgent
+  lane first.
+
+  The run_queue created with the deadline order owns its settings, which
+  hold the deadlines object with the binary heap of contexts ordered by
+  the deadline and the sequence number of arrival. The producers still push
+  the contexts to the mpsc_queue, all to the one of Urgency::NORMAL to keep
+  the order of submission; the holder of the BUSY bit moves all contexts it
+  finds there to the heap before it takes the next context from the top of
+  the heap. The element count covers the contexts in the heap.
+  Since only the BUSY holder touches the heap it needs no lock. The drain
+  checks the deadline of the context just before it would execute it, but
+  only if the late handler is set and the context has a deadline. The late
+  context is discarded, which also counts it as dropped in the metrics.
+
+  The run_queue created with the load shedding enabled owns its settings,
+  which hold the queue_codel object, and stamps each context with the time
+  of enqueue, like the run_queue collecting the metrics. The drain asks the
+  queue_codel whether to shed the context just before it would execute it,
+  after the deadline check. The shed context is discarded the same way as
+  the late context, and, like the deadline order, the load shedding does
+  not apply to the contexts the concurrent run_queue submits directly.
+
+  The rate limited run_queue owns its settings, which hold the token_bucket
+  object. The drain takes a token before it starts each context, in
+  run_drain() for the first context and in drain() for the next contexts.
+  If the bucket is empty, drain() ends the drain and run_drain(), holding
+  the BUSY bit, the reference and the popped context, asks the
+  timer_service to call wake() when the next token is due, and returns the
+  worker thread. wake() submits run_drain() to the worker threads again.
+  Like the fair run_queue in debt, the rate limited run_queue thus never
+  holds a worker thread while it waits, and since the run_queue keeps the
+  BUSY bit, the producers do not submit it in the meantime.
+
+  The run_queue created with RunPolicy::CONCURRENT policy submits each
+  context to the worker threads directly from enqueue(), without passing
+  through the mpsc_queue and regardless of its urgency. The mpsc_queue is
+  only used to hold the contexts enqueued while the run_queue is inactive;
+  start() then submits them all.
 */
 
 namespace cool { namespace ng { namespace async { namespace impl {
 
-class run_queue : public ::cool::ng::util::named
+class thread_pool;
+
+class run_queue : public ::cool::ng::util::identified<::cool::ng::util::detail::id_policy::unique_on_copy>
+                , public std::enable_shared_from_this<run_queue>
 {
  public:
   using deleter = void (*)(void*);
   using executor = void (*)(void*);
+  using time_point = runner::clock::time_point;
   using pointer = std::shared_ptr<run_queue>;
 
  private:
   enum : int {
-      EMPTY =  0x04
-    , ACTIVE = 0x02
+      ACTIVE = 0x02
     , BUSY   = 0x01
-    , NOT_EMPTY_ACTIVE_NOT_BUSY = ACTIVE
-    , NOT_EMPTY_ACTIVE_BUSY     = ACTIVE | BUSY
-    , EMPTY_ACTIVE_NOT_BUSY     = EMPTY | ACTIVE
   };
 
-  struct context
+  struct context : public mpsc_node
   {
-    context() : m_executor(nullptr), m_deleter(nullptr), m_data(nullptr)
-    { /* noop */ }
-    context(executor exe_, deleter del_, void* data_, const pointer& q_)
-      : m_executor(exe_), m_deleter(del_), m_data(data_), m_queue(q_)
+    context(executor exe_, deleter del_, deleter discard_, void* data_, run_queue* q_, const time_point& deadline_)
+      : m_executor(exe_), m_deleter(del_), m_discard(discard_), m_data(data_)
+      , m_queue(q_), m_metrics(nullptr), m_bound(nullptr), m_deadline(deadline_)
     { /* noop */ }
     ~context()
     {
       if (m_deleter && m_data)
         (*m_deleter)(m_data);
+      if (m_metrics != nullptr)
+        m_metrics->release();
+      if (m_bound != nullptr)
+        m_bound->release();
+    }
+    static void* operator new(std::size_t)
+    {
+      return object_pool<context>::allocate();
+    }
+    static void operator delete(void* p_)
+    {
+      object_pool<context>::deallocate(p_);
     }
 
-    void clear()
+    executor   m_executor;
+    deleter    m_deleter;
+    deleter    m_discard;
+    void       *m_data;
+    run_queue* m_queue;
+    queue_metrics* m_metrics;                  // only if metrics are collected
+    queue_metrics::clock::time_point m_enqueued;  // only if metrics are collected or load is shed
+    queue_bound* m_bound;                      // only if the queue is bounded
+    time_point m_deadline;                     // time_point::max() if none
+  };
+
+  // contexts of the run_queue with the deadline order, moved from the
+  // mpsc_queues by the BUSY holder and only used by the BUSY holder
+  struct deadlines
+  {
+    struct entry
     {
-      m_queue.reset();
-      if (m_deleter && m_data)
-        (*m_deleter)(m_data);
-      m_data = nullptr;
+      time_point m_deadline;
+      uint64_t   m_seq;
+      context*   m_context;
+    };
+
+    explicit deadlines(const runner::late_handler& handler_) : m_seq(0), m_handler(handler_)
+    { /* noop */ }
+    void push(context* ctx_);
+    context* pop();
+    bool empty() const { return m_heap.empty(); }
+    bool is_late(const context* ctx_) const;
+
+    std::vector<entry>   m_heap;      // earliest deadline on the top
+    uint64_t             m_seq;       // sequence number of the next arrival
+    runner::late_handler m_handler;   // may be empty
+  };
+
+  // configuration and the optional facilities of the run_queue
+  struct settings
+  {
+    settings(const runner::options& opts_, bool shared_);
+    ~settings();
+
+    const std::size_t               m_drain_limit;
+    const std::chrono::microseconds m_drain_time;
+    const bool                      m_concurrent;
+    const bool                      m_shared;     // shared by run_queues of the same configuration
+    thread_pool* const              m_thread;     // dedicated thread, nullptr if none
+    void* const                     m_target;     // thread_pool or dispatch queue to submit to
+    queue_metrics* const            m_metrics;    // nullptr if metrics are not collected
+    queue_bound* const              m_bound;      // nullptr if the queue is not bounded
+    std::atomic<std::size_t>        m_drops;      // number of oldest contexts to discard
+    const unsigned int              m_weight;     // 0 if not fair
+    int64_t                         m_deficit;    // fair only, in ns, used by the BUSY holder
+    const bool                      m_weighted;   // LanePolicy::WEIGHTED
+    deadlines* const                m_deadlines;  // nullptr if not in the deadline order
+    queue_codel* const              m_codel;      // nullptr if the load is not shed
+    const runner::overload_handler  m_overload;   // may be empty
+    token_bucket* const             m_bucket;     // nullptr if the rate is not limited
+  };
+
+  // the lanes of urgencies other than Urgency::NORMAL, which uses m_fifo
+  // of the run_queue; created on the first use
+  struct lanes
+  {
+    static const int count = 4;   // number of Urgency enumerators
+
+    lanes() : m_lane(count - 1), m_credit(0)
+    { /* noop */ }
+    mpsc_queue<context>& fifo(mpsc_queue<context>& normal_, int lane_)
+    {
+      const int normal = static_cast<int>(Urgency::NORMAL);
+      return lane_ == normal ? normal_ : m_fifo[lane_ < normal ? lane_ : lane_ - 1];
     }
 
-    executor m_executor;
-    deleter  m_deleter;
-    void     *m_data;
-    pointer  m_queue;
+    mpsc_queue<context> m_fifo[count - 1];
+    int                 m_lane;     // weighted only, lane served in this round, BUSY holder only
+    unsigned int        m_credit;   // weighted only, contexts left to the lane in this round
   };
 
  public:
-  static pointer create(const std::string& name_ = "si.digiverse.cool.ng.runner");
+  static const char default_prefix[];
+
+  static pointer create(const std::string& name_ = default_prefix);
+  static pointer create(const runner::options& opts_, const std::string& name_ = default_prefix);
   static void release(const pointer& arg);
+  static void schedule(const time_point& when_, executor exe_, void* data_);
 
   // --- Do not use ctor directly; use create instead.
   // --- Ctor is public only to permit the use of std::make_shared
-  run_queue(const std::string& name_);
+  run_queue(const std::string& name_, const runner::options& opts_);
   ~run_queue();
 
-  void enqueue(executor exe_, deleter del_, void* data_);
+  const std::string& name() const;
+  void enqueue(executor exe_, deleter del_, void* data_, deleter discard_ = nullptr, Urgency urgency_ = Urgency::NORMAL, time_point deadline_ = time_point::max());
+  void enqueue_batch(executor exe_, deleter del_, void* const* data_, std::size_t count_, deleter discard_ = nullptr, Urgency urgency_ = Urgency::NORMAL, time_point deadline_ = time_point::max());
   void stop();
   void start();
   bool is_active() const { return (m_status.load() & ACTIVE) != 0; }
+  void snapshot(runner::metrics& m_) const
+  {
+    if (m_settings->m_metrics != nullptr)
+      m_settings->m_metrics->snapshot(m_);
+  }
+  void location(runner::placement& p_) const;
+  std::size_t depth() const { return m_size.load(); }
+  bool has_preferred(Urgency urgency_, const time_point& deadline_);
 
  private:
-  bool check_submit_next();
+  static settings* get_settings(const runner::options& opts_);
+  bool check_submit_next(bool yield_ = false);
+  mpsc_queue<context>& fifo(Urgency urgency_);
+  context* pop_next(bool lowest_ = false);
+  context* pop_lanes(lanes* lanes_, bool lowest_);
+  context* pop_deadline();
+  context* make_context(executor exe_, deleter del_, deleter discard_, void* data_, const time_point& deadline_);
+  static void execute(context*);
+  static void discard(context*);
+  void late(context*);
+  void overload(context*, const queue_codel::clock::time_point& now_);
+  void process(context*);
+  void pay_drops();
+  void drop_oldest();
+  void drain(context*);
+  bool take_turn();
   static void run_next(void *);
+  static void run_drain(void *);
+  static void wake(void *);
+  static void run_one(void *);
 
  private:
-  std::atomic<int>    m_status;
-
-  std::mutex          m_mutex;
-  std::deque<context> m_fifo;
-  context             m_running; // currently running context
-  pointer             m_self;
+  std::atomic<int>          m_status;
+  std::atomic<uint32_t>     m_size;     // number of enqueued contexts, next to m_status
+  mpsc_queue<context>       m_fifo;     // Urgency::NORMAL lane
+  std::atomic<lanes*>       m_lanes;    // other lanes, created on first use
+  pointer                   m_keep_alive; // held by the holder of the BUSY bit
+  settings* const           m_settings;
+  mutable std::atomic<std::string*> m_name; // created on first use if default
 };
 
 } } } }// namespace
@@ -28,11 +28,17 @@ namespace cool { namespace ng { namespace async { namespace impl {
 
 namespace {
 
-dispatch_queue_t& get_global_queue()
+dispatch_queue_t get_global_queue(Priority priority_)
 {
-  static dispatch_queue_t global_ = ::dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+  // in the order of Priority enumerators
+  static const dispatch_queue_t global_[] = {
+      ::dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0)
+    , ::dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0)
+    , ::dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0)
+    , ::dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0)
+  };
 
-  return global_;
+  return global_[static_cast<int>(priority_)];
 }
 
 } // anonymous namespace
@@ -42,16 +48,22 @@ run_queue::pointer run_queue::create(const std::string& name_)
   return std::make_shared<run_queue>(name_);
 }
 
+run_queue::pointer run_queue::create(const runner::options& opts_, const std::string& name_)
+{
+  return std::make_shared<run_queue>(name_, opts_.policy() == RunPolicy::CONCURRENT, opts_.priority());
+}
+
 void run_queue::release(const pointer& q_)
 {
   /* noop */
 }
 
-run_queue::run_queue(const std::string& name_)
+run_queue::run_queue(const std::string& name_, bool concurrent_, Priority priority_)
     : named(name_)
     , m_active(true)
 {
-  m_queue = dispatch_queue_create_with_target(name().c_str(), NULL, get_global_queue());
+  m_queue = dispatch_queue_create_with_target(
+      name().c_str(), concurrent_ ? DISPATCH_QUEUE_CONCURRENT : NULL, get_global_queue(priority_));
 }
 
 run_queue::~run_queue()
@@ -60,11 +72,27 @@ run_queue::~run_queue()
   dispatch_release(m_queue);
 }
 
-void run_queue::enqueue(executor exe_, deleter del_, void* data_)
+void run_queue::enqueue(executor exe_, deleter del_, void* data_, deleter, Urgency, time_point)
 {
   ::dispatch_async_f(m_queue, data_, exe_);
 }
 
+void run_queue::enqueue_batch(executor exe_, deleter del_, void* const* data_, std::size_t count_, deleter, Urgency, time_point)
+{
+  for (std::size_t i = 0; i < count_; ++i)
+    ::dispatch_async_f(m_queue, data_[i], exe_);
+}
+
+void run_queue::schedule(const time_point& when_, executor exe_, void* data_)
+{
+  auto delay = std::chrono::duration_cast<std::chrono::nanoseconds>(when_ - runner::clock::now()).count();
+  ::dispatch_after_f(
+      ::dispatch_time(DISPATCH_TIME_NOW, delay > 0 ? delay : 0)
+    , get_global_queue(Priority::DEFAULT)
+    , data_
+    , exe_);
+}
+
 void run_queue::start()
 {
   bool expect = false;
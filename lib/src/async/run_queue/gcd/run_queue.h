@@ -29,6 +29,7 @@
 #include <string>
 #include <dispatch/dispatch.h>
 #include "cool/ng/bases.h"
+#include "cool/ng/async/runner.h"
 
 /*
   Notes on run_queue:
@@ -63,7 +64,7 @@
 
   1.2 Posting Tasks to Execute
 
-  1.2.1 enqueue(executor exe_, deleter del_, void* data_)
+  1.2.1 enqueue(executor exe_, deleter del_, void* data_, deleter discard_, Urgency urgency_, time_point deadline_)
 
   Enqueues the request to call the execution function exe_ with the data pointer
   specified as data_ as soon as possible but after the previous request posted to
@@ -75,9 +76,36 @@
   enqueueing a new task after a call to release() is platform dependent and
   undefined.
 
+  This run_queue never discards the requests, nor does it support the bounded
+  queues; the discard function discard_ is ignored.
+
+  This run_queue executes the requests in the order of submission; the
+  urgency urgency_ and the deadline deadline_ are ignored.
+
   enqueue() is thread safe. This method, or any other thread-safe methods, may
   be called simultaneously from multiple threads.
 
+  1.2.2 enqueue_batch(executor exe_, deleter del_, void* const* data_, std::size_t count_, deleter discard_, Urgency urgency_, time_point deadline_)
+
+  Enqueues count_ requests to call the execution function exe_, one for each
+  of the data pointers in the data_ array, as if enqueue() was called for
+  each of them in the array order. The requests of the batch are submitted
+  to the dispatch queue one after another and may interleave with the
+  requests enqueued by other threads.
+
+  enqueue_batch() is thread safe. This method, or any other thread-safe
+  methods, may be called simultaneously from multiple threads.
+
+  1.2.3 schedule(const time_point& when_, executor exe_, void* data_)
+
+  This method is static. Requests the call of the function exe_ with the data
+  pointer data_ at time when_, or as soon as possible if when_ has already
+  passed. The call is not associated with any run_queue and is made through
+  dispatch_after_f() on the default global queue; exe_ is meant to enqueue the
+  delayed work to its run_queue. The request cannot be cancelled.
+
+  schedule() is thread safe.
+
   1.3 Starting and Stopping the Task Execution
 
   When created, the run_queue is active and will be executing the tasks as soon as
@@ -130,21 +158,33 @@ class run_queue : public ::cool::ng::util::named
  public:
   using deleter =  void (*)(void*);
   using executor = void (*)(void*);
+  using time_point = runner::clock::time_point;
   using pointer = std::shared_ptr<run_queue>;
 
  public:
   static pointer create(const std::string& name_ = "si.digiverse.cool.ng.runner");
+  static pointer create(const runner::options& opts_, const std::string& name_ = "si.digiverse.cool.ng.runner");
   static void release(const pointer& arg);
+  static void schedule(const time_point& when_, executor exe_, void* data_);
 
   // --- Do not use ctor directly; use create instead.
   // --- Ctor is public only to permit the use of std::make_shared
-  run_queue(const std::string& name_);
+  run_queue(const std::string& name_, bool concurrent_ = false, Priority priority_ = Priority::DEFAULT);
   ~run_queue();
 
-  void enqueue(executor exe_, deleter del_, void* data_);
+  void enqueue(executor exe_, deleter del_, void* data_, deleter discard_ = nullptr, Urgency urgency_ = Urgency::NORMAL, time_point deadline_ = time_point::max());
+  void enqueue_batch(executor exe_, deleter del_, void* const* data_, std::size_t count_, deleter discard_ = nullptr, Urgency urgency_ = Urgency::NORMAL, time_point deadline_ = time_point::max());
   void stop();
   void start();
   bool is_active() const { return m_active.load(); }
+  // scheduling metrics are not supported by this implementation
+  void snapshot(runner::metrics&) const { /* noop */ }
+  // the placement of the worker threads is not supported by this implementation
+  void location(runner::placement&) const { /* noop */ }
+  // the queue depth is not tracked by this implementation
+  std::size_t depth() const { return 0; }
+  // the urgency and the deadline are not supported by this implementation
+  bool has_preferred(Urgency, const time_point&) const { return false; }
 
  private:
   std::atomic<bool> m_active;
@@ -0,0 +1,627 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstdlib>
+#include <string>
+#include <map>
+#include <tuple>
+#include <fstream>
+#include <algorithm>
+
+#if defined(LINUX_TARGET)
+# include <unistd.h>
+# include <pthread.h>
+# include <sched.h>
+# include <sys/syscall.h>
+# include <sys/resource.h>
+# include <linux/futex.h>
+# include <linux/mempolicy.h>
+#endif
+
+#include "cool/ng/exception.h"
+#include "thread_pool.h"
+
+// number of worker threads set by the build configuration, 0 if not set
+#if !defined(COOL_NG_POOL_THREADS)
+# define COOL_NG_POOL_THREADS 0
+#endif
+
+namespace cool { namespace ng { namespace async { namespace impl {
+
+namespace {
+
+// worker thread's identity, if the current thread is a pool's worker thread
+thread_local thread_pool* current_pool = nullptr;
+thread_local std::size_t  current_index = 0;
+
+// injection queue is consulted first on every STARVATION_TICK-th work item
+const unsigned long STARVATION_TICK = 61;
+// initial capacity of the worker's deque, must be a power of 2
+const std::size_t INITIAL_DEQUE_CAPACITY = 256;
+// value of m_orphan if the pool was not destroyed from its worker thread
+const std::size_t NO_ORPHAN = static_cast<std::size_t>(-1);
+// nice values of the worker threads, in the order of Priority enumerators
+const int PRIORITY_NICE[] = { -5, 0, 5, 15 };
+
+// the environment variable first, then the build configuration, then the
+// number of hardware threads
+std::size_t default_pool_size()
+{
+  auto env = std::getenv("COOL_NG_POOL_THREADS");
+  if (env != nullptr)
+  {
+    auto n = std::strtoul(env, nullptr, 10);
+    if (n > 0)
+      return n;
+  }
+
+  if (COOL_NG_POOL_THREADS > 0)
+    return COOL_NG_POOL_THREADS;
+
+  auto n = std::thread::hardware_concurrency();
+  return n > 0 ? n : 4;
+}
+
+// sets the nice value of the calling thread; failures are ignored
+void set_thread_nice(int nice_)
+{
+#if defined(LINUX_TARGET)
+  if (nice_ != 0)
+    ::setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), nice_);
+#endif
+}
+
+#if defined(LINUX_TARGET)
+
+// parses the CPU list in the Linux sysfs format, such as "0-3,8,10-11"
+std::vector<unsigned int> parse_cpu_list(const std::string& list_)
+{
+  std::vector<unsigned int> ret;
+
+  for (std::size_t pos = 0; pos < list_.size(); )
+  {
+    char* end;
+    auto first = std::strtoul(list_.c_str() + pos, &end, 10);
+    auto last = first;
+    if (*end == '-')
+      last = std::strtoul(end + 1, &end, 10);
+    if (end == list_.c_str() + pos)
+      break;
+
+    for (auto c = first; c <= last; ++c)
+      ret.push_back(static_cast<unsigned int>(c));
+
+    pos = end - list_.c_str();
+    if (pos < list_.size() && list_[pos] == ',')
+      ++pos;
+    else
+      break;
+  }
+
+  return ret;
+}
+
+std::vector<unsigned int> read_cpu_list(const std::string& path_)
+{
+  std::ifstream f(path_);
+  std::string list;
+  if (!f || !std::getline(f, list))
+    return std::vector<unsigned int>();
+  return parse_cpu_list(list);
+}
+
+// returns the sorted set of requested CPUs that are online and belong to
+// the NUMA node, if specified
+std::vector<unsigned int> usable_cpus(const std::vector<unsigned int>& cpus_, int node_)
+{
+  auto online = read_cpu_list("/sys/devices/system/cpu/online");
+
+  std::vector<unsigned int> node_cpus;
+  if (node_ >= 0)
+  {
+    node_cpus = read_cpu_list("/sys/devices/system/node/node" + std::to_string(node_) + "/cpulist");
+    if (node_cpus.empty())
+      throw exception::illegal_argument("NUMA node " + std::to_string(node_) + " does not exist");
+  }
+
+  std::vector<unsigned int> ret;
+  for (auto c : cpus_.empty() ? node_cpus : cpus_)
+  {
+    if (c >= CPU_SETSIZE)
+      continue;
+    if (!online.empty() && std::find(online.begin(), online.end(), c) == online.end())
+      continue;
+    if (node_ >= 0 && std::find(node_cpus.begin(), node_cpus.end(), c) == node_cpus.end())
+      continue;
+    ret.push_back(c);
+  }
+
+  std::sort(ret.begin(), ret.end());
+  ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+  if (ret.empty())
+    throw exception::illegal_argument("none of the requested CPUs is available");
+  return ret;
+}
+
+#endif
+
+// pins the calling thread to the CPUs and sets its preferred NUMA node for
+// the memory allocations; failures are ignored
+void set_thread_placement(const std::vector<unsigned int>& cpus_, int node_)
+{
+#if defined(LINUX_TARGET)
+  if (!cpus_.empty())
+  {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto c : cpus_)
+      CPU_SET(c, &set);
+    ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+  }
+
+  const int MAX_NODES = 1024;
+  if (node_ >= 0 && node_ < MAX_NODES)
+  {
+    unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long))] = { 0 };
+    mask[node_ / (8 * sizeof(unsigned long))] |= 1UL << (node_ % (8 * sizeof(unsigned long)));
+    ::syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, MAX_NODES);
+  }
+#endif
+}
+
+// hints the CPU that the thread is busy polling
+inline void cpu_relax()
+{
+#if defined(__i386__) || defined(__x86_64__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+#if defined(LINUX_TARGET)
+inline void futex_wait(std::atomic<uint32_t>* addr_, uint32_t expected_)
+{
+  ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr_), FUTEX_WAIT_PRIVATE, expected_, nullptr, nullptr, 0);
+}
+
+inline void futex_wake(std::atomic<uint32_t>* addr_, int count_)
+{
+  ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr_), FUTEX_WAKE_PRIVATE, count_, nullptr, nullptr, 0);
+}
+#endif
+
+} // anonymous namespace
+
+// --- ------------------------------------------------------------------------
+// ---
+// --- ws_deque
+// ---
+// --- ------------------------------------------------------------------------
+void thread_pool::ws_deque::array::put(int64_t index_, const work& w_)
+{
+  auto& s = m_slots[static_cast<std::size_t>(index_) & m_mask];
+  s.m_callback.store(w_.m_callback, std::memory_order_relaxed);
+  s.m_data.store(w_.m_data, std::memory_order_relaxed);
+}
+
+thread_pool::work thread_pool::ws_deque::array::get(int64_t index_) const
+{
+  auto& s = m_slots[static_cast<std::size_t>(index_) & m_mask];
+  return work { s.m_callback.load(std::memory_order_relaxed), s.m_data.load(std::memory_order_relaxed) };
+}
+
+thread_pool::ws_deque::ws_deque() : m_top(0), m_bottom(0)
+{
+  m_arrays.emplace_back(new array(INITIAL_DEQUE_CAPACITY));
+  m_array = m_arrays.back().get();
+}
+
+thread_pool::ws_deque::array* thread_pool::ws_deque::grow(array* old_, int64_t top_, int64_t bottom_)
+{
+  auto a = new array(old_->capacity() * 2);
+  for (auto i = top_; i < bottom_; ++i)
+    a->put(i, old_->get(i));
+  m_arrays.emplace_back(a);
+  m_array.store(a, std::memory_order_release);
+  return a;
+}
+
+void thread_pool::ws_deque::push(const work& w_)
+{
+  auto b = m_bottom.load(std::memory_order_relaxed);
+  auto t = m_top.load(std::memory_order_acquire);
+  auto a = m_array.load(std::memory_order_relaxed);
+
+  if (b - t > static_cast<int64_t>(a->capacity()) - 1)
+    a = grow(a, t, b);
+  a->put(b, w_);
+  // release store rather than release fence and relaxed store; the same on
+  // x86 and understood by the thread sanitizer
+  m_bottom.store(b + 1, std::memory_order_release);
+}
+
+bool thread_pool::ws_deque::pop(work& w_)
+{
+  auto b = m_bottom.load(std::memory_order_relaxed) - 1;
+  auto a = m_array.load(std::memory_order_relaxed);
+  m_bottom.store(b, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  auto t = m_top.load(std::memory_order_relaxed);
+
+  if (t > b)
+  {
+    // empty
+    m_bottom.store(b + 1, std::memory_order_relaxed);
+    return false;
+  }
+
+  w_ = a->get(b);
+  if (t < b)
+    return true;
+
+  // the last element, race against thieves
+  bool ret = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+  m_bottom.store(b + 1, std::memory_order_relaxed);
+  return ret;
+}
+
+bool thread_pool::ws_deque::steal(work& w_)
+{
+  auto t = m_top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  auto b = m_bottom.load(std::memory_order_acquire);
+
+  if (t >= b)
+    return false;
+
+  auto a = m_array.load(std::memory_order_acquire);
+  w_ = a->get(t);
+  return m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+// --- ------------------------------------------------------------------------
+// ---
+// --- parking_lot
+// ---
+// --- The worker about to park must first call prepare(), then check once more
+// --- for the work and only then call park() with the epoch returned by
+// --- prepare(), or cancel() if it found the work. The submitter bumps the
+// --- epoch after it made the work visible, so either the worker sees the work
+// --- or the park returns immediately.
+// ---
+// --- ------------------------------------------------------------------------
+thread_pool::parking_lot::parking_lot() : m_epoch(0), m_parked(0)
+{ /* noop */ }
+
+uint32_t thread_pool::parking_lot::prepare()
+{
+  ++m_parked;
+  return m_epoch.load();
+}
+
+void thread_pool::parking_lot::cancel()
+{
+  --m_parked;
+}
+
+#if defined(LINUX_TARGET)
+
+void thread_pool::parking_lot::park(uint32_t epoch_)
+{
+  if (m_epoch.load() == epoch_)
+    futex_wait(&m_epoch, epoch_);
+  --m_parked;
+}
+
+void thread_pool::parking_lot::unpark_one()
+{
+  if (m_parked.load() == 0)
+    return;
+  ++m_epoch;
+  futex_wake(&m_epoch, 1);
+}
+
+void thread_pool::parking_lot::unpark_all()
+{
+  ++m_epoch;
+  futex_wake(&m_epoch, INT32_MAX);
+}
+
+#else
+
+void thread_pool::parking_lot::park(uint32_t epoch_)
+{
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    m_cv.wait(l, [this, epoch_] { return m_epoch.load() != epoch_; });
+  }
+  --m_parked;
+}
+
+void thread_pool::parking_lot::unpark_one()
+{
+  if (m_parked.load() == 0)
+    return;
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    ++m_epoch;
+  }
+  m_cv.notify_one();
+}
+
+void thread_pool::parking_lot::unpark_all()
+{
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    ++m_epoch;
+  }
+  m_cv.notify_all();
+}
+
+#endif
+
+// --- ------------------------------------------------------------------------
+// ---
+// --- thread_pool
+// ---
+// --- ------------------------------------------------------------------------
+thread_pool& thread_pool::get(Priority priority_)
+{
+  // never destroyed, worker threads live until the process exits
+  switch (priority_)
+  {
+    case Priority::HIGH:
+    {
+      static thread_pool* pool_ = new thread_pool(default_pool_size(), PRIORITY_NICE[static_cast<int>(priority_)]);
+      return *pool_;
+    }
+    case Priority::LOW:
+    {
+      static thread_pool* pool_ = new thread_pool(default_pool_size(), PRIORITY_NICE[static_cast<int>(priority_)]);
+      return *pool_;
+    }
+    case Priority::BACKGROUND:
+    {
+      static thread_pool* pool_ = new thread_pool(default_pool_size(), PRIORITY_NICE[static_cast<int>(priority_)]);
+      return *pool_;
+    }
+    default:
+    {
+      static thread_pool* pool_ = new thread_pool(default_pool_size(), PRIORITY_NICE[static_cast<int>(priority_)]);
+      return *pool_;
+    }
+  }
+}
+
+thread_pool& thread_pool::get(Priority priority_, const std::vector<unsigned int>& cpus_, int node_)
+{
+#if defined(LINUX_TARGET)
+  if (cpus_.empty() && node_ < 0)
+    return get(priority_);
+
+  auto cpus = usable_cpus(cpus_, node_);
+
+  // never destroyed, worker threads live until the process exits
+  using key = std::tuple<Priority, std::vector<unsigned int>, int>;
+  static std::mutex* mutex_ = new std::mutex();
+  static std::map<key, thread_pool*>* pools_ = new std::map<key, thread_pool*>();
+
+  std::unique_lock<std::mutex> l(*mutex_);
+  auto k = std::make_tuple(priority_, cpus, node_);
+  auto it = pools_->find(k);
+  if (it != pools_->end())
+    return *it->second;
+
+  auto pool = new thread_pool(cpus.size(), PRIORITY_NICE[static_cast<int>(priority_)], cpus, node_);
+  pools_->emplace(k, pool);
+  return *pool;
+#else
+  return get(priority_);
+#endif
+}
+
+thread_pool* thread_pool::create_dedicated(
+    Priority priority_
+  , const std::vector<unsigned int>& cpus_
+  , int node_
+  , std::chrono::microseconds spin_)
+{
+#if defined(LINUX_TARGET)
+  auto cpus = cpus_.empty() && node_ < 0 ? cpus_ : usable_cpus(cpus_, node_);
+#else
+  auto cpus = std::vector<unsigned int>();
+  node_ = -1;
+#endif
+  return new thread_pool(1, PRIORITY_NICE[static_cast<int>(priority_)], cpus, node_, spin_);
+}
+
+void thread_pool::destroy(thread_pool* pool_)
+{
+  if (current_pool != pool_)
+  {
+    delete pool_;
+    return;
+  }
+
+  // the worker thread cannot join itself; it will delete the pool once it
+  // returns from the current work item
+  pool_->m_orphan = current_index;
+  pool_->m_stop = true;
+}
+
+thread_pool::thread_pool(
+    std::size_t num_threads_
+  , int nice_
+  , const std::vector<unsigned int>& cpus_
+  , int node_
+  , std::chrono::microseconds spin_)
+    : m_stop(false)
+    , m_nice(nice_)
+    , m_cpus(cpus_)
+    , m_node(node_)
+    , m_spin(spin_)
+    , m_orphan(NO_ORPHAN)
+    , m_injected(0)
+{
+  if (num_threads_ == 0)
+    num_threads_ = 1;
+
+  for (std::size_t i = 0; i < num_threads_; ++i)
+    m_locals.emplace_back(new ws_deque());
+  for (std::size_t i = 0; i < num_threads_; ++i)
+    m_workers.emplace_back(&thread_pool::worker, this, i);
+}
+
+thread_pool::~thread_pool()
+{
+  m_stop = true;
+  m_parking.unpark_all();
+  for (auto& t : m_workers)
+    if (t.joinable())
+      t.join();
+}
+
+void thread_pool::submit(callback cb_, void* data_)
+{
+  work w = { cb_, data_ };
+
+  if (current_pool == this)
+    m_locals[current_index]->push(w);
+  else
+    inject(w);
+
+  m_parking.unpark_one();
+}
+
+void thread_pool::resubmit(callback cb_, void* data_)
+{
+  inject(work { cb_, data_ });
+  m_parking.unpark_one();
+}
+
+void thread_pool::inject(const work& w_)
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  m_injection.push_back(w_);
+  ++m_injected;
+}
+
+bool thread_pool::take_injected(work& w_)
+{
+  if (m_injected.load() == 0)
+    return false;
+
+  std::unique_lock<std::mutex> l(m_mutex);
+  if (m_injection.empty())
+    return false;
+  w_ = m_injection.front();
+  m_injection.pop_front();
+  --m_injected;
+  return true;
+}
+
+bool thread_pool::find_work(std::size_t index_, unsigned long tick_, work& w_)
+{
+  auto& local = *m_locals[index_];
+
+  if (tick_ % STARVATION_TICK == 0 && (take_injected(w_) || local.steal(w_)))
+    return true;
+  if (local.pop(w_))
+    return true;
+  if (take_injected(w_))
+    return true;
+
+  auto n = m_locals.size();
+  for (std::size_t i = 1; i < n; ++i)
+    if (m_locals[(index_ + i) % n]->steal(w_))
+      return true;
+
+  return false;
+}
+
+// Busy polls for the work until the spin interval expires or the pool stops
+bool thread_pool::poll_work(std::size_t index_, unsigned long tick_, work& w_)
+{
+  const int CHECK_CLOCK_EVERY = 64;
+  auto deadline = std::chrono::steady_clock::now() + m_spin;
+
+  do
+  {
+    for (int i = 0; i < CHECK_CLOCK_EVERY; ++i)
+    {
+      if (find_work(index_, tick_, w_))
+        return true;
+      cpu_relax();
+    }
+  }
+  while (!m_stop && std::chrono::steady_clock::now() < deadline);
+
+  return false;
+}
+
+void thread_pool::worker(std::size_t index_)
+{
+  current_pool = this;
+  current_index = index_;
+  set_thread_nice(m_nice);
+  set_thread_placement(m_cpus, m_node);
+
+  work w;
+  for (unsigned long tick = 1; !m_stop; ++tick)
+  {
+    if (find_work(index_, tick, w))
+    {
+      (*w.m_callback)(w.m_data);
+      continue;
+    }
+
+    if (m_spin.count() > 0 && poll_work(index_, tick, w))
+    {
+      (*w.m_callback)(w.m_data);
+      continue;
+    }
+
+    auto epoch = m_parking.prepare();
+    if (find_work(index_, tick, w))
+    {
+      m_parking.cancel();
+      (*w.m_callback)(w.m_data);
+      continue;
+    }
+    if (m_stop)
+    {
+      m_parking.cancel();
+      break;
+    }
+    m_parking.park(epoch);
+  }
+
+  if (m_orphan.load() == index_)
+  {
+    m_workers[index_].detach();
+    delete this;
+  }
+}
+
+} } } } // namespace
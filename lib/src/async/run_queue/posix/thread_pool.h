@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_9315b660_1406_4c6f_8c43_faaf762e3b27)
+#define      cool_ng_9315b660_1406_4c6f_8c43_faaf762e3b27
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <thread>
+
+#include "cool/ng/async/runner.h"
+
+/*
+  Notes on thread_pool:
+
+  The thread_pool class is internal to Cool.NG library and is not a part of
+  its API. It replaces the libdispatch global queue as the source of worker
+  threads for the run_queue when the library is built with POSIX_POOL task
+  runner implementation. With either of the GCD_DEQUE and POSIX_POOL task
+  runner implementations it also provides the dedicated threads (see 5).
+
+  1. Structure
+
+  The thread pool runs a fixed number of worker threads. Each worker thread
+  owns a Chase-Lev work stealing deque. The work submitted from one of the
+  worker threads, for example a task scheduling another task, is pushed to
+  the bottom of the calling worker's deque and the worker pops its work from
+  the bottom, too, so the most recently submitted work, whose data is most
+  likely still in the CPU cache, runs first. Idle workers steal the oldest
+  work from the top of the other workers' deques. The work submitted from the
+  threads outside the pool is pushed into the shared injection queue.
+
+  The work resubmitted with resubmit(), which is the case of the sequential
+  run_queue yielding the worker thread after its drain limits were exceeded,
+  is always pushed into the injection queue, behind the work already waiting.
+  Pushing it to the bottom of the deque would let the run_queue take the
+  worker back immediately.
+
+  The worker thread looks for the work at the bottom of its deque first,
+  then in the injection queue, and then tries to steal the work from the
+  other workers' deques. To avoid starvation of the older work, the worker
+  will consult the injection queue and then the top of its own deque before
+  the bottom on every 61st work item.
+
+  2. Parking
+
+  The worker that finds no work parks. On Linux the parked workers wait on a
+  futex and the submitters only issue the wake system call if there are
+  parked workers; elsewhere the parking falls back to the condition variable.
+
+  3. Configuration
+
+  There is one pool for each Priority class, so the run_queues of different
+  priority classes never compete for the same worker threads. On Linux the
+  worker threads of the pool run with the nice value of its priority class;
+  the lower priority classes yield the CPU to the higher ones. Raising the
+  priority of the HIGH pool's workers above the process priority requires
+  the privileges; without them the workers run with the process priority.
+
+  The number of worker threads of each pool is set at the build time with
+  the COOL_NG_POOL_THREADS CMake variable, for example
+  -DCOOL_NG_POOL_THREADS=8. The COOL_NG_POOL_THREADS environment variable,
+  read when the pool is created, overrides the build setting. If
+  neither is set to a positive number, the pool will use one worker thread
+  per hardware thread. The pinned pools (see 4.) and the dedicated pools
+  (see 5.) size themselves regardless of these settings.
+
+  The pool is created on the first use of its priority class and is never
+  destroyed; its worker threads are running until the process exits.
+
+  4. Placement
+
+  The run_queue pinned to the CPU set, or to the NUMA node, gets its own pool,
+  shared with all run_queues of the same priority class and placement. The
+  pinned pool runs one worker thread per CPU and its worker threads may run
+  on any CPU of the set. The worker threads of the pool pinned to the NUMA
+  node prefer the memory of the node; since the worker threads allocate the
+  memory for the context pool caches and for the growth of their deques,
+  both end up node-local. The placement is only supported on Linux; on other
+  platforms the pinned run_queue uses the unpinned pool of its priority.
+
+  5. Dedicated Threads
+
+  The run_queue created with the dedicated thread option owns its private
+  pool with a single worker thread, created with create_dedicated() and
+  destroyed with destroy() when the run_queue is destroyed. The run_queue
+  may be destroyed from its own worker thread, which cannot join itself; in
+  this case the worker thread deletes the pool after it returns from the
+  current work item.
+
+  The pool created with a non-zero spin interval busy polls for the work for
+  the spin interval before its worker threads park. The submitter does not
+  issue the wake system call while the workers are polling.
+*/
+
+namespace cool { namespace ng { namespace async { namespace impl {
+
+class thread_pool
+{
+ public:
+  using callback = void (*)(void*);
+
+ private:
+  struct work
+  {
+    callback m_callback;
+    void*    m_data;
+  };
+
+  // Chase-Lev deque as described in "Correct and Efficient Work-Stealing
+  // for Weak Memory Models" by Le, Pop, Cohen and Zappa Nardelli. Only the
+  // owning worker may call push() and pop(); steal() may be called from any
+  // thread. The arrays replaced by the larger ones are retired but kept until
+  // the destruction of the deque since the thieves may still read from them.
+  class ws_deque
+  {
+   public:
+    ws_deque();
+    void push(const work& w_);
+    bool pop(work& w_);
+    bool steal(work& w_);
+
+   private:
+    struct slot
+    {
+      std::atomic<callback> m_callback;
+      std::atomic<void*>    m_data;
+    };
+
+    struct array
+    {
+      explicit array(std::size_t capacity_)
+        : m_mask(capacity_ - 1), m_slots(new slot[capacity_])
+      { /* noop */ }
+      std::size_t capacity() const { return m_mask + 1; }
+      void put(int64_t index_, const work& w_);
+      work get(int64_t index_) const;
+
+      const std::size_t       m_mask;
+      std::unique_ptr<slot[]> m_slots;
+    };
+
+    array* grow(array* old_, int64_t top_, int64_t bottom_);
+
+   private:
+    std::atomic<int64_t>                m_top;
+    char                                m_pad[64];    // top and bottom on different cache lines
+    std::atomic<int64_t>                m_bottom;
+    std::atomic<array*>                 m_array;
+    std::vector<std::unique_ptr<array>> m_arrays;     // current and retired arrays
+  };
+
+  class parking_lot
+  {
+   public:
+    parking_lot();
+    uint32_t prepare();
+    void cancel();
+    void park(uint32_t epoch_);
+    void unpark_one();
+    void unpark_all();
+
+   private:
+    std::atomic<uint32_t> m_epoch;
+    std::atomic<unsigned> m_parked;
+#if !defined(LINUX_TARGET)
+    std::mutex              m_mutex;
+    std::condition_variable m_cv;
+#endif
+  };
+
+ public:
+  static thread_pool& get(Priority priority_ = Priority::DEFAULT);
+  static thread_pool& get(Priority priority_, const std::vector<unsigned int>& cpus_, int node_);
+  static thread_pool* create_dedicated(
+      Priority priority_
+    , const std::vector<unsigned int>& cpus_
+    , int node_
+    , std::chrono::microseconds spin_);
+  static void destroy(thread_pool* pool_);
+
+  explicit thread_pool(
+      std::size_t num_threads_
+    , int nice_ = 0
+    , const std::vector<unsigned int>& cpus_ = std::vector<unsigned int>()
+    , int node_ = -1
+    , std::chrono::microseconds spin_ = std::chrono::microseconds(0));
+  ~thread_pool();
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator =(const thread_pool&) = delete;
+
+  void submit(callback cb_, void* data_);
+  void resubmit(callback cb_, void* data_);
+  std::size_t size() const { return m_workers.size(); }
+  const std::vector<unsigned int>& cpus() const { return m_cpus; }
+  int numa_node() const { return m_node; }
+
+ private:
+  void worker(std::size_t index_);
+  bool find_work(std::size_t index_, unsigned long tick_, work& w_);
+  bool poll_work(std::size_t index_, unsigned long tick_, work& w_);
+  void inject(const work& w_);
+  bool take_injected(work& w_);
+
+ private:
+  std::atomic<bool>                         m_stop;
+  const int                                 m_nice;
+  const std::vector<unsigned int>           m_cpus;      // empty if not pinned
+  const int                                 m_node;      // -1 if not pinned
+  const std::chrono::microseconds           m_spin;      // busy poll interval before parking
+  std::atomic<std::size_t>                  m_orphan;    // worker to delete the pool, if destroyed from one
+  std::mutex                                m_mutex;     // protects m_injection
+  std::deque<work>                          m_injection;
+  std::atomic<std::size_t>                  m_injected;
+  std::vector<std::unique_ptr<ws_deque>>    m_locals;
+  parking_lot                               m_parking;
+  std::vector<std::thread>                  m_workers;
+};
+
+} } } }// namespace
+
+#endif
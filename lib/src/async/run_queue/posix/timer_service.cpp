@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "lib/async/queue_bound.h"
+#include "timer_service.h"
+
+namespace cool { namespace ng { namespace async { namespace impl {
+
+namespace {
+
+// heap order, the earliest call and, among the calls with the same time, the
+// first scheduled on the top
+template <typename T>
+inline bool later(const T& a_, const T& b_)
+{
+  return a_.m_when > b_.m_when || (a_.m_when == b_.m_when && a_.m_seq > b_.m_seq);
+}
+
+} // anonymous namespace
+
+timer_service::timer_service() : m_seq(0)
+{
+  m_thread = std::thread(&timer_service::run, this);
+  m_thread.detach();
+}
+
+timer_service& timer_service::get()
+{
+  // never destroyed, see the notes in the header
+  static timer_service* service_ = new timer_service();
+  return *service_;
+}
+
+void timer_service::schedule(const clock::time_point& when_, callback cb_, void* data_)
+{
+  get().add(when_, cb_, data_);
+}
+
+void timer_service::add(const clock::time_point& when_, callback cb_, void* data_)
+{
+  std::unique_lock<std::mutex> l(m_lock);
+  m_heap.push_back(entry { when_, m_seq++, cb_, data_ });
+  std::push_heap(m_heap.begin(), m_heap.end(), later<entry>);
+
+  // the timer thread only needs to know if the new call is the first due
+  if (m_heap.front().m_seq == m_seq - 1)
+    m_cv.notify_one();
+}
+
+void timer_service::run()
+{
+  // the calls must not block the timer thread, not even on the full run_queue
+  queue_bound::non_blocking() = true;
+
+  std::unique_lock<std::mutex> l(m_lock);
+
+  for (;;)
+  {
+    if (m_heap.empty())
+    {
+      m_cv.wait(l);
+      continue;
+    }
+
+    auto when = m_heap.front().m_when;
+    if (clock::now() < when)
+    {
+      m_cv.wait_until(l, when);
+      continue;
+    }
+
+    std::pop_heap(m_heap.begin(), m_heap.end(), later<entry>);
+    auto e = m_heap.back();
+    m_heap.pop_back();
+
+    l.unlock();
+    (*e.m_callback)(e.m_data);
+    l.lock();
+  }
+}
+
+} } } } // namespace
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_5a0f3275_4ecf_4260_8108_6c4c36df43a9)
+#define      cool_ng_5a0f3275_4ecf_4260_8108_6c4c36df43a9
+
+#include <cstdint>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <thread>
+
+/*
+  Notes on timer_service:
+
+  The timer_service class is internal to Cool.NG library and is not a part of
+  its API. It calls the given function with the given data pointer at the
+  given time, for the run_queues that must wait for some time without holding
+  a worker thread, such as the rate limited run_queue waiting for the next
+  token, and for the delayed task runs, through run_queue::schedule(). It is
+  built with either of the GCD_DEQUE and POSIX_POOL task runner
+  implementations.
+
+  There is a single timer_service per process with a single timer thread. The
+  pending calls are kept in a binary heap ordered by their time and, among
+  the calls with the same time, by the order of scheduling. schedule() costs
+  a heap insert under the lock and only wakes the timer thread if the new
+  call is due before all pending calls. The calls are made from the timer
+  thread, one after another, hence they must be short and must not block;
+  the run_queue only submits its work to the worker threads from there. The
+  timer thread is marked as non-blocking for the bounded run_queues, which
+  reject its submissions when full instead of blocking it.
+
+  The calls scheduled for the time that has already passed are made as soon
+  as possible, still from the timer thread. The calls cannot be cancelled.
+  The timer_service and its thread are never destroyed, as the run_queues
+  may use it during the static destruction; the pending calls are not made
+  after the process exits.
+*/
+
+namespace cool { namespace ng { namespace async { namespace impl {
+
+class timer_service
+{
+ public:
+  using clock = std::chrono::steady_clock;
+  using callback = void (*)(void*);
+
+ public:
+  // calls cb_ with data_ at when_, from the timer thread
+  static void schedule(const clock::time_point& when_, callback cb_, void* data_);
+
+ private:
+  struct entry
+  {
+    clock::time_point m_when;
+    uint64_t          m_seq;
+    callback          m_callback;
+    void*             m_data;
+  };
+
+  timer_service();
+  static timer_service& get();
+  void add(const clock::time_point& when_, callback cb_, void* data_);
+  void run();
+
+ private:
+  std::mutex              m_lock;
+  std::condition_variable m_cv;
+  std::vector<entry>      m_heap;    // earliest call on the top
+  uint64_t                m_seq;     // sequence number of the next call
+  std::thread             m_thread;
+};
+
+} } } }// namespace
+
+#endif
@@ -46,6 +46,22 @@ const PTP_WORK invalid_work = reinterpret_cast<const PTP_WORK>(0x1);
 #endif
 CONSTEXPR_ const int TASK = 1;
 
+// request of run_queue::schedule(), owns its thread pool timer
+struct delayed
+{
+  run_queue::executor m_executor;
+  void*               m_data;
+  PTP_TIMER           m_timer;
+};
+
+VOID CALLBACK on_timer(PTP_CALLBACK_INSTANCE, PVOID pv_, PTP_TIMER)
+{
+  auto req = static_cast<delayed*>(pv_);
+  req->m_executor(req->m_data);
+  CloseThreadpoolTimer(req->m_timer);
+  delete req;
+}
+
 }
 
 // --- ------------------------------------------------------------------------
@@ -62,15 +78,29 @@ critical_section  poolmgr::m_cs;
 
 poolmgr::poolmgr() : m_pool(nullptr)
 {
-  InitializeThreadpoolEnvironment(&m_environ);
+  // in the order of Priority enumerators; the Windows Threadpool has no
+  // background priority
+  static const TP_CALLBACK_PRIORITY priorities[] = {
+      TP_CALLBACK_PRIORITY_HIGH
+    , TP_CALLBACK_PRIORITY_NORMAL
+    , TP_CALLBACK_PRIORITY_LOW
+    , TP_CALLBACK_PRIORITY_LOW
+  };
+
+  for (auto& e : m_environ)
+    InitializeThreadpoolEnvironment(&e);
   m_pool = CreateThreadpool(nullptr);
   if (m_pool == nullptr)
     throw exception::system_error("Failed to create new threadpool");
 
-  // Associate the callback environment with our thread pool.
-  SetThreadpoolCallbackPool(&m_environ, m_pool);
+  // Associate the callback environments with our thread pool.
+  for (int i = 0; i < 4; ++i)
+  {
+    SetThreadpoolCallbackPool(&m_environ[i], m_pool);
+    SetThreadpoolCallbackPriority(&m_environ[i], priorities[i]);
+  }
 
-  TRACE("poolmgr", "this=" << this << ", env=" << &m_environ);
+  TRACE("poolmgr", "this=" << this << ", env=" << m_environ);
 }
 
 poolmgr::~poolmgr()
@@ -80,7 +110,8 @@ poolmgr::~poolmgr()
   if (m_pool != nullptr)
     CloseThreadpool(m_pool);
 
-  DestroyThreadpoolEnvironment(&m_environ);
+  for (auto& e : m_environ)
+    DestroyThreadpoolEnvironment(&e);
 
   TRACE("poolmgr", "deleted");
 }
@@ -146,7 +177,12 @@ void run_queue::context::clear()
 // --- ------------------------------------------------------------------------
 run_queue::pointer run_queue::create(const std::string& name_)
 {
-  auto ret = std::make_shared<run_queue>(name_);
+  return create(runner::options(), name_);
+}
+
+run_queue::pointer run_queue::create(const runner::options& opts_, const std::string& name_)
+{
+  auto ret = std::make_shared<run_queue>(name_, opts_.priority());
   ret->m_self = ret;
   return ret;
 }
@@ -158,7 +194,7 @@ void run_queue::release(const pointer& q_)
   q_->start();
 }
 
-run_queue::run_queue(const std::string& name_)
+run_queue::run_queue(const std::string& name_, Priority priority_)
     : named(name_)
     , m_status(EMPTY_ACTIVE_NOT_BUSY)
     , m_work(nullptr)
@@ -175,7 +211,7 @@ run_queue::run_queue(const std::string& name_)
   try
   {
     // Create work with the callback environment.
-    m_work = CreateThreadpoolWork(run_next, this, m_pool->get_environ());
+    m_work = CreateThreadpoolWork(run_next, this, m_pool->get_environ(priority_));
     if (m_work == nullptr)
       throw exception::system_error("failed to create new threadpool work object");
   }
@@ -208,7 +244,7 @@ void run_queue::start()
 }
 
 
-void run_queue::enqueue(executor exe_, deleter del_, void* data_)
+void run_queue::enqueue(executor exe_, deleter del_, void* data_, deleter, Urgency, time_point)
 {
   TRACE(name(), "enqueue: " );
 
@@ -217,6 +253,39 @@ void run_queue::enqueue(executor exe_, deleter del_, void* data_)
   check_submit_next();
 }
 
+void run_queue::enqueue_batch(executor exe_, deleter del_, void* const* data_, std::size_t count_, deleter, Urgency, time_point)
+{
+  TRACE(name(), "enqueue_batch: " );
+
+  if (count_ == 0)
+    return;
+
+  for (std::size_t i = 0; i < count_; ++i)
+    PostQueuedCompletionStatus(m_fifo, TASK, NULL, reinterpret_cast<LPOVERLAPPED>(new context(exe_, del_, data_[i], m_self)));
+  m_status &= ~EMPTY;
+  check_submit_next();
+}
+
+void run_queue::schedule(const time_point& when_, executor exe_, void* data_)
+{
+  auto req = new delayed { exe_, data_, nullptr };
+  req->m_timer = CreateThreadpoolTimer(on_timer, req, nullptr);
+  if (req->m_timer == nullptr)
+  {
+    delete req;
+    throw exception::system_error("failed to create new threadpool timer object");
+  }
+
+  // negative due time is relative, in 100 ns units
+  auto delay = std::chrono::duration_cast<std::chrono::nanoseconds>(when_ - runner::clock::now()).count() / 100;
+  ULARGE_INTEGER due;
+  due.QuadPart = static_cast<ULONGLONG>(-(delay > 0 ? delay : 0));
+  FILETIME ft;
+  ft.dwLowDateTime = due.LowPart;
+  ft.dwHighDateTime = due.HighPart;
+  SetThreadpoolTimer(req->m_timer, &ft, 0, 0);
+}
+
 void run_queue::check_submit_next()
 {
   int expected = NOT_EMPTY_ACTIVE_NOT_BUSY;
@@ -32,6 +32,7 @@
 #include <unordered_set>
 
 #include "cool/ng/bases.h"
+#include "cool/ng/async/runner.h"
 #include "critical_section.h"
 
 /*
@@ -67,7 +68,7 @@
 
   1.2 Posting Tasks to Execute
 
-  1.2.1 enqueue(executor exe_, deleter del_, void* data_)
+  1.2.1 enqueue(executor exe_, deleter del_, void* data_, deleter discard_, Urgency urgency_, time_point deadline_)
 
   Enqueues the request to call the execution function exe_ with the data pointer
   specified as data_ as soon as possible but after the previous request posted to
@@ -79,9 +80,37 @@
   enqueueing a new task after a call to release() is platform dependent and
   undefined.
 
+  This run_queue never discards the requests, nor does it support the bounded
+  queues; the discard function discard_ is ignored.
+
+  This run_queue executes the requests in the order of submission; the
+  urgency urgency_ and the deadline deadline_ are ignored.
+
   enqueue() is thread safe. This method, or any other thread-safe methods, may
   be called simultaneously from multiple threads.
 
+  1.2.2 enqueue_batch(executor exe_, deleter del_, void* const* data_, std::size_t count_, deleter discard_, Urgency urgency_, time_point deadline_)
+
+  Enqueues count_ requests to call the execution function exe_, one for each
+  of the data pointers in the data_ array, as if enqueue() was called for
+  each of them in the array order. The requests of the batch are posted
+  to the completion port one after another and may interleave with the
+  requests enqueued by other threads.
+
+  enqueue_batch() is thread safe. This method, or any other thread-safe
+  methods, may be called simultaneously from multiple threads.
+
+  1.2.3 schedule(const time_point& when_, executor exe_, void* data_)
+
+  This method is static. Requests the call of the function exe_ with the data
+  pointer data_ at time when_, or as soon as possible if when_ has already
+  passed. The call is not associated with any run_queue and is made from the
+  thread pool timer callback of the process default thread pool, whose timers
+  share a single timer queue; exe_ is meant to enqueue the delayed work to its
+  run_queue. The request cannot be cancelled.
+
+  schedule() is thread safe.
+
   1.3 Starting and Stopping the Task Execution
 
   When created, the run_queue is active and will be executing the tasks as soon as
@@ -138,13 +167,16 @@ class poolmgr
  public:
   poolmgr();
   ~poolmgr();
-  PTP_CALLBACK_ENVIRON get_environ() { return &m_environ; }
+  PTP_CALLBACK_ENVIRON get_environ(Priority priority_ = Priority::DEFAULT)
+  {
+    return &m_environ[static_cast<int>(priority_)];
+  }
   void add_environ(PTP_CALLBACK_ENVIRON e_);
   static ptr get_poolmgr();
 
  private:
   PTP_POOL                        m_pool;
-  TP_CALLBACK_ENVIRON             m_environ;
+  TP_CALLBACK_ENVIRON             m_environ[4];   // one per Priority class
   static weak_ptr                 m_self;
   static critical_section         m_cs;
 };
@@ -154,6 +186,7 @@ class run_queue : public ::cool::ng::util::named
  public:
   using deleter = void (*)(void*);
   using executor = void (*)(void*);
+  using time_point = runner::clock::time_point;
   using pointer = std::shared_ptr<run_queue>;
 
  private:
@@ -185,17 +218,28 @@ class run_queue : public ::cool::ng::util::named
 
  public:
   static pointer create(const std::string& name_ = "si.digiverse.cool.ng.runner");
+  static pointer create(const runner::options& opts_, const std::string& name_ = "si.digiverse.cool.ng.runner");
   static void release(const pointer& arg);
+  static void schedule(const time_point& when_, executor exe_, void* data_);
 
   // --- Do not use ctor directly; use create instead.
   // --- Ctor is public only to permit the use of std::make_shared
-  run_queue(const std::string& name_);
+  run_queue(const std::string& name_, Priority priority_ = Priority::DEFAULT);
   ~run_queue();
 
-  void enqueue(executor exe_, deleter del_, void* data_);
+  void enqueue(executor exe_, deleter del_, void* data_, deleter discard_ = nullptr, Urgency urgency_ = Urgency::NORMAL, time_point deadline_ = time_point::max());
+  void enqueue_batch(executor exe_, deleter del_, void* const* data_, std::size_t count_, deleter discard_ = nullptr, Urgency urgency_ = Urgency::NORMAL, time_point deadline_ = time_point::max());
   void stop();
   void start();
   bool is_active() const { return (m_status.load() & ACTIVE) != 0; }
+  // scheduling metrics are not supported by this implementation
+  void snapshot(runner::metrics&) const { /* noop */ }
+  // the placement of the worker threads is not supported by this implementation
+  void location(runner::placement&) const { /* noop */ }
+  // the queue depth is not tracked by this implementation
+  std::size_t depth() const { return 0; }
+  // the urgency and the deadline are not supported by this implementation
+  bool has_preferred(Urgency, const time_point&) const { return false; }
 
  private:
   void check_submit_next();
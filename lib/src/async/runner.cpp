@@ -25,10 +25,13 @@
 # include <Windows.h>
 #endif
 
+#include <vector>
+
 #include "cool/ng/async/runner.h"
 #include "cool/ng/exception.h"
 #include "cool/ng/impl/async/context.h"
 #include "cool/ng/impl/async/task.h"
+#include "lib/async/object_pool.h"
 #include "run_queue.h"
 
 namespace cool { namespace ng { namespace async {
@@ -38,6 +41,11 @@ runner::runner()
   m_impl = impl::run_queue::create();
 }
 
+runner::runner(const options& opts_)
+{
+  m_impl = impl::run_queue::create(opts_);
+}
+
 runner::~runner()
 {
   impl::run_queue::release(m_impl);
@@ -48,29 +56,189 @@ const std::string& runner::name() const
   return m_impl->name();
 }
 
+runner::metrics runner::snapshot() const
+{
+  metrics ret;
+  m_impl->snapshot(ret);
+  return ret;
+}
+
+runner::placement runner::location() const
+{
+  placement ret;
+  m_impl->location(ret);
+  return ret;
+}
+
+std::size_t runner::depth() const
+{
+  return m_impl->depth();
+}
+
 const std::shared_ptr<impl::run_queue>& runner::impl() const
 {
   return m_impl;
 }
 
+namespace {
+
+// system-wide runners are never destroyed, as tasks may still be submitted to
+// them during the static destruction
+runner::ptr* make_system_runner(const runner::options& opts_)
+{
+  return new runner::ptr(std::make_shared<runner>(opts_));
+}
+
+runner::ptr* make_system_runner(Priority priority_)
+{
+  return make_system_runner(runner::options()
+      .policy(RunPolicy::CONCURRENT)
+      .priority(priority_));
+}
+
+} // anonymous namespace
+
+runner::ptr runner::sys_high()
+{
+  static ptr* runner_ = make_system_runner(Priority::HIGH);
+  return *runner_;
+}
+
+runner::ptr runner::sys_default()
+{
+  static ptr* runner_ = make_system_runner(Priority::DEFAULT);
+  return *runner_;
+}
+
+runner::ptr runner::sys_low()
+{
+  static ptr* runner_ = make_system_runner(Priority::LOW);
+  return *runner_;
+}
+
+runner::ptr runner::sys_background()
+{
+  static ptr* runner_ = make_system_runner(Priority::BACKGROUND);
+  return *runner_;
+}
+
+runner::ptr runner::cool_default()
+{
+  static ptr* runner_ = make_system_runner(runner::options());
+  return *runner_;
+}
+
 namespace detail {
 
+namespace {
+
+// Maximal number of contexts of the same context stack executed back-to-back
+// on the same runner. Once the budget is spent, the context stack is
+// re-enqueued at the end of the runner's task queue to give other tasks
+// submitted to this runner their turn.
+const std::size_t CONTINUATION_BUDGET = 16;
+
+// returns true if weak pointer points to the same runner as the shared pointer
+inline bool same_runner(const std::weak_ptr<runner>& w_, const std::shared_ptr<runner>& s_)
+{
+  return !w_.owner_before(s_) && !s_.owner_before(w_);
+}
+
+// deletes the context stack the runner discarded without execution
+void discard_stack(void* arg_)
+{
+  delete static_cast<context_stack*>(arg_);
+}
+
+// reports the exception to the exception reporter of the top context, which
+// did not get to run, and deletes the context stack together with the
+// contexts the reporter may have left on it
+void fail_stack(context_stack* ctx_, const std::exception_ptr& e_)
+{
+  auto top = ctx_->pop();
+  auto reporter = top->get_exc_reporter();
+  delete top;
+
+  try
+  {
+    if (reporter)
+      reporter(e_);
+  }
+  catch (...)
+  { /* noop */ }
+
+  delete ctx_;
+}
+
+} // anonymous namespace
+
+// the context stack of each task run comes from the pool, together with the
+// arena for its contexts; the pool keeps at most STACK_POOL_BATCHES batches
+// of free stacks besides the thread caches, the rest are freed
+namespace {
+
+const std::size_t STACK_POOL_BATCH = 16;
+const std::size_t STACK_POOL_BATCHES = 16;
+
+using stack_pool = impl::object_pool<default_task_stack, STACK_POOL_BATCH, STACK_POOL_BATCHES>;
+
+} // anonymous namespace
+
+void* default_task_stack::operator new(std::size_t)
+{
+  return stack_pool::allocate();
+}
+
+void default_task_stack::operator delete(void* p_)
+{
+  stack_pool::deallocate(p_);
+}
+
 // executor for task::run()
+//
+// Executes the top context of the context stack. If the context stack is not
+// empty afterwards and the next context belongs to the same runner, it is
+// executed immediately, without the round trip through the runner's queue,
+// for up to CONTINUATION_BUDGET contexts and as long as the runner has no
+// waiting work of higher urgency or of earlier deadline. Otherwise the
+// context stack is enqueued to the runner of the next context.
 void task_executor(void* arg_)
 {
   auto ctx = static_cast<detail::context_stack*>(arg_);
 
   auto r = ctx->top()->get_runner().lock();
-  if (r)
+  if (!r)
+  {
+    delete ctx;
+    return;
+  }
+
+  for (std::size_t budget = CONTINUATION_BUDGET; ; --budget)
   {
     ctx->top()->entry_point(r, ctx->top());
     if (ctx->empty())
+    {
       delete ctx;
-    else
-      r->impl()->enqueue(task_executor, nullptr, ctx);
+      return;
+    }
+
+    auto next = ctx->top()->get_runner();
+    if (budget <= 1 || !same_runner(next, r) || r->impl()->has_preferred(ctx->urgency(), ctx->deadline()))
+    {
+      auto aux = next.lock();
+      if (!aux)
+      {
+        delete ctx;
+        return;
+      }
+
+      // the context stack that the bounded runner did not accept is reported
+      // to the top context's exception reporter and deleted
+      try { aux->impl()->enqueue(task_executor, nullptr, ctx, discard_stack, ctx->urgency(), ctx->deadline()); }
+      catch (...) { fail_stack(ctx, std::current_exception()); }
+      return;
+    }
   }
-  else
-    delete ctx;
 }
 
 void kickstart(context_stack* ctx_)
@@ -84,7 +252,114 @@ void kickstart(context_stack* ctx_)
     delete ctx_;
     throw exception::runner_not_available();
   }
-  aux->impl()->enqueue(task_executor, nullptr, ctx_);
+
+  try
+  {
+    aux->impl()->enqueue(task_executor, nullptr, ctx_, discard_stack, ctx_->urgency(), ctx_->deadline());
+  }
+  catch (...)
+  {
+    delete ctx_;
+    throw;
+  }
+}
+
+namespace {
+
+// timer callback for the delayed kickstart; enqueues the context stack to the
+// runner of its top context, or deletes it if this runner is gone. If the
+// runner does not accept the context stack, the failure is reported to the
+// exception reporter of the top context. The full bounded runner does not
+// accept it even with OverflowPolicy::BLOCK, as the timer thread must not
+// block.
+void delayed_kickstart(void* arg_)
+{
+  auto ctx = static_cast<context_stack*>(arg_);
+
+  auto aux = ctx->top()->get_runner().lock();
+  if (!aux)
+  {
+    delete ctx;
+    return;
+  }
+
+  try { aux->impl()->enqueue(task_executor, nullptr, ctx, discard_stack, ctx->urgency(), ctx->deadline()); }
+  catch (...) { fail_stack(ctx, std::current_exception()); }
+}
+
+} // anonymous namespace
+
+void kickstart(context_stack* ctx_, const runner::clock::time_point& when_)
+{
+  if (!ctx_)
+    throw exception::no_context();
+
+  if (ctx_->top()->get_runner().expired())
+  {
+    delete ctx_;
+    throw exception::runner_not_available();
+  }
+
+  try
+  {
+    impl::run_queue::schedule(when_, delayed_kickstart, ctx_);
+  }
+  catch (...)
+  {
+    delete ctx_;
+    throw;
+  }
+}
+
+void kickstart(context_stack* const* ctx_, std::size_t count_)
+{
+  for (std::size_t i = 0; i < count_; ++i)
+  {
+    if (!ctx_[i])
+    {
+      for (std::size_t j = 0; j < count_; ++j)
+        delete ctx_[j];
+      throw exception::no_context();
+    }
+  }
+
+  std::vector<void*> batch;
+  batch.reserve(count_);
+
+  for (std::size_t first = 0; first < count_; )
+  {
+    auto aux = ctx_[first]->top()->get_runner().lock();
+    if (!aux)
+    {
+      for (std::size_t j = first; j < count_; ++j)
+        delete ctx_[j];
+      throw exception::runner_not_available();
+    }
+
+    // consecutive stacks of the same urgency and deadline starting on the
+    // same runner go into one batch
+    auto urgency = ctx_[first]->urgency();
+    auto deadline = ctx_[first]->deadline();
+    batch.clear();
+    std::size_t last = first;
+    for ( ; last < count_
+          && ctx_[last]->urgency() == urgency
+          && ctx_[last]->deadline() == deadline
+          && same_runner(ctx_[last]->top()->get_runner(), aux); ++last)
+      batch.push_back(ctx_[last]);
+
+    try
+    {
+      aux->impl()->enqueue_batch(task_executor, nullptr, batch.data(), batch.size(), discard_stack, urgency, deadline);
+    }
+    catch (...)
+    {
+      for (std::size_t j = first; j < count_; ++j)
+        delete ctx_[j];
+      throw;
+    }
+    first = last;
+  }
 }
 
 }
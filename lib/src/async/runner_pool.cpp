@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <string>
+
+#include "cool/ng/async/runner_pool.h"
+
+namespace cool { namespace ng { namespace async {
+
+runner_pool::runner_pool(std::size_t size_, const runner::options& opts_)
+{
+  if (size_ == 0)
+    throw exception::illegal_argument("runner pool must have at least one runner");
+
+  // member runners must preserve the order of tasks of each key
+  auto opts = opts_;
+  opts.policy(RunPolicy::SEQUENTIAL);
+
+  m_runners.reserve(size_);
+  for (std::size_t i = 0; i < size_; ++i)
+    m_runners.push_back(std::make_shared<runner>(opts));
+}
+
+const runner::ptr& runner_pool::at(std::size_t index_) const
+{
+  if (index_ >= m_runners.size())
+    throw exception::illegal_argument("runner index " + std::to_string(index_) + " is out of range");
+  return m_runners[index_];
+}
+
+std::size_t runner_pool::depth(std::size_t index_) const
+{
+  return at(index_)->depth();
+}
+
+std::size_t runner_pool::least_loaded() const
+{
+  std::size_t ret = 0;
+  auto least = m_runners[0]->depth();
+
+  for (std::size_t i = 1; i < m_runners.size() && least > 0; ++i)
+  {
+    auto d = m_runners[i]->depth();
+    if (d < least)
+    {
+      least = d;
+      ret = i;
+    }
+  }
+
+  return ret;
+}
+
+// Mixes the hash value with the 64-bit finalizer of MurmurHash3, as the
+// standard hash of the integral types is the identity on some platforms
+std::size_t runner_pool::select(std::size_t hash_) const
+{
+  uint64_t h = hash_;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return static_cast<std::size_t>(h % m_runners.size());
+}
+
+} } } // namespace
@@ -66,7 +66,8 @@ std::string cool_ng_category::message(int ev) const
           "the request has failed",
           "the item was not found",
           "the item already exists",
-          "the expected context for the asynchronous or delayed  operation does not exist"
+          "the expected context for the asynchronous or delayed  operation does not exist",
+          "the task queue of the runner is full and did not accept the task"
   };
   static const char* const unknown = "unrecognized error";
 
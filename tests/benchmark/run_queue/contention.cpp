@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// ---
+// --- Producer contention benchmark for the run_queue task queue.
+// ---
+// --- Part one compares the raw queue operations of the mutex protected
+// --- std::deque, which was used as the task queue before, with the lock-free
+// --- mpsc_queue. Part two measures the end-to-end throughput of run_queue
+// --- fed from several producer threads, one task or a batch of tasks at a
+// --- time.
+// ---
+// --- Usage: run-queue-contention-bench [num_producers [num_items]]
+// ---
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+
+#include "run_queue.h"
+#include "lib/async/mpsc_queue.h"
+
+using cool::ng::async::impl::run_queue;
+using cool::ng::async::impl::mpsc_node;
+using cool::ng::async::impl::mpsc_queue;
+using clock_type = std::chrono::steady_clock;
+
+namespace {
+
+struct item : public mpsc_node
+{
+  item(std::size_t v_) : m_value(v_) { }
+  std::size_t m_value;
+};
+
+// the task queue as it was before
+class locked_queue
+{
+ public:
+  void push(item* i_)
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    m_fifo.push_back(i_);
+  }
+  item* pop()
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    if (m_fifo.empty())
+      return nullptr;
+    auto ret = m_fifo.front();
+    m_fifo.pop_front();
+    return ret;
+  }
+
+ private:
+  std::mutex         m_mutex;
+  std::deque<item*>  m_fifo;
+};
+
+// starts producers at the same time and returns elapsed time once the
+// consumer is done
+template <typename QueueT>
+double run_raw(QueueT& queue_, std::size_t producers_, std::size_t items_)
+{
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+
+  for (std::size_t i = 0; i < producers_; ++i)
+    threads.emplace_back([&]
+    {
+      while (!go)
+        std::this_thread::yield();
+      for (std::size_t n = 0; n < items_; ++n)
+        queue_.push(new item(n));
+    });
+
+  auto start = clock_type::now();
+  go = true;
+
+  std::size_t expected = producers_ * items_;
+  std::size_t received = 0;
+  while (received < expected)
+  {
+    auto i = queue_.pop();
+    if (i != nullptr)
+    {
+      delete i;
+      ++received;
+    }
+  }
+  auto elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+
+  for (auto& t : threads)
+    t.join();
+  return elapsed;
+}
+
+std::atomic<std::size_t> executed;
+
+void count_exec(void*)
+{
+  ++executed;
+}
+
+// batch_ of 0 uses enqueue(), otherwise enqueue_batch() with batch_ items
+double run_queue_feed(std::size_t producers_, std::size_t items_, std::size_t batch_ = 0)
+{
+  auto queue = run_queue::create();
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+  executed = 0;
+
+  for (std::size_t i = 0; i < producers_; ++i)
+    threads.emplace_back([&]
+    {
+      std::vector<void*> data(batch_, nullptr);
+      while (!go)
+        std::this_thread::yield();
+      if (batch_ == 0)
+      {
+        for (std::size_t n = 0; n < items_; ++n)
+          queue->enqueue(count_exec, nullptr, nullptr);
+      }
+      else
+      {
+        for (std::size_t n = 0; n < items_; n += batch_)
+          queue->enqueue_batch(count_exec, nullptr, data.data(), std::min(batch_, items_ - n));
+      }
+    });
+
+  auto start = clock_type::now();
+  go = true;
+
+  while (executed < producers_ * items_)
+    std::this_thread::yield();
+  auto elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+
+  for (auto& t : threads)
+    t.join();
+  run_queue::release(queue);
+  return elapsed;
+}
+
+void report(const std::string& what_, std::size_t total_, double elapsed_)
+{
+  std::cout << std::left << std::setw(40) << what_
+            << std::right << std::setw(10) << std::fixed << std::setprecision(3) << elapsed_ * 1000 << " ms"
+            << std::setw(14) << std::setprecision(0) << total_ / elapsed_ << " ops/s" << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  std::size_t producers = std::thread::hardware_concurrency();
+  std::size_t items = 1000000;
+
+  if (argc > 1)
+    producers = std::strtoul(argv[1], nullptr, 10);
+  if (argc > 2)
+    items = std::strtoul(argv[2], nullptr, 10);
+  if (producers == 0)
+    producers = 4;
+
+  std::cout << "producers: " << producers << ", items per producer: " << items << std::endl;
+
+  {
+    locked_queue q;
+    report("std::mutex + std::deque", producers * items, run_raw(q, producers, items));
+  }
+  {
+    mpsc_queue<item> q;
+    report("lock-free mpsc_queue", producers * items, run_raw(q, producers, items));
+  }
+
+  report("run_queue enqueue + execute", producers * items, run_queue_feed(producers, items));
+  report("run_queue enqueue_batch(32) + execute", producers * items, run_queue_feed(producers, items, 32));
+
+  return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// ---
+// --- Memory footprint benchmark for the runner.
+// ---
+// --- Creates many idle runners and reports the heap memory and the number
+// --- of heap allocations per runner, then submits a single task to each
+// --- runner and reports the memory held once all tasks completed. The heap
+// --- use is measured by counting the calls of the global operator new and
+// --- operator delete; the memory allocated with malloc() directly, such as
+// --- the memory of the worker threads, is not included.
+// ---
+// --- The benchmark fails if the idle runner takes more than IDLE_BYTES bytes
+// --- or IDLE_ALLOCATIONS heap allocations.
+// ---
+// --- Usage: runner-footprint-bench [num_runners]
+// ---
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <memory>
+
+#include "cool/ng/async/runner.h"
+#include "run_queue.h"
+
+using cool::ng::async::runner;
+
+namespace {
+
+// bound on the idle runner: 24 bytes of runner and 112 bytes of run_queue
+// with the control block of std::make_shared, on 64-bit platforms
+const double IDLE_BYTES = 136;
+const double IDLE_ALLOCATIONS = 2;
+
+std::atomic<long long> heap_bytes(0);
+std::atomic<long long> heap_blocks(0);
+
+// the block header keeps the size for the accounting in operator delete
+const std::size_t HEADER = alignof(std::max_align_t);
+
+void* counted_alloc(std::size_t size_)
+{
+  auto p = static_cast<char*>(std::malloc(size_ + HEADER));
+  if (p == nullptr)
+    throw std::bad_alloc();
+  *reinterpret_cast<std::size_t*>(p) = size_;
+  heap_bytes += size_;
+  ++heap_blocks;
+  return p + HEADER;
+}
+
+void counted_free(void* p_)
+{
+  if (p_ == nullptr)
+    return;
+  auto p = static_cast<char*>(p_) - HEADER;
+  heap_bytes -= *reinterpret_cast<std::size_t*>(p);
+  --heap_blocks;
+  std::free(p);
+}
+
+std::atomic<std::size_t> executed;
+
+void count_exec(void*)
+{
+  ++executed;
+}
+
+void report(const std::string& what_, long long bytes_, long long blocks_, std::size_t count_)
+{
+  std::cout << std::left << std::setw(36) << what_
+            << std::right << std::setw(10) << std::fixed << std::setprecision(1)
+            << static_cast<double>(bytes_) / count_ << " bytes"
+            << std::setw(10) << std::setprecision(2)
+            << static_cast<double>(blocks_) / count_ << " allocations" << std::endl;
+}
+
+} // anonymous namespace
+
+void* operator new(std::size_t size_)
+{
+  return counted_alloc(size_);
+}
+
+void operator delete(void* p_) noexcept
+{
+  counted_free(p_);
+}
+
+void* operator new[](std::size_t size_)
+{
+  return counted_alloc(size_);
+}
+
+void operator delete[](void* p_) noexcept
+{
+  counted_free(p_);
+}
+
+int main(int argc, char* argv[])
+{
+  std::size_t count = 1000000;
+
+  if (argc > 1)
+    count = std::strtoul(argv[1], nullptr, 10);
+  if (count == 0)
+    count = 1;
+
+  std::cout << "runners: " << count << std::endl;
+  std::cout << "sizeof(runner): " << sizeof(runner)
+            << ", sizeof(run_queue): " << sizeof(cool::ng::async::impl::run_queue) << std::endl;
+
+  {
+    // warm up the worker threads and the context pool
+    runner r;
+    executed = 0;
+    r.impl()->enqueue(count_exec, nullptr, nullptr);
+    while (executed < 1)
+      std::this_thread::yield();
+  }
+
+  std::vector<std::unique_ptr<runner>> runners;
+  runners.reserve(count);
+
+  auto bytes = heap_bytes.load();
+  auto blocks = heap_blocks.load();
+  for (std::size_t i = 0; i < count; ++i)
+    runners.emplace_back(new runner());
+  report("idle runner", heap_bytes - bytes, heap_blocks - blocks, count);
+  double idle_bytes = static_cast<double>(heap_bytes - bytes) / count;
+  double idle_allocations = static_cast<double>(heap_blocks - blocks) / count;
+
+  executed = 0;
+  for (auto& r : runners)
+    r->impl()->enqueue(count_exec, nullptr, nullptr);
+  while (executed < count)
+    std::this_thread::yield();
+  // the drains release the runners shortly after the last task
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  report("runner after one task", heap_bytes - bytes, heap_blocks - blocks, count);
+
+  std::size_t names = 0;
+  for (auto& r : runners)
+    names += r->name().size();
+  report("runner after name()", heap_bytes - bytes, heap_blocks - blocks, count);
+
+  runners.clear();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  report("left after destruction", heap_bytes - bytes, heap_blocks - blocks, count);
+
+  if (idle_bytes > IDLE_BYTES || idle_allocations > IDLE_ALLOCATIONS)
+  {
+    std::cout << "FAILED: the idle runner exceeds " << IDLE_BYTES << " bytes or "
+              << IDLE_ALLOCATIONS << " allocations" << std::endl;
+    return 1;
+  }
+
+  return names > 0 ? 0 : 1;
+}
@@ -31,14 +31,23 @@
 #include <thread>
 #include <chrono>
 #include <condition_variable>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(LINUX_TARGET)
+# include <sched.h>
+#endif
 
 #define BOOST_TEST_MODULE RunQueue
 #include <unit_test_common.h>
 
 #include "run_queue.h"
+#include "lib/async/object_pool.h"
 
 using namespace cool::ng::async::impl;
 using ms = std::chrono::milliseconds;
+using us = std::chrono::microseconds;
 
 bool spin_wait(unsigned int msec, const std::function<bool()>& lambda)
 {
@@ -122,8 +131,1098 @@ COOL_AUTO_TEST_CASE(T003,
   BOOST_CHECK(spin_wait(50, [] () { return aux == 2; }));
   BOOST_CHECK_EQUAL(2, aux);
 
-  // prove that run_queue instance is now gone
-  BOOST_CHECK(!test_gone.lock());
+  // prove that run_queue instance is now gone; the worker thread may still
+  // be on its way out of the last task so give it a moment
+  BOOST_CHECK(spin_wait(50, [&] () { return !test_gone.lock(); }));
+}
+
+COOL_AUTO_TEST_CASE(T004,
+    *utf::description("check that tasks from concurrent producers are all run, each producer's in order"))
+{
+  const int NUM_TASKS = 10000;
+  const int NUM_THREADS = 4;
+
+  struct tag
+  {
+    int producer;
+    int sequence;
+  };
+
+  static std::atomic_int aux;
+  static std::atomic_bool in_order;
+  static int last[NUM_THREADS];
+  aux = 0;
+  in_order = true;
+  for (int i = 0; i < NUM_THREADS; ++i)
+    last[i] = -1;
+
+  auto rq = run_queue::create();
+  auto check_order = [](void* data_)
+  {
+    auto t = static_cast<tag*>(data_);
+    if (last[t->producer] + 1 != t->sequence)
+      in_order = false;
+    last[t->producer] = t->sequence;
+    ++aux;
+  };
+  auto del = [](void* data_) { delete static_cast<tag*>(data_); };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < NUM_THREADS; ++i)
+    threads.emplace_back([&, i]
+    {
+      for (int n = 0; n < NUM_TASKS; ++n)
+        rq->enqueue(check_order, del, new tag{ i, n });
+    });
+  for (auto& t : threads)
+    t.join();
+
+  BOOST_CHECK(spin_wait(5000, [&] () { return aux == NUM_TASKS * NUM_THREADS; }));
+  BOOST_CHECK_EQUAL(NUM_TASKS * NUM_THREADS, aux);
+  BOOST_CHECK(in_order);
+  run_queue::release(rq);
+}
+
+COOL_AUTO_TEST_CASE(T005,
+    *utf::description("check that the drain executes queued tasks in order on a single worker hop"))
+{
+  const int NUM_TASKS = 100;
+
+  static std::atomic_int aux;
+  static std::atomic_bool in_order;
+  static std::vector<std::thread::id> ids;
+  aux = 0;
+  in_order = true;
+  ids.clear();
+  ids.resize(NUM_TASKS);
+
+  auto record = [](void* data_)
+  {
+    auto n = static_cast<int>(reinterpret_cast<std::intptr_t>(data_));
+    if (n != aux)
+      in_order = false;
+    ids[n] = std::this_thread::get_id();
+    ++aux;
+  };
+
+  {
+    auto rq = run_queue::create(cool::ng::async::runner::options()
+        .drain_limit(NUM_TASKS)
+        .drain_time(std::chrono::seconds(0)));
+    rq->stop();
+    for (int i = 0; i < NUM_TASKS; ++i)
+      rq->enqueue(record, nullptr, reinterpret_cast<void*>(static_cast<std::intptr_t>(i)));
+    rq->start();
+
+    BOOST_CHECK(spin_wait(1000, [&] () { return aux == NUM_TASKS; }));
+    BOOST_CHECK(in_order);
+    for (int i = 1; i < NUM_TASKS; ++i)
+      BOOST_CHECK(ids[0] == ids[i]);
+    run_queue::release(rq);
+  }
+
+  BOOST_CHECK_THROW(cool::ng::async::runner::options().drain_limit(0), cool::ng::exception::illegal_argument);
+}
+
+COOL_AUTO_TEST_CASE(T006,
+    *utf::description("check that many queues share the worker threads and each still runs its tasks sequentially"))
+{
+  const int NUM_QUEUES = 64;
+  const int NUM_TASKS = 1000;
+
+  struct slot
+  {
+    std::atomic_bool busy;
+    std::atomic_int count;
+  };
+
+  static std::atomic_int aux;
+  static std::atomic_bool sequential;
+  static slot slots[NUM_QUEUES];
+  aux = 0;
+  sequential = true;
+  for (auto& s : slots)
+  {
+    s.busy = false;
+    s.count = 0;
+  }
+
+  auto work = [](void* data_)
+  {
+    auto s = static_cast<slot*>(data_);
+    if (s->busy.exchange(true))
+      sequential = false;
+    ++s->count;
+    s->busy = false;
+    ++aux;
+  };
+
+  std::vector<run_queue::pointer> queues;
+  for (int i = 0; i < NUM_QUEUES; ++i)
+    queues.push_back(run_queue::create());
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([&, t]
+    {
+      for (int n = 0; n < NUM_TASKS * NUM_QUEUES / 4; ++n)
+      {
+        int q = (n + t) % NUM_QUEUES;
+        queues[q]->enqueue(work, nullptr, &slots[q]);
+      }
+    });
+  for (auto& t : threads)
+    t.join();
+
+  BOOST_CHECK(spin_wait(5000, [&] () { return aux == NUM_TASKS * NUM_QUEUES; }));
+  BOOST_CHECK(sequential);
+  for (auto& s : slots)
+    BOOST_CHECK_EQUAL(NUM_TASKS, s.count);
+  for (auto& q : queues)
+    run_queue::release(q);
+}
+
+COOL_AUTO_TEST_CASE(T007,
+    *utf::description("check that concurrent queue runs all tasks, including tasks enqueued by tasks, and holds them while stopped"))
+{
+  const int FAN_OUT = 4;
+  const int DEPTH = 7;        // 4^0 + 4^1 + ... + 4^7 tasks
+  const int NUM_TASKS = (1 << (2 * (DEPTH + 1))) / 3;
+
+  static std::atomic_int aux;
+  static std::atomic_int running;
+  static std::atomic_int max_running;
+  static run_queue* queue;
+  static run_queue::executor spawn_task;
+  aux = 0;
+  running = 0;
+  max_running = 0;
+
+  auto spawn = [](void* data_)
+  {
+    auto depth = static_cast<int>(reinterpret_cast<std::intptr_t>(data_));
+    auto r = ++running;
+    for (auto m = max_running.load(); r > m && !max_running.compare_exchange_weak(m, r); )
+      ;
+
+    if (depth > 0)
+      for (int i = 0; i < FAN_OUT; ++i)
+        queue->enqueue(spawn_task, nullptr, reinterpret_cast<void*>(static_cast<std::intptr_t>(depth - 1)));
+
+    // some CPU work to give the other workers a chance to steal
+    volatile unsigned long x = 0;
+    for (int i = 0; i < 2000; ++i)
+      x += i;
+
+    --running;
+    ++aux;
+  };
+  spawn_task = spawn;
+
+  auto rq = run_queue::create(cool::ng::async::runner::options()
+      .policy(cool::ng::async::RunPolicy::CONCURRENT));
+  queue = rq.get();
+
+  rq->stop();
+  rq->enqueue(spawn, nullptr, reinterpret_cast<void*>(static_cast<std::intptr_t>(DEPTH)));
+  BOOST_CHECK(!spin_wait(50, [] () { return aux > 0; }));
+  rq->start();
+
+  BOOST_CHECK(spin_wait(10000, [&] () { return aux == NUM_TASKS; }));
+  BOOST_CHECK_EQUAL(NUM_TASKS, aux);
+  if (std::thread::hardware_concurrency() > 1)
+    BOOST_CHECK_GT(max_running.load(), 1);
+  run_queue::release(rq);
+}
+
+COOL_AUTO_TEST_CASE(T008,
+    *utf::description("check that the batch is run in order and not interleaved with concurrently enqueued tasks"))
+{
+  const int NUM_BATCHES = 100;
+  const int BATCH_SIZE = 50;
+  const int NUM_SINGLES = 5000;
+  const std::intptr_t SINGLE = -1;
+
+  static std::atomic_int aux;
+  static std::atomic_bool contiguous;
+  static std::intptr_t last;
+  aux = 0;
+  contiguous = true;
+  last = SINGLE;
+
+  // batch elements are numbered 0 .. BATCH_SIZE-1; each element but the first
+  // must immediately follow its predecessor
+  auto check = [](void* data_)
+  {
+    auto n = reinterpret_cast<std::intptr_t>(data_);
+    if (n > 0 && n != last + 1)
+      contiguous = false;
+    if (n == SINGLE && last != SINGLE && last != BATCH_SIZE - 1)
+      contiguous = false;
+    last = n;
+    ++aux;
+  };
+
+  std::vector<void*> batch;
+  for (std::intptr_t i = 0; i < BATCH_SIZE; ++i)
+    batch.push_back(reinterpret_cast<void*>(i));
+
+  auto rq = run_queue::create();
+  rq->enqueue_batch(check, nullptr, batch.data(), 0);
+
+  std::thread singles([&]
+  {
+    for (int i = 0; i < NUM_SINGLES; ++i)
+      rq->enqueue(check, nullptr, reinterpret_cast<void*>(SINGLE));
+  });
+  for (int i = 0; i < NUM_BATCHES; ++i)
+    rq->enqueue_batch(check, nullptr, batch.data(), batch.size());
+  singles.join();
+
+  BOOST_CHECK(spin_wait(5000, [&] () { return aux == NUM_BATCHES * BATCH_SIZE + NUM_SINGLES; }));
+  BOOST_CHECK_EQUAL(NUM_BATCHES * BATCH_SIZE + NUM_SINGLES, aux);
+  BOOST_CHECK(contiguous);
+  run_queue::release(rq);
+}
+
+COOL_AUTO_TEST_CASE(T009,
+    *utf::description("check that object_pool reuses blocks released on the same and on other threads"))
+{
+  struct object { char data[48]; };
+  using pool = cool::ng::async::impl::object_pool<object, 4>;
+
+  // same thread, last released block is allocated first
+  auto p = pool::allocate();
+  pool::deallocate(p);
+  BOOST_CHECK_EQUAL(p, pool::allocate());
+  pool::deallocate(p);
+
+  // blocks released by the other thread reach this thread through the depot
+  std::vector<void*> blocks;
+  for (int i = 0; i < 8; ++i)
+    blocks.push_back(pool::allocate());
+  std::thread([&] { for (auto b : blocks) pool::deallocate(b); }).join();
+
+  int reused = 0;
+  std::vector<void*> again;
+  for (int i = 0; i < 8; ++i)
+  {
+    again.push_back(pool::allocate());
+    if (std::find(blocks.begin(), blocks.end(), again.back()) != blocks.end())
+      ++reused;
+  }
+  BOOST_CHECK_GE(reused, 4);
+  for (auto b : again)
+    pool::deallocate(b);
+}
+
+COOL_AUTO_TEST_CASE(T011,
+    *utf::description("check the scheduling metrics of sequential and concurrent run queues"))
+{
+  using metrics = cool::ng::async::runner::metrics;
+  const int NUM_TASKS = 1000;
+
+  static std::atomic_int aux;
+  auto task = [](void*) { ++aux; };
+  auto total = [](const std::uint64_t* h_)
+  {
+    std::uint64_t ret = 0;
+    for (std::size_t i = 0; i < metrics::histogram_size; ++i)
+      ret += h_[i];
+    return ret;
+  };
+
+  {
+    auto rq = run_queue::create();
+    metrics m;
+    rq->snapshot(m);
+    BOOST_CHECK(!m.enabled);
+    run_queue::release(rq);
+  }
+
+  for (auto policy : { cool::ng::async::RunPolicy::SEQUENTIAL, cool::ng::async::RunPolicy::CONCURRENT })
+  {
+    aux = 0;
+    auto rq = run_queue::create(cool::ng::async::runner::options()
+        .collect_metrics(true)
+        .policy(policy));
+
+    rq->stop();
+    for (int i = 0; i < NUM_TASKS; ++i)
+      rq->enqueue(task, nullptr, nullptr);
+
+    metrics m;
+    rq->snapshot(m);
+    BOOST_CHECK(m.enabled);
+    BOOST_CHECK_EQUAL(NUM_TASKS, m.depth);
+    BOOST_CHECK_EQUAL(NUM_TASKS, m.high_water);
+    BOOST_CHECK_EQUAL(0, m.count);
+
+    rq->start();
+    BOOST_CHECK(spin_wait(5000, [&] () { rq->snapshot(m); return m.count == NUM_TASKS; }));
+    // the values are not read atomically; re-read them after the tasks completed
+    rq->snapshot(m);
+    BOOST_CHECK_EQUAL(NUM_TASKS, aux);
+    BOOST_CHECK_EQUAL(NUM_TASKS, m.count);
+    BOOST_CHECK_EQUAL(0, m.depth);
+    BOOST_CHECK_EQUAL(NUM_TASKS, m.high_water);
+    BOOST_CHECK_EQUAL(NUM_TASKS, total(m.wait));
+    BOOST_CHECK_EQUAL(NUM_TASKS, total(m.run));
+    run_queue::release(rq);
+  }
+}
+
+COOL_AUTO_TEST_CASE(T012,
+    *utf::description("check that the bounded queue with REJECT policy throws queue_full when full"))
+{
+  const int CAPACITY = 4;
+
+  static std::atomic_int aux;
+  aux = 0;
+  auto task = [](void*) { ++aux; };
+
+  auto rq = run_queue::create(cool::ng::async::runner::options()
+      .capacity(CAPACITY, cool::ng::async::OverflowPolicy::REJECT));
+
+  rq->stop();
+  for (int i = 0; i < CAPACITY; ++i)
+    rq->enqueue(task, nullptr, nullptr);
+  try
+  {
+    rq->enqueue(task, nullptr, nullptr);
+    BOOST_FAIL("queue_full exception expected");
+  }
+  catch (const cool::ng::exception::queue_full& e)
+  {
+    BOOST_CHECK(e.code() == cool::ng::error::make_error_code(cool::ng::error::errc::queue_full));
+  }
+
+  // the batch is rejected as a whole
+  std::vector<void*> batch(2, nullptr);
+  BOOST_CHECK_THROW(rq->enqueue_batch(task, nullptr, batch.data(), batch.size()), cool::ng::exception::queue_full);
+
+  rq->start();
+  BOOST_CHECK(spin_wait(1000, [] () { return aux == CAPACITY; }));
+  BOOST_CHECK(!spin_wait(50, [] () { return aux > CAPACITY; }));
+
+  // the batch larger than the capacity is accepted by the empty queue
+  rq->stop();
+  batch.resize(3 * CAPACITY, nullptr);
+  rq->enqueue_batch(task, nullptr, batch.data(), batch.size());
+  BOOST_CHECK_THROW(rq->enqueue(task, nullptr, nullptr), cool::ng::exception::queue_full);
+  rq->start();
+  BOOST_CHECK(spin_wait(1000, [] () { return aux == 4 * CAPACITY; }));
+  run_queue::release(rq);
+}
+
+COOL_AUTO_TEST_CASE(T013,
+    *utf::description("check that the bounded queue with BLOCK policy blocks the producer but not its own tasks"))
+{
+  const int CAPACITY = 2;
+  const int NUM_SPAWNED = 10;
+
+  static std::atomic_int aux;
+  static run_queue* queue;
+  aux = 0;
+  auto task = [](void*) { ++aux; };
+
+  auto rq = run_queue::create(cool::ng::async::runner::options()
+      .capacity(CAPACITY, cool::ng::async::OverflowPolicy::BLOCK));
+  queue = rq.get();
+
+  rq->stop();
+  for (int i = 0; i < CAPACITY; ++i)
+    rq->enqueue(task, nullptr, nullptr);
+
+  std::atomic_bool done;
+  done = false;
+  std::thread producer([&] ()
+  {
+    rq->enqueue(task, nullptr, nullptr);
+    done = true;
+  });
+
+  BOOST_CHECK(!spin_wait(100, [&] () { return done.load(); }));
+  rq->start();
+  BOOST_CHECK(spin_wait(1000, [&] () { return done.load(); }));
+  producer.join();
+  BOOST_CHECK(spin_wait(1000, [] () { return aux == CAPACITY + 1; }));
+
+  // the task submitting more tasks than the capacity to its own queue
+  aux = 0;
+  rq->enqueue(
+      [](void*)
+      {
+        for (int i = 0; i < NUM_SPAWNED; ++i)
+          queue->enqueue([](void*) { ++aux; }, nullptr, nullptr);
+      }
+    , nullptr
+    , nullptr);
+  BOOST_CHECK(spin_wait(1000, [] () { return aux == NUM_SPAWNED; }));
+  run_queue::release(rq);
+}
+
+COOL_AUTO_TEST_CASE(T014,
+    *utf::description("check that the bounded queue with DROP_OLDEST policy discards the oldest tasks"))
+{
+  const int CAPACITY = 3;
+  const int NUM_TASKS = 10;
+
+  static std::mutex lock;
+  static std::vector<std::intptr_t> executed;
+  static std::atomic_int discarded;
+  executed.clear();
+  discarded = 0;
+
+  auto task = [](void* data_)
+  {
+    std::unique_lock<std::mutex> l(lock);
+    executed.push_back(reinterpret_cast<std::intptr_t>(data_));
+  };
+  auto discard = [](void*) { ++discarded; };
+
+  for (auto policy : { cool::ng::async::RunPolicy::SEQUENTIAL, cool::ng::async::RunPolicy::CONCURRENT })
+  {
+    executed.clear();
+    discarded = 0;
+
+    auto rq = run_queue::create(cool::ng::async::runner::options()
+        .capacity(CAPACITY, cool::ng::async::OverflowPolicy::DROP_OLDEST)
+        .collect_metrics(true)
+        .policy(policy));
+
+    rq->stop();
+    for (std::intptr_t i = 1; i <= NUM_TASKS; ++i)
+      rq->enqueue(task, nullptr, reinterpret_cast<void*>(i), discard);
+    BOOST_CHECK_EQUAL(NUM_TASKS - CAPACITY, discarded);
+
+    rq->start();
+    BOOST_CHECK(spin_wait(1000, [&] () { std::unique_lock<std::mutex> l(lock); return executed.size() == CAPACITY; }));
+    BOOST_CHECK(!spin_wait(50, [&] () { std::unique_lock<std::mutex> l(lock); return executed.size() > CAPACITY; }));
+
+    std::sort(executed.begin(), executed.end());
+    for (int i = 0; i < CAPACITY; ++i)
+      BOOST_CHECK_EQUAL(NUM_TASKS - CAPACITY + 1 + i, executed[i]);
+
+    cool::ng::async::runner::metrics m;
+    rq->snapshot(m);
+    BOOST_CHECK_EQUAL(NUM_TASKS - CAPACITY, m.dropped);
+    BOOST_CHECK_EQUAL(0, m.depth);
+    run_queue::release(rq);
+  }
+}
+
+COOL_AUTO_TEST_CASE(T015,
+    *utf::description("check the system-wide runners and that the priority classes do not share the worker threads"))
+{
+  using cool::ng::async::runner;
+
+  static std::atomic_int aux;
+  aux = 0;
+
+  auto runners = { runner::sys_high(), runner::sys_default(), runner::sys_low(), runner::sys_background(), runner::cool_default() };
+  for (auto& r : runners)
+  {
+    BOOST_REQUIRE(r);
+    r->impl()->enqueue([](void*) { ++aux; }, nullptr, nullptr);
+  }
+  BOOST_CHECK(spin_wait(1000, [&] () { return aux == static_cast<int>(runners.size()); }));
+  BOOST_CHECK_EQUAL(runner::sys_high(), runner::sys_high());
+  BOOST_CHECK_NE(runner::sys_high(), runner::sys_default());
+
+#if defined(POSIX_POOL)
+  // occupy all worker threads of the default priority class
+  const int NUM_BLOCKERS = 256;
+  static std::atomic_bool release;
+  static std::atomic_int blocked;
+  release = false;
+  blocked = 0;
+
+  auto blocker = run_queue::create(runner::options().policy(cool::ng::async::RunPolicy::CONCURRENT));
+  auto high = run_queue::create(runner::options().priority(cool::ng::async::Priority::HIGH));
+  for (int i = 0; i < NUM_BLOCKERS; ++i)
+    blocker->enqueue(
+        [](void*)
+        {
+          ++blocked;
+          while (!release)
+            std::this_thread::sleep_for(ms(1));
+        }
+      , nullptr
+      , nullptr);
+
+  BOOST_CHECK(spin_wait(1000, [] () { return blocked > 0; }));
+  aux = 0;
+  high->enqueue([](void*) { ++aux; }, nullptr, nullptr);
+  BOOST_CHECK(spin_wait(1000, [] () { return aux == 1; }));
+  BOOST_CHECK_LT(blocked.load(), NUM_BLOCKERS);
+
+  release = true;
+  BOOST_CHECK(spin_wait(5000, [] () { return blocked == NUM_BLOCKERS; }));
+  run_queue::release(high);
+  run_queue::release(blocker);
+#endif
+}
+
+COOL_AUTO_TEST_CASE(T016,
+    *utf::description("check that the pinned run queue executes its tasks on the requested CPUs"))
+{
+  using cool::ng::async::runner;
+
+  // the unpinned runner reports no placement
+  BOOST_CHECK(runner().location().cpus.empty());
+  BOOST_CHECK(runner().location().numa_node == runner::options::any_node);
+
+#if defined(POSIX_POOL) && defined(LINUX_TARGET)
+  static std::atomic_int aux;
+  static std::atomic_int misplaced;
+  aux = 0;
+  misplaced = 0;
+
+  runner r(runner::options().affinity({ 0 }));
+  BOOST_REQUIRE_EQUAL(1, r.location().cpus.size());
+  BOOST_CHECK_EQUAL(0, r.location().cpus[0]);
+  for (int i = 0; i < 100; ++i)
+    r.impl()->enqueue(
+        [](void*)
+        {
+          if (::sched_getcpu() != 0)
+            ++misplaced;
+          ++aux;
+        }
+      , nullptr
+      , nullptr);
+  BOOST_CHECK(spin_wait(1000, [] () { return aux == 100; }));
+  BOOST_CHECK_EQUAL(0, misplaced);
+
+  runner n(runner::options().numa_node(0));
+  BOOST_CHECK_EQUAL(0, n.location().numa_node);
+  BOOST_CHECK(!n.location().cpus.empty());
+
+  BOOST_CHECK_THROW(runner(runner::options().numa_node(100000)), cool::ng::exception::illegal_argument);
+  BOOST_CHECK_THROW(runner(runner::options().affinity({ 100000 })), cool::ng::exception::illegal_argument);
+#endif
+}
+
+COOL_AUTO_TEST_CASE(T017,
+    *utf::description("check that the dedicated runner executes its tasks on its own thread"))
+{
+  using cool::ng::async::runner;
+
+  static std::atomic_int aux;
+  static std::mutex mutex;
+  static std::vector<std::thread::id> ids;
+  auto record = [](void*)
+  {
+    std::unique_lock<std::mutex> l(mutex);
+    ids.push_back(std::this_thread::get_id());
+    ++aux;
+  };
+
+  for (auto spin : { us(0), us(200) })
+  {
+    aux = 0;
+    ids.clear();
+
+    {
+      runner r(runner::options().dedicated_thread(true).busy_poll(spin));
+      for (int i = 0; i < 100; ++i)
+      {
+        r.impl()->enqueue(record, nullptr, nullptr);
+        // let the thread run out of tasks and poll, or park
+        if (i % 10 == 0)
+          std::this_thread::sleep_for(us(50));
+      }
+      BOOST_CHECK(spin_wait(1000, [] () { return aux == 100; }));
+
+      // the runner is destroyed with the tasks still waiting, on its own thread
+      for (int i = 0; i < 10; ++i)
+        r.impl()->enqueue([](void*) { std::this_thread::sleep_for(us(100)); ++aux; }, nullptr, nullptr);
+    }
+    BOOST_CHECK(spin_wait(1000, [] () { return aux == 110; }));
+
+    std::unique_lock<std::mutex> l(mutex);
+    BOOST_REQUIRE_EQUAL(100, ids.size());
+    BOOST_CHECK(std::all_of(ids.begin(), ids.end(), [](const std::thread::id& id) { return id == ids[0]; }));
+    BOOST_CHECK(ids[0] != std::this_thread::get_id());
+  }
+
+  // the tasks of other runners do not run on the dedicated thread
+  aux = 0;
+  ids.clear();
+  {
+    runner d(runner::options().dedicated_thread(true));
+    runner r;
+    d.impl()->enqueue(record, nullptr, nullptr);
+    BOOST_CHECK(spin_wait(1000, [] () { return aux == 1; }));
+    for (int i = 0; i < 100; ++i)
+      r.impl()->enqueue(record, nullptr, nullptr);
+    BOOST_CHECK(spin_wait(1000, [] () { return aux == 101; }));
+  }
+  std::unique_lock<std::mutex> l(mutex);
+  BOOST_CHECK(std::find(ids.begin() + 1, ids.end(), ids[0]) == ids.end());
+}
+
+COOL_AUTO_TEST_CASE(T018,
+    *utf::description("check the names and the independence of run queues sharing the configuration"))
+{
+  using cool::ng::async::runner;
+
+  // default names are created on demand and are unique
+  auto q1 = run_queue::create();
+  auto q2 = run_queue::create();
+  BOOST_CHECK_EQUAL(std::string(run_queue::default_prefix) + "-" + std::to_string(q1->id()), q1->name());
+  BOOST_CHECK(&q1->name() == &q1->name());
+  BOOST_CHECK(q1->name() != q2->name());
+  auto q3 = run_queue::create("custom");
+  BOOST_CHECK_EQUAL("custom-" + std::to_string(q3->id()), q3->name());
+
+  // run queues of the same configuration are independent of each other
+  static std::atomic_int aux;
+  aux = 0;
+  q1->stop();
+  q1->enqueue([](void*) { ++aux; }, nullptr, nullptr);
+  q2->enqueue([](void*) { ++aux; }, nullptr, nullptr);
+  BOOST_CHECK(spin_wait(1000, [] () { return aux == 1; }));
+  BOOST_CHECK(q1->depth() == 1 && q2->depth() == 0);
+  q1->start();
+  BOOST_CHECK(spin_wait(1000, [] () { return aux == 2; }));
+
+  run_queue::release(q1);
+  run_queue::release(q2);
+  run_queue::release(q3);
+}
+
+COOL_AUTO_TEST_CASE(T019,
+    *utf::description("check that the fair run queues share the worker thread according to their weights"))
+{
+#if defined(POSIX_POOL) && defined(LINUX_TARGET)
+  using cool::ng::async::runner;
+
+  // the run queues pinned to the same CPU share the single worker thread
+  static std::mutex mutex;
+  static std::string trace;
+  struct entry
+  {
+    char                      id;
+    std::chrono::microseconds cost;
+  };
+  auto exec = [](void* data_)
+  {
+    auto e = static_cast<entry*>(data_);
+    auto end = std::chrono::steady_clock::now() + e->cost;
+    while (std::chrono::steady_clock::now() < end)
+      ;
+    std::unique_lock<std::mutex> l(mutex);
+    trace.push_back(e->id);
+  };
+  auto del = [](void* data_) { delete static_cast<entry*>(data_); };
+  auto wait_for = [](std::size_t size_)
+  {
+    for (int i = 0; i < 500; ++i)
+    {
+      {
+        std::unique_lock<std::mutex> l(mutex);
+        if (trace.size() >= size_)
+          return true;
+      }
+      std::this_thread::sleep_for(ms(10));
+    }
+    return false;
+  };
+
+  // holds the worker thread while the run queues are started, so they get
+  // their first turns in the order of start
+  auto hold = [](const runner::options& opts_, const std::function<void()>& start_)
+  {
+    static std::atomic<bool> held;
+    static std::atomic<bool> release;
+    held = false;
+    release = false;
+    auto gate = run_queue::create(runner::options(opts_).fair_share(0));
+    gate->enqueue([](void*) { held = true; while (!release) std::this_thread::yield(); }, nullptr, nullptr);
+    while (!held)
+      std::this_thread::yield();
+    start_();
+    release = true;
+    run_queue::release(gate);
+  };
+
+  // without the time accounting the weights scale the drain limit
+  {
+    trace.clear();
+    auto opts = runner::options().affinity({ 0 }).drain_limit(4).drain_time(us(0));
+    auto a = run_queue::create(runner::options(opts).fair_share(1));
+    auto b = run_queue::create(runner::options(opts).fair_share(3));
+    a->stop();
+    b->stop();
+    for (int i = 0; i < 64; ++i)
+    {
+      a->enqueue(exec, del, new entry { 'a', us(0) });
+      b->enqueue(exec, del, new entry { 'b', us(0) });
+    }
+    hold(opts, [&] () { a->start(); b->start(); });
+    BOOST_REQUIRE(wait_for(128));
+    std::unique_lock<std::mutex> l(mutex);
+    BOOST_CHECK_EQUAL("aaaabbbbbbbbbbbbaaaabbbbbbbbbbbbaaaabbbbbbbbbbbb", trace.substr(0, 48));
+    l.unlock();
+    run_queue::release(a);
+    run_queue::release(b);
+  }
+
+  // the run queue that overspent its turn pays the debt with its next turns
+  {
+    trace.clear();
+    auto opts = runner::options().affinity({ 0 }).drain_limit(1000).drain_time(ms(1)).fair_share(1);
+    auto a = run_queue::create(opts);
+    auto b = run_queue::create(opts);
+    a->stop();
+    b->stop();
+    a->enqueue(exec, del, new entry { 'A', us(8000) });
+    a->enqueue(exec, del, new entry { 'a', us(0) });
+    for (int i = 0; i < 60; ++i)
+      b->enqueue(exec, del, new entry { 'b', us(250) });
+    hold(opts, [&] () { a->start(); b->start(); });
+    BOOST_REQUIRE(wait_for(62));
+    std::unique_lock<std::mutex> l(mutex);
+    BOOST_REQUIRE_EQUAL('A', trace[0]);
+    auto next = trace.find('a');
+    BOOST_REQUIRE(next != std::string::npos);
+    // the debt of some 7 turns delays the queue for some 28 tasks, while the
+    // queue without the debt would get its next turn after some 4 tasks
+    BOOST_CHECK_GE(next - 1, 12);
+    l.unlock();
+    run_queue::release(a);
+    run_queue::release(b);
+  }
+#endif
+}
+
+COOL_AUTO_TEST_CASE(T020,
+    *utf::description("check that the more urgent tasks overtake the less urgent tasks in the same run queue"))
+{
+  using cool::ng::async::runner;
+  using cool::ng::async::Urgency;
+  using cool::ng::async::LanePolicy;
+
+  static std::mutex mutex;
+  static std::string trace;
+  auto exec = [](void* data_)
+  {
+    std::unique_lock<std::mutex> l(mutex);
+    trace.push_back(static_cast<char>(reinterpret_cast<std::intptr_t>(data_)));
+  };
+  auto id = [](char id_) { return reinterpret_cast<void*>(static_cast<std::intptr_t>(id_)); };
+  auto wait_for = [](std::size_t size_)
+  {
+    return spin_wait(1000, [=] () { std::unique_lock<std::mutex> l(mutex); return trace.size() >= size_; });
+  };
+
+  // strict lanes, FIFO within the lane
+  {
+    trace.clear();
+    auto rq = run_queue::create(runner::options().lane_policy(LanePolicy::STRICT));
+    rq->stop();
+    rq->enqueue(exec, nullptr, id('n'));
+    rq->enqueue(exec, nullptr, id('l'), nullptr, Urgency::LOW);
+    rq->enqueue(exec, nullptr, id('C'), nullptr, Urgency::CRITICAL);
+    rq->enqueue(exec, nullptr, id('h'), nullptr, Urgency::HIGH);
+    rq->enqueue(exec, nullptr, id('N'));
+    rq->enqueue(exec, nullptr, id('c'), nullptr, Urgency::CRITICAL);
+    std::vector<void*> batch = { id('1'), id('2') };
+    rq->enqueue_batch(exec, nullptr, batch.data(), batch.size(), nullptr, Urgency::HIGH);
+    BOOST_CHECK_EQUAL(8, rq->depth());
+    rq->start();
+    BOOST_REQUIRE(wait_for(8));
+    std::unique_lock<std::mutex> l(mutex);
+    BOOST_CHECK_EQUAL("Cch12nNl", trace);
+    l.unlock();
+    run_queue::release(rq);
+  }
+
+  // weighted lanes serve each lane its share per round
+  {
+    trace.clear();
+    auto rq = run_queue::create(runner::options().lane_policy(LanePolicy::WEIGHTED));
+    rq->stop();
+    for (int i = 0; i < 20; ++i)
+    {
+      rq->enqueue(exec, nullptr, id('l'), nullptr, Urgency::LOW);
+      rq->enqueue(exec, nullptr, id('n'));
+      rq->enqueue(exec, nullptr, id('h'), nullptr, Urgency::HIGH);
+      rq->enqueue(exec, nullptr, id('c'), nullptr, Urgency::CRITICAL);
+    }
+    rq->start();
+    BOOST_REQUIRE(wait_for(80));
+    std::unique_lock<std::mutex> l(mutex);
+    BOOST_CHECK_EQUAL("cccccccchhhhnnlcccccccchhhhnnlcccchhhhnnlhhhhnnlhhhhnnl", trace.substr(0, 55));
+    BOOST_CHECK_EQUAL(20, std::count(trace.begin(), trace.end(), 'l'));
+    l.unlock();
+    run_queue::release(rq);
+  }
+
+  // the bounded run queue discards the least urgent tasks first
+  {
+    trace.clear();
+    auto rq = run_queue::create(runner::options()
+        .capacity(2, cool::ng::async::OverflowPolicy::DROP_OLDEST));
+    rq->stop();
+    rq->enqueue(exec, nullptr, id('l'), nullptr, Urgency::LOW);
+    rq->enqueue(exec, nullptr, id('n'));
+    rq->enqueue(exec, nullptr, id('c'), nullptr, Urgency::CRITICAL);
+    rq->start();
+    BOOST_REQUIRE(wait_for(2));
+    BOOST_CHECK(!spin_wait(50, [] () { std::unique_lock<std::mutex> l(mutex); return trace.size() > 2; }));
+    std::unique_lock<std::mutex> l(mutex);
+    BOOST_CHECK_EQUAL("cn", trace);
+    l.unlock();
+    run_queue::release(rq);
+  }
+}
+
+COOL_AUTO_TEST_CASE(T021,
+    *utf::description("check the earliest deadline first order and the reporting of the late tasks"))
+{
+  using cool::ng::async::runner;
+  using cool::ng::async::Urgency;
+
+  static std::mutex mutex;
+  static std::string trace;
+  static std::vector<runner::clock::time_point> missed;
+  auto exec = [](void* data_)
+  {
+    std::unique_lock<std::mutex> l(mutex);
+    trace.push_back(static_cast<char>(reinterpret_cast<std::intptr_t>(data_)));
+  };
+  auto id = [](char id_) { return reinterpret_cast<void*>(static_cast<std::intptr_t>(id_)); };
+  auto wait_for = [](std::size_t size_)
+  {
+    return spin_wait(1000, [=] () { std::unique_lock<std::mutex> l(mutex); return trace.size() + missed.size() >= size_; });
+  };
+  auto now = runner::clock::now();
+  auto never = runner::clock::time_point::max();
+
+  // earliest deadline first, the tasks without the deadline last, FIFO among
+  // the tasks with the same deadline; the urgency is ignored
+  {
+    trace.clear();
+    auto rq = run_queue::create(runner::options().deadline_order(true));
+    rq->stop();
+    rq->enqueue(exec, nullptr, id('x'));
+    rq->enqueue(exec, nullptr, id('3'), nullptr, Urgency::NORMAL, now + ms(3000));
+    rq->enqueue(exec, nullptr, id('1'), nullptr, Urgency::LOW, now + ms(1000));
+    rq->enqueue(exec, nullptr, id('y'), nullptr, Urgency::CRITICAL, never);
+    std::vector<void*> batch = { id('a'), id('b') };
+    rq->enqueue_batch(exec, nullptr, batch.data(), batch.size(), nullptr, Urgency::NORMAL, now + ms(2000));
+    rq->enqueue(exec, nullptr, id('0'), nullptr, Urgency::NORMAL, now - ms(1000));
+    BOOST_CHECK_EQUAL(7, rq->depth());
+    rq->start();
+    BOOST_REQUIRE(wait_for(7));
+    std::unique_lock<std::mutex> l(mutex);
+    // the late task is executed since there is no late handler
+    BOOST_CHECK_EQUAL("01ab3xy", trace);
+    l.unlock();
+    run_queue::release(rq);
+  }
+
+  // the late tasks are reported to the late handler instead of executed
+  {
+    trace.clear();
+    missed.clear();
+    auto rq = run_queue::create(runner::options()
+        .deadline_order(true)
+        .collect_metrics(true)
+        .on_late([] (const runner::clock::time_point& deadline_)
+          {
+            std::unique_lock<std::mutex> l(mutex);
+            missed.push_back(deadline_);
+          }));
+    rq->stop();
+    rq->enqueue(exec, nullptr, id('x'));
+    rq->enqueue(exec, nullptr, id('f'), nullptr, Urgency::NORMAL, now + ms(60000));
+    rq->enqueue(exec, nullptr, id('l'), nullptr, Urgency::NORMAL, now - ms(1));
+    rq->enqueue(exec, nullptr, id('L'), nullptr, Urgency::NORMAL, now - ms(2));
+    rq->start();
+    BOOST_REQUIRE(wait_for(4));
+    std::unique_lock<std::mutex> l(mutex);
+    BOOST_CHECK_EQUAL("fx", trace);
+    BOOST_REQUIRE_EQUAL(2, missed.size());
+    BOOST_CHECK(now - ms(2) == missed[0]);
+    BOOST_CHECK(now - ms(1) == missed[1]);
+    l.unlock();
+    cool::ng::async::runner::metrics m;
+    rq->snapshot(m);
+    BOOST_CHECK_EQUAL(2, m.dropped);
+    run_queue::release(rq);
+  }
+}
+
+COOL_AUTO_TEST_CASE(T022,
+    *utf::description("check that the overloaded run queue sheds the tasks that waited too long"))
+{
+  using cool::ng::async::runner;
+  using clock = queue_codel::clock;
+
+  // the CoDel control law on the synthetic time
+  {
+    queue_codel codel(ms(5), ms(100));
+    auto t = clock::now();
+    BOOST_CHECK(!codel.shed(t - ms(1), t, false));
+    BOOST_CHECK(!codel.shed(t - ms(10), t, false));
+    BOOST_CHECK(!codel.shed(t + ms(40), t + ms(50), false));
+    BOOST_CHECK(!codel.shed(t + ms(90), t + ms(100), true));     // nothing waits behind
+    BOOST_CHECK(!codel.shed(t + ms(90), t + ms(100), false));    // the interval restarts
+    BOOST_CHECK(!codel.dropping());
+    BOOST_CHECK(codel.shed(t + ms(190), t + ms(200), false));
+    BOOST_CHECK(codel.dropping());
+    BOOST_CHECK(!codel.shed(t + ms(240), t + ms(250), false));
+    BOOST_CHECK(codel.shed(t + ms(290), t + ms(300), false));
+    // the next after 100 / sqrt(2) ms
+    BOOST_CHECK(!codel.shed(t + ms(360), t + ms(370), false));
+    BOOST_CHECK(codel.shed(t + ms(361), t + ms(371), false));
+    BOOST_CHECK(!codel.shed(t + ms(372), t + ms(373), false));
+    BOOST_CHECK(!codel.dropping());
+  }
+
+  static std::atomic_int executed;
+  static std::atomic_int shed;
+  static std::atomic<int64_t> max_wait;
+  executed = 0;
+  shed = 0;
+  max_wait = 0;
+
+  const int NUM_TASKS = 100;
+  auto rq = run_queue::create(runner::options()
+      .collect_metrics(true)
+      .shed_load(ms(1), ms(5))
+      .on_overload([] (const runner::clock::duration& wait_)
+        {
+          ++shed;
+          max_wait = std::max<int64_t>(max_wait, std::chrono::duration_cast<us>(wait_).count());
+        }));
+  rq->stop();
+  for (int i = 0; i < NUM_TASKS; ++i)
+    rq->enqueue(
+        [](void*)
+        {
+          auto end = std::chrono::steady_clock::now() + us(500);
+          while (std::chrono::steady_clock::now() < end)
+            ;
+          ++executed;
+        }
+      , nullptr, nullptr);
+  rq->start();
+  BOOST_REQUIRE(spin_wait(5000, [] () { return executed + shed == NUM_TASKS; }));
+  // the shedding starts once the waiting time stays above 1 ms for 5 ms and
+  // then sheds more and more often, some 30 tasks while the rest executes
+  BOOST_CHECK_GE(shed, 10);
+  BOOST_CHECK_GE(max_wait, 5000);
+  BOOST_CHECK_GT(executed, 0);
+  cool::ng::async::runner::metrics m;
+  rq->snapshot(m);
+  BOOST_CHECK_EQUAL(shed, m.dropped);
+  run_queue::release(rq);
+}
+
+COOL_AUTO_TEST_CASE(T023,
+    *utf::description("check that the rate limited run queue paces its tasks without holding the worker thread"))
+{
+  using cool::ng::async::runner;
+  using clock = std::chrono::steady_clock;
+
+  BOOST_CHECK_THROW(runner::options().rate_limit(0, ms(100)), cool::ng::exception::illegal_argument);
+  BOOST_CHECK_THROW(runner::options().rate_limit(1, ms(0)), cool::ng::exception::illegal_argument);
+  BOOST_CHECK_EQUAL(10, runner::options().rate_limit(10, ms(100)).rate_burst());
+
+  // the bucket on the synthetic time
+  {
+    token_bucket bucket(10, ms(100), 2);
+    auto t = clock::now();
+    BOOST_CHECK(bucket.take(t));
+    BOOST_CHECK(bucket.take(t));
+    BOOST_CHECK(!bucket.take(t));
+    BOOST_CHECK(t + ms(10) == bucket.next());
+    BOOST_CHECK(!bucket.take(t + ms(9)));
+    BOOST_CHECK(bucket.take(t + ms(10)));
+    BOOST_CHECK(!bucket.take(t + ms(10)));
+    // the idle time refills up to the burst only
+    BOOST_CHECK(bucket.take(t + ms(1000)));
+    BOOST_CHECK(bucket.take(t + ms(1000)));
+    BOOST_CHECK(!bucket.take(t + ms(1000)));
+  }
+
+  static std::mutex mutex;
+  static std::vector<clock::time_point> started;
+  static std::atomic_int other;
+  started.clear();
+  other = 0;
+
+  const int NUM_TASKS = 12;
+#if defined(POSIX_POOL) && defined(LINUX_TARGET)
+  // both run queues pinned to the same CPU share the single worker thread
+  auto opts = runner::options().affinity({ 0 });
+#else
+  auto opts = runner::options();
+#endif
+  auto rq = run_queue::create(runner::options(opts).rate_limit(100, ms(1000), 2));
+  auto oq = run_queue::create(opts);
+  rq->stop();
+  for (int i = 0; i < NUM_TASKS; ++i)
+    rq->enqueue(
+        [](void*)
+        {
+          std::unique_lock<std::mutex> l(mutex);
+          started.push_back(clock::now());
+        }
+      , nullptr, nullptr);
+
+  auto start = clock::now();
+  rq->start();
+  std::this_thread::sleep_for(ms(5));
+  oq->enqueue([](void*) { ++other; }, nullptr, nullptr);
+  BOOST_CHECK(spin_wait(1000, [] () { return other == 1; }));
+  {
+    std::unique_lock<std::mutex> l(mutex);
+    BOOST_CHECK_LT(started.size(), NUM_TASKS);
+  }
+
+  BOOST_REQUIRE(spin_wait(2000, [&] () { std::unique_lock<std::mutex> l(mutex); return started.size() == NUM_TASKS; }));
+  std::unique_lock<std::mutex> l(mutex);
+  auto elapsed = [] (const clock::time_point& from_, const clock::time_point& to_)
+  {
+    return std::chrono::duration_cast<us>(to_ - from_).count();
+  };
+  // the burst of 2 and then a task every 10 ms
+  BOOST_CHECK_LT(elapsed(start, started[1]), 9000);
+  for (int i = 2; i < NUM_TASKS; ++i)
+    BOOST_CHECK_GE(elapsed(start, started[i]), 10000 * (i - 1));
+  l.unlock();
+  run_queue::release(rq);
+  run_queue::release(oq);
+}
+
+COOL_AUTO_TEST_CASE(T024,
+    *utf::description("check that object_pool counts the blocks of the incomplete batches"))
+{
+  struct object { char data[40]; };
+  using pool = cool::ng::async::impl::object_pool<object, 4>;
+
+  std::vector<void*> blocks;
+  for (int i = 0; i < 5; ++i)
+    blocks.push_back(pool::allocate());
+
+  // the exiting thread hands over an incomplete batch with a single block
+  std::thread([] { pool::deallocate(pool::allocate()); }).join();
+  blocks.push_back(pool::allocate());
+
+  // six blocks in the cache are fewer than two batches and all stay there
+  for (auto b : blocks)
+    pool::deallocate(b);
+
+  void* other = nullptr;
+  std::thread([&] { other = pool::allocate(); }).join();
+  BOOST_CHECK(std::find(blocks.begin(), blocks.end(), other) == blocks.end());
+  pool::deallocate(other);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
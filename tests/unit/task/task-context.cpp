@@ -26,6 +26,11 @@
 
 #include <tuple>
 #include <array>
+#include <atomic>
+#include <memory>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
 
 #include "cool/ng/impl/async/task.h"
 
@@ -34,6 +39,22 @@
 
 namespace impl = cool::ng::async::detail;
 
+// counts the heap allocations of the test program
+std::atomic<long> allocations(0);
+
+void* operator new(std::size_t size_)
+{
+  ++allocations;
+  if (void* p = std::malloc(size_ == 0 ? 1 : size_))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p_) noexcept
+{
+  std::free(p_);
+}
+
 struct counters
 {
   counters() : m_copy(0), m_move(0), m_copy_assign(0), m_move_assign(0)
@@ -324,6 +345,52 @@ class my_runner : public cool::ng::async::runner
 {
 };
 
+// receivers of the results and exceptions reported by the task contexts
+template <typename T>
+struct result_sink
+{
+  void report(impl::context*, const T& r_)
+  {
+    ++m_reported;
+    m_value = r_;
+  }
+
+  int m_reported = 0;
+  T   m_value = T();
+};
+
+template <>
+struct result_sink<void>
+{
+  void report(impl::context*)
+  {
+    ++m_reported;
+  }
+
+  int m_reported = 0;
+};
+
+struct exception_sink
+{
+  void report(const std::exception_ptr&)
+  {
+    ++m_reported;
+  }
+
+  int m_reported = 0;
+};
+
+template <typename T>
+typename impl::helpers::get_result_reporter<T>::type to(result_sink<T>& sink_)
+{
+  return impl::helpers::get_result_reporter<T>::type::template bind<result_sink<T>, &result_sink<T>::report>(&sink_);
+}
+
+impl::context::exception_reporter to(exception_sink& sink_)
+{
+  return impl::context::exception_reporter::bind<exception_sink, &exception_sink::report>(&sink_);
+}
+
 COOL_AUTO_TEST_CASE(T003,
   *utf::description("simple task context"))
 {
@@ -345,7 +412,7 @@ COOL_AUTO_TEST_CASE(T003,
       , first_type         // first, second and third parameters
       , second_type
       , third_type>;
-    return_type result = 0;
+    result_sink<return_type> result;
     std::function<return_type(const std::shared_ptr<my_runner>&, const first_type&, const second_type&, const third_type&)> lambda =
       [&called, &sum_copy, &sum_move](const std::shared_ptr<my_runner>&, const first_type& a1, const second_type& a2, const third_type& a3)
       {
@@ -354,16 +421,12 @@ COOL_AUTO_TEST_CASE(T003,
         sum_move = a1.m_move + a2.m_move + a3.m_move;
         return 3;
       };
-    std::function<void(cool::ng::async::detail::context*, const return_type&)> reporter = [&result] (cool::ng::async::detail::context* ctx_, const return_type r_)
-    {
-      result = r_;
-    };
 
     std::unique_ptr<context> ctx(context::create(
         nullptr
       , std::shared_ptr<cool::ng::async::detail::task>()
       , lambda
-      , reporter
+      , to(result)
       , a, b, c)
     );
 
@@ -372,11 +435,11 @@ COOL_AUTO_TEST_CASE(T003,
     BOOST_CHECK(called);
     BOOST_CHECK_EQUAL(3, sum_copy);
     BOOST_CHECK_EQUAL(0, sum_move);
-    BOOST_CHECK_EQUAL(3, result);
+    BOOST_CHECK_EQUAL(1, result.m_reported);
+    BOOST_CHECK_EQUAL(3, result.m_value);
   }
   {
     bool called = false;
-    bool reported = false;
     int sum_copy = 0, sum_move = 0;
 
     using return_type = void;
@@ -396,23 +459,19 @@ COOL_AUTO_TEST_CASE(T003,
         sum_move = a1.m_move + a2.m_move + a3.m_move;
       };
 
-    std::function<void(cool::ng::async::detail::context*)> reporter = [&reported] (cool::ng::async::detail::context* ctx_)
-    {
-      reported = true;
-    };
-
+    result_sink<return_type> result;
 
     std::unique_ptr<context> ctx(context::create(
         nullptr
       , std::shared_ptr<cool::ng::async::detail::task>()
       , lambda
-      , reporter
+      , to(result)
       , a, b, c)
     );
 
     ctx->entry_point(r, nullptr);
     BOOST_CHECK(called);
-    BOOST_CHECK(reported);
+    BOOST_CHECK_EQUAL(1, result.m_reported);
     BOOST_CHECK_EQUAL(3, sum_copy);
     BOOST_CHECK_EQUAL(0, sum_move);
   }
@@ -420,7 +479,7 @@ COOL_AUTO_TEST_CASE(T003,
     bool called = false;
 
     using return_type = int;
-    return_type result = 0;
+    result_sink<return_type> result;
     using context = cool::ng::async::detail::context_impl<
         cool::ng::async::detail::tag::simple
       , my_runner
@@ -432,25 +491,446 @@ COOL_AUTO_TEST_CASE(T003,
         called = true;
         return 42;
       };
-    std::function<void(cool::ng::async::detail::context*, const return_type&)> reporter = [&result] (cool::ng::async::detail::context* ctx_, const return_type r_)
-    {
-      result = r_;
-    };
 
     std::unique_ptr<context> ctx(context::create(
         nullptr
       , std::shared_ptr<cool::ng::async::detail::task>()
       , lambda
-      , reporter)
+      , to(result))
     );
 
     ctx->entry_point(r, nullptr);
     BOOST_CHECK(called);
-    BOOST_CHECK_EQUAL(42, result);
+    BOOST_CHECK_EQUAL(42, result.m_value);
+
+  }
+
+
+}
+
+COOL_AUTO_TEST_CASE(T004,
+  *utf::description("small values are stored within the any"))
+{
+  auto sp = std::make_shared<int>(42);
+  int value = 0;
+  long use_count = 0;
+  bool mismatch = false;
+
+  auto before = allocations.load();
+  {
+    impl::any a = 42;
+    impl::any b{std::shared_ptr<int>(sp)};
+    impl::any c(std::move(a));
+    impl::any d;
+    d = c;
+    b.swap(d);
+    value = impl::any_cast<int>(b) + *impl::any_cast<std::shared_ptr<int>>(d);
+    use_count = sp.use_count();
+    mismatch = impl::any_cast<long>(&b) == nullptr && impl::any_cast<int>(&d) == nullptr;
+  }
+  BOOST_CHECK_EQUAL(before, allocations.load());
+  BOOST_CHECK_EQUAL(84, value);
+  BOOST_CHECK_EQUAL(2, use_count);
+  BOOST_CHECK(mismatch);
+  BOOST_CHECK_EQUAL(1, sp.use_count());
+
+  // the large values go to the heap and keep working as before
+  {
+    using value_type = std::tuple<first_type, second_type, third_type>;
+    before = allocations.load();
+    impl::any a(value_type{});
+    BOOST_CHECK_EQUAL(before + 1, allocations.load());
+    impl::any b(std::move(a));
+    BOOST_CHECK_EQUAL(before + 1, allocations.load());
+    BOOST_CHECK(a.empty());
+    BOOST_CHECK(!b.empty());
+    BOOST_CHECK_EQUAL(0, std::get<0>(impl::any_cast<const value_type&>(b)).m_copy);
+    BOOST_CHECK_THROW(impl::any_cast<int>(b), cool::ng::exception::bad_conversion);
+  }
+
+  {
+    impl::any a;
+    BOOST_CHECK(a.empty());
+    BOOST_CHECK(impl::any_cast<int>(&a) == nullptr);
+    a = std::string("test");
+    BOOST_CHECK_EQUAL("test", impl::any_cast<const std::string&>(a));
+    a.clear();
+    BOOST_CHECK(a.empty());
+  }
+}
+
+// value that would not fit the inline storage of any
+struct large_value
+{
+  long m_value[8];
+};
+
+COOL_AUTO_TEST_CASE(T005,
+  *utf::description("statically typed sequence passes the results without boxing"))
+{
+  namespace detail = cool::ng::async::detail;
+  using first_task  = detail::x_taskinfo<detail::tag::simple, my_runner, large_value, int>;
+  using second_task = detail::x_taskinfo<detail::tag::simple, my_runner, int, large_value>;
+  using third_task  = detail::x_taskinfo<detail::tag::simple, my_runner, int, int>;
+  using void_task   = detail::x_taskinfo<detail::tag::simple, my_runner, void, int>;
+  using sequence    = detail::x_taskinfo<detail::tag::sequential, detail::default_runner_type, int, int>;
+  using void_sequence = detail::x_taskinfo<detail::tag::sequential, detail::default_runner_type, void, int>;
+
+  auto r = std::make_shared<my_runner>();
+  auto t1 = std::make_shared<first_task>(r
+    , [] (const std::shared_ptr<my_runner>&, const int& v_)
+      {
+        large_value ret;
+        for (auto& v : ret.m_value)
+          v = v_;
+        return ret;
+      });
+  auto t2 = std::make_shared<second_task>(r
+    , [] (const std::shared_ptr<my_runner>&, const large_value& v_)
+      {
+        int ret = 0;
+        for (auto v : v_.m_value)
+          ret += v;
+        return ret;
+      });
+  auto t3 = std::make_shared<third_task>(r
+    , [] (const std::shared_ptr<my_runner>&, const int& v_)
+      {
+        return v_ + 1;
+      });
+
+  // runs all contexts on the stack, as the runner would
+  auto drive = [&r] (detail::context_stack* stack_)
+  {
+    while (!stack_->empty())
+      stack_->top()->entry_point(r, stack_->top());
+  };
+
+  {
+    auto seq = std::make_shared<sequence>(t1, t2, t3);
+    BOOST_CHECK(!seq->get_runner().expired());
+
+    result_sink<int> result;
+    std::unique_ptr<detail::context_stack> stack(new detail::default_task_stack());
+
+    // the contexts live in the stack's arena and the values passed between
+    // the tasks are not boxed, hence no allocations at all
+    auto before = allocations.load();
+    seq->create_context(stack.get(), seq, nullptr, to(result), 5);
+    drive(stack.get());
+    auto count = allocations.load() - before;
+
+    BOOST_CHECK_EQUAL(0, count);
+    BOOST_CHECK_EQUAL(41, result.m_value);
+    BOOST_CHECK(stack->empty());
+
+    // the nested sequence passes its result to the next task as well
+    auto outer = std::make_shared<sequence>(seq, t3);
+    outer->create_context(stack.get(), outer, nullptr, to(result), 1);
+    drive(stack.get());
+    BOOST_CHECK_EQUAL(10, result.m_value);
+    BOOST_CHECK(stack->empty());
+
+    // entry through the type erased input
+    outer->create_context(stack.get(), outer, detail::any(std::tuple<int>(2)));
+    drive(stack.get());
+    BOOST_CHECK(stack->empty());
+  }
+
+  // the sequence ends with the first failing task and reports the exception
+  {
+    int called = 0;
+    auto failing = std::make_shared<third_task>(r
+      , [] (const std::shared_ptr<my_runner>&, const int&) -> int
+        {
+          throw std::runtime_error("failed");
+        });
+    auto last = std::make_shared<void_task>(r
+      , [&called] (const std::shared_ptr<my_runner>&, const int&) { ++called; });
+    auto seq = std::make_shared<void_sequence>(t3, failing, last);
+
+    result_sink<void> result;
+    exception_sink failure;
+    std::unique_ptr<detail::context_stack> stack(new detail::default_task_stack());
+    auto ctx = seq->create_context(stack.get(), seq, nullptr, to(result), 1);
+    ctx->set_exc_reporter(to(failure));
+    drive(stack.get());
+    BOOST_CHECK_EQUAL(1, failure.m_reported);
+    BOOST_CHECK_EQUAL(0, result.m_reported);
+    BOOST_CHECK_EQUAL(0, called);
+    BOOST_CHECK(stack->empty());
+
+    seq = std::make_shared<void_sequence>(t3, last);
+    seq->create_context(stack.get(), seq, nullptr, to(result), 1);
+    drive(stack.get());
+    BOOST_CHECK_EQUAL(1, result.m_reported);
+    BOOST_CHECK_EQUAL(1, called);
+  }
+}
+
+COOL_AUTO_TEST_CASE(T006,
+  *utf::description("result and exception reporters do not allocate"))
+{
+  namespace detail = cool::ng::async::detail;
+  using task_type = detail::x_taskinfo<detail::tag::simple, my_runner, int, int>;
+  using sequence  = detail::x_taskinfo<detail::tag::sequential, detail::default_runner_type, int, int>;
+
+  BOOST_CHECK_EQUAL(2 * sizeof(void*), sizeof(detail::context::result_reporter));
+  BOOST_CHECK_EQUAL(2 * sizeof(void*), sizeof(detail::context::exception_reporter));
+  BOOST_CHECK_EQUAL(2 * sizeof(void*), sizeof(task_type::result_reporter_type));
+  BOOST_CHECK(!detail::context::result_reporter());
+
+  auto r = std::make_shared<my_runner>();
+  auto t = std::make_shared<task_type>(r, [] (const std::shared_ptr<my_runner>&, const int& v_) { return v_ * 2; });
+  auto seq = std::make_shared<sequence>(t, t, t);
+  std::unique_ptr<detail::context_stack> stack(new detail::default_task_stack());
+  stack->push(nullptr);   // let the stack allocate its storage up front
+  stack->pop();
+
+  result_sink<int> result;
+  exception_sink failure;
+
+  // the context is allocated from the stack's arena and the reporters are
+  // stored within the context
+  auto before = allocations.load();
+  auto ctx = t->create_context(stack.get(), t, nullptr, to(result), 3);
+  ctx->set_exc_reporter(to(failure));
+  ctx->entry_point(r, ctx);
+  BOOST_CHECK_EQUAL(0, allocations.load() - before);
+  BOOST_CHECK_EQUAL(6, result.m_value);
+  BOOST_CHECK(stack->empty());
+
+  // and the same for the sequence and its steps
+  before = allocations.load();
+  ctx = seq->create_context(stack.get(), seq, nullptr, to(result), 1);
+  ctx->set_exc_reporter(to(failure));
+  while (!stack->empty())
+    stack->top()->entry_point(r, stack->top());
+  BOOST_CHECK_EQUAL(0, allocations.load() - before);
+  BOOST_CHECK_EQUAL(8, result.m_value);
+  BOOST_CHECK_EQUAL(2, result.m_reported);
+  BOOST_CHECK_EQUAL(0, failure.m_reported);
+}
+
+// context that only records its destruction
+class probe : public impl::context
+{
+ public:
+  probe(int& destroyed_) : m_destroyed(destroyed_)
+  { /* noop */ }
+  ~probe()
+  {
+    ++m_destroyed;
+  }
+
+  std::weak_ptr<cool::ng::async::runner> get_runner() const override
+  {
+    return std::weak_ptr<cool::ng::async::runner>();
+  }
+  void entry_point(const std::shared_ptr<cool::ng::async::runner>&, impl::context*) override
+  { /* noop */ }
+  const char* name() const override               { return "probe"; }
+  bool will_execute() const override              { return false; }
+  void set_input(const impl::any&) override       { /* noop */ }
+  void set_res_reporter(const result_reporter&) override    { /* noop */ }
+  void set_exc_reporter(const exception_reporter&) override { /* noop */ }
+  exception_reporter get_exc_reporter() const override { return exception_reporter(); }
+
+ private:
+  int& m_destroyed;
+};
+
+// probe too large for the arena of the default task stack
+class large_probe : public probe
+{
+ public:
+  using probe::probe;
+
+ private:
+  unsigned char m_payload[2048];
+};
+
+COOL_AUTO_TEST_CASE(T007,
+  *utf::description("contexts are allocated from the arena of the default task stack"))
+{
+  int destroyed = 0;
+
+  // the stacks are recycled by the library's pool
+  delete new impl::default_task_stack();
+  auto before = allocations.load();
+  std::unique_ptr<impl::context_stack> stack(new impl::default_task_stack());
+  BOOST_CHECK_EQUAL(before, allocations.load());
+
+  // contexts allocated and released in the stack order reuse the arena
+  impl::context* first = new (stack.get()) probe(destroyed);
+  stack->push(first);
+  impl::context* second = new (stack.get()) probe(destroyed);
+  delete second;
+  second = new (stack.get()) probe(destroyed);
+  stack->push(second);
+  BOOST_CHECK_EQUAL(before, allocations.load());
+  BOOST_CHECK_EQUAL(1, destroyed);
+
+  // contexts that do not fit the arena go to the heap
+  impl::context* large = new (stack.get()) large_probe(destroyed);
+  BOOST_CHECK_EQUAL(before + 1, allocations.load());
+  delete large;
+  BOOST_CHECK_EQUAL(2, destroyed);
+
+  // once the arena is full the stack allocates a single chunk for the
+  // contexts that follow
+  {
+    int chunked = 0;
+    std::unique_ptr<impl::context_stack> aux(new impl::default_task_stack());
+    std::vector<impl::context*> contexts;
+    contexts.reserve(20);
+    before = allocations.load();
+    for (int i = 0; i < 20; ++i)
+      contexts.push_back(new (aux.get()) probe(chunked));
+    BOOST_CHECK_EQUAL(before + 1, allocations.load());
+    for (auto it = contexts.rbegin(); it != contexts.rend(); ++it)
+      delete *it;
+    BOOST_CHECK_EQUAL(20, chunked);
+    before = allocations.load();
+  }
+
+  // the stack deeper than its inline part keeps the order of its contexts
+  std::vector<impl::context*> pushed;
+  for (int i = 0; i < 40; ++i)
+  {
+    pushed.push_back(new (stack.get()) probe(destroyed));
+    stack->push(pushed.back());
+  }
+  for (int i = 39; i >= 20; --i)
+  {
+    BOOST_CHECK(stack->top() == pushed[i]);
+    delete stack->pop();
+  }
+  BOOST_CHECK_EQUAL(22, destroyed);
+  BOOST_CHECK(stack->top() == pushed[19]);
+
+  // contexts released out of order, and the ones left on the stack; the
+  // memory of the context released before its successor is not reused
+  // until the stack is destroyed
+  impl::context* a = new (stack.get()) probe(destroyed);
+  impl::context* b = new (stack.get()) probe(destroyed);
+  void* b_memory = b;
+  delete a;
+  delete b;
+  BOOST_CHECK_EQUAL(24, destroyed);
+  impl::context* c = new (stack.get()) probe(destroyed);
+  BOOST_CHECK(static_cast<void*>(c) == b_memory);
+  delete c;
+  BOOST_CHECK_EQUAL(25, destroyed);
+  stack.reset();
+  BOOST_CHECK_EQUAL(25 + 22, destroyed);
+
+  // contexts without the stack are allocated from the heap
+  before = allocations.load();
+  std::unique_ptr<impl::context> orphan(new probe(destroyed));
+  BOOST_CHECK_EQUAL(before + 1, allocations.load());
+}
+
+COOL_AUTO_TEST_CASE(T008,
+  *utf::description("sequence of simple tasks of the same runner type is fused"))
+{
+  namespace detail = cool::ng::async::detail;
+  using first_task  = detail::x_taskinfo<detail::tag::simple, my_runner, large_value, int>;
+  using second_task = detail::x_taskinfo<detail::tag::simple, my_runner, int, large_value>;
+  using void_task   = detail::x_taskinfo<detail::tag::simple, my_runner, void, int>;
+  using fused       = detail::x_sequence<first_task, second_task>;
+  using fused_void  = detail::x_sequence<first_task, second_task, void_task>;
+  using nested      = detail::x_sequence<fused::type, void_task>;
+
+  BOOST_CHECK((std::is_same<detail::x_fused_taskinfo<detail::x_link<int>, first_task, second_task>, fused::type>::value));
+  BOOST_CHECK((std::is_same<detail::x_taskinfo<detail::tag::sequential, detail::default_runner_type, void, int>, nested::type>::value));
+
+  int called = 0;
+  auto r = std::make_shared<my_runner>();
+  auto t1 = std::make_shared<first_task>(r
+    , [&called] (const std::shared_ptr<my_runner>&, const int& v_)
+      {
+        ++called;
+        large_value ret;
+        for (auto& v : ret.m_value)
+          v = v_;
+        return ret;
+      });
+  auto t2 = std::make_shared<second_task>(r
+    , [&called] (const std::shared_ptr<my_runner>&, const large_value& v_)
+      {
+        ++called;
+        int ret = 0;
+        for (auto v : v_.m_value)
+          ret += v;
+        return ret;
+      });
+  auto t3 = std::make_shared<void_task>(r
+    , [&called] (const std::shared_ptr<my_runner>&, const int& v_)
+      {
+        ++called;
+        if (v_ < 0)
+          throw std::runtime_error("negative");
+      });
+  std::unique_ptr<detail::context_stack> stack(new detail::default_task_stack());
 
+  // a single context runs all tasks back-to-back without allocations
+  {
+    auto seq = fused::create(t1, t2);
+    result_sink<int> result;
+    auto before = allocations.load();
+    auto ctx = seq->create_context(stack.get(), seq, nullptr, to(result), 5);
+    BOOST_CHECK(stack->top() == ctx);
+    ctx->entry_point(r, ctx);
+    BOOST_CHECK_EQUAL(0, allocations.load() - before);
+    BOOST_CHECK(stack->empty());
+    BOOST_CHECK_EQUAL(2, called);
+    BOOST_CHECK_EQUAL(1, result.m_reported);
+    BOOST_CHECK_EQUAL(40, result.m_value);
+
+    // fused sequence within the sequence
+    auto outer = nested::create(seq, t3);
+    result_sink<void> done;
+    outer->create_context(stack.get(), outer, nullptr, to(done), 1);
+    while (!stack->empty())
+      stack->top()->entry_point(r, stack->top());
+    BOOST_CHECK_EQUAL(5, called);
+    BOOST_CHECK_EQUAL(1, done.m_reported);
   }
 
+  // the exception ends the sequence
+  {
+    called = 0;
+    auto seq = fused_void::create(t1, t2, t3);
+    result_sink<void> result;
+    exception_sink failure;
+    auto ctx = seq->create_context(stack.get(), seq, nullptr, to(result), -1);
+    ctx->set_exc_reporter(to(failure));
+    ctx->entry_point(r, ctx);
+    BOOST_CHECK(stack->empty());
+    BOOST_CHECK_EQUAL(3, called);
+    BOOST_CHECK_EQUAL(0, result.m_reported);
+    BOOST_CHECK_EQUAL(1, failure.m_reported);
+  }
 
+  // the context moves to the runner of the next task
+  {
+    called = 0;
+    auto other = std::make_shared<my_runner>();
+    auto t = std::make_shared<second_task>(other, t2->function());
+    auto seq = fused::create(t1, t);
+    result_sink<int> result;
+    auto ctx = seq->create_context(stack.get(), seq, nullptr, to(result), 1);
+    BOOST_CHECK(!ctx->get_runner().owner_before(r) && !r.owner_before(ctx->get_runner()));
+    ctx->entry_point(r, ctx);
+    BOOST_CHECK_EQUAL(1, called);
+    BOOST_REQUIRE(!stack->empty());
+    BOOST_CHECK(!ctx->get_runner().owner_before(other) && !other.owner_before(ctx->get_runner()));
+    ctx->entry_point(other, ctx);
+    BOOST_CHECK(stack->empty());
+    BOOST_CHECK_EQUAL(2, called);
+    BOOST_CHECK_EQUAL(8, result.m_value);
+  }
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,797 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <array>
+#include <algorithm>
+#include <type_traits>
+
+#include "cool/ng/async/runner.h"
+#include "cool/ng/async/runner_pool.h"
+#include "cool/ng/impl/async/task.h"
+#include "cool/ng/async/task.h"
+
+#define BOOST_TEST_MODULE TaskExecutor
+#include "unit_test_common.h"
+
+#include "run_queue.h"
+
+namespace async = cool::ng::async;
+namespace impl = cool::ng::async::detail;
+
+namespace {
+
+std::mutex       trace_mutex;
+std::vector<int> trace;
+const int        MARKER = -1;
+const int        FAILED = -2;      // queue_full reported to the step
+std::atomic_int  steps;           // number of existing step contexts
+
+void record(int id_)
+{
+  std::unique_lock<std::mutex> l(trace_mutex);
+  trace.push_back(id_);
+}
+
+std::size_t trace_size()
+{
+  std::unique_lock<std::mutex> l(trace_mutex);
+  return trace.size();
+}
+
+bool spin_wait(unsigned int msec, const std::function<bool()>& lambda)
+{
+  auto start = std::chrono::steady_clock::now();
+  while (!lambda())
+  {
+    if (std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(msec))
+      return false;
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+// context that records its id and removes itself from the stack
+class step : public impl::context
+{
+ public:
+  step(impl::context_stack* stack_, const std::shared_ptr<async::runner>& r_, int id_)
+    : m_stack(stack_), m_runner(r_), m_id(id_)
+  {
+    ++steps;
+  }
+  ~step()
+  {
+    --steps;
+  }
+
+  std::weak_ptr<async::runner> get_runner() const override { return m_runner; }
+  void entry_point(const std::shared_ptr<async::runner>&, context*) override
+  {
+    m_stack->pop();
+    record(m_id);
+    delete this;
+  }
+  const char* name() const override { return "step"; }
+  bool will_execute() const override { return true; }
+  void set_input(const impl::any&) override { /* noop */ }
+  void set_res_reporter(const result_reporter&) override { /* noop */ }
+  void set_exc_reporter(const exception_reporter&) override { /* noop */ }
+  exception_reporter get_exc_reporter() const override { return exception_reporter(); }
+
+ private:
+  impl::context_stack*         m_stack;
+  std::weak_ptr<async::runner> m_runner;
+  int                          m_id;
+};
+
+// creates the context stack with steps 0 .. n-1, step 0 on the top
+impl::context_stack* make_stack(const std::vector<std::shared_ptr<async::runner>>& runners_)
+{
+  auto stack = new impl::default_task_stack();
+  for (auto i = runners_.size(); i > 0; --i)
+    stack->push(new step(stack, runners_[i - 1], static_cast<int>(i - 1)));
+  return stack;
+}
+
+// task that creates a single step context per run; the input is the step id
+class step_task : public impl::base::taskinfo<int, void>
+{
+ public:
+  step_task(const std::shared_ptr<async::runner>& r_) : m_runner(r_)
+  { /* noop */ }
+
+  std::weak_ptr<async::runner> get_runner() const override { return m_runner; }
+  impl::context* create_context(
+        impl::context_stack* stack_
+      , const std::shared_ptr<impl::task>&
+      , const impl::any& input_) const override
+  {
+    auto ctx = new step(stack_, m_runner.lock(), impl::any_cast<int>(input_));
+    stack_->push(ctx);
+    return ctx;
+  }
+
+ private:
+  std::weak_ptr<async::runner> m_runner;
+};
+
+void enqueue_marker(
+    const std::shared_ptr<async::runner>& r_
+  , async::Urgency urgency_ = async::Urgency::NORMAL
+  , const async::runner::clock::time_point& deadline_ = async::runner::clock::time_point::max())
+{
+  r_->impl()->enqueue([] (void*) { record(MARKER); }, nullptr, nullptr, nullptr, urgency_, deadline_);
+}
+
+// step with the exception reporter that records FAILED for queue_full
+class guarded_step : public step
+{
+ public:
+  guarded_step(impl::context_stack* stack_, const std::shared_ptr<async::runner>& r_, int id_)
+    : step(stack_, r_, id_)
+  { /* noop */ }
+
+  exception_reporter get_exc_reporter() const override
+  {
+    return exception_reporter(&report, nullptr);
+  }
+
+ private:
+  static void report(void*, const std::exception_ptr& e_)
+  {
+    try { std::rethrow_exception(e_); }
+    catch (const cool::ng::exception::queue_full&) { record(FAILED); }
+    catch (...) { /* noop */ }
+  }
+};
+
+// step that enqueues the marker of the given urgency and deadline to its
+// runner while it executes
+class urgent_step : public step
+{
+ public:
+  urgent_step(impl::context_stack* stack_, const std::shared_ptr<async::runner>& r_, int id_
+      , async::Urgency urgency_, const async::runner::clock::time_point& deadline_)
+    : step(stack_, r_, id_), m_urgency(urgency_), m_deadline(deadline_)
+  { /* noop */ }
+
+  void entry_point(const std::shared_ptr<async::runner>& r_, context* ctx_) override
+  {
+    enqueue_marker(r_, m_urgency, m_deadline);
+    step::entry_point(r_, ctx_);
+  }
+
+ private:
+  async::Urgency                       m_urgency;
+  async::runner::clock::time_point     m_deadline;
+};
+
+} // anonymous namespace
+
+// the public delayed run calls are thin wrappers around base::taskinfo::run_at;
+// instantiate them here as the task API test target is not built
+template void async::task<int, void>::run_at<int>(const async::runner::clock::time_point&, const int&) const;
+template void async::task<int&&, void>::run_at<int&&>(const async::runner::clock::time_point&, int&&) const;
+template void async::task<void, void>::run_at<void>(const async::runner::clock::time_point&) const;
+template void async::task<int, void>::run_after<long, std::milli, int>(const std::chrono::duration<long, std::milli>&, const int&) const;
+template void async::task<int&&, void>::run_after<long, std::milli, int&&>(const std::chrono::duration<long, std::milli>&, int&&) const;
+template void async::task<void, void>::run_after<long, std::milli, void>(const std::chrono::duration<long, std::milli>&) const;
+
+BOOST_AUTO_TEST_SUITE(task_executor)
+
+COOL_AUTO_TEST_CASE(T001,
+  *utf::description("contexts on the same runner execute back-to-back"))
+{
+  const int NUM_STEPS = 5;
+  trace.clear();
+
+  auto r = std::make_shared<async::runner>();
+  r->impl()->stop();
+  impl::kickstart(make_stack(std::vector<std::shared_ptr<async::runner>>(NUM_STEPS, r)));
+  enqueue_marker(r);
+  r->impl()->start();
+
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == NUM_STEPS + 1; }));
+  for (int i = 0; i < NUM_STEPS; ++i)
+    BOOST_CHECK_EQUAL(i, trace[i]);
+  BOOST_CHECK_EQUAL(MARKER, trace[NUM_STEPS]);
+}
+
+COOL_AUTO_TEST_CASE(T002,
+  *utf::description("long sequence on the same runner yields to other tasks after the continuation budget"))
+{
+  const int NUM_STEPS = 100;
+  trace.clear();
+
+  auto r = std::make_shared<async::runner>();
+  r->impl()->stop();
+  impl::kickstart(make_stack(std::vector<std::shared_ptr<async::runner>>(NUM_STEPS, r)));
+  enqueue_marker(r);
+  r->impl()->start();
+
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == NUM_STEPS + 1; }));
+  int pos = 0;
+  for (int i = 0; i <= NUM_STEPS; ++i)
+    if (trace[i] == MARKER)
+      pos = i;
+  BOOST_CHECK_GT(pos, 1);
+  BOOST_CHECK_LT(pos, NUM_STEPS);
+  for (int i = 0, id = 0; i <= NUM_STEPS; ++i)
+    if (trace[i] != MARKER)
+      BOOST_CHECK_EQUAL(id++, trace[i]);
+}
+
+COOL_AUTO_TEST_CASE(T003,
+  *utf::description("context on a different runner is enqueued to its runner"))
+{
+  trace.clear();
+
+  auto r1 = std::make_shared<async::runner>();
+  auto r2 = std::make_shared<async::runner>();
+  r2->impl()->stop();
+  impl::kickstart(make_stack({ r1, r1, r2, r1 }));
+
+  BOOST_CHECK(spin_wait(1000, [] () { return trace_size() == 2; }));
+  BOOST_CHECK(!spin_wait(50, [] () { return trace_size() > 2; }));
+  r2->impl()->start();
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == 4; }));
+  for (int i = 0; i < 4; ++i)
+    BOOST_CHECK_EQUAL(i, trace[i]);
+}
+
+COOL_AUTO_TEST_CASE(T004,
+  *utf::description("context stack is dropped if the runner of the next context is gone"))
+{
+  trace.clear();
+
+  auto r1 = std::make_shared<async::runner>();
+  auto r2 = std::make_shared<async::runner>();
+  r1->impl()->stop();
+  impl::kickstart(make_stack({ r1, r2, r1 }));
+  r2.reset();
+  r1->impl()->start();
+
+  BOOST_CHECK(spin_wait(1000, [] () { return trace_size() == 1; }));
+  BOOST_CHECK(!spin_wait(50, [] () { return trace_size() > 1; }));
+  BOOST_CHECK_EQUAL(0, trace[0]);
+}
+
+COOL_AUTO_TEST_CASE(T005,
+  *utf::description("run_many submits all runs to the runner together and in order"))
+{
+  const int NUM_RUNS = 200;
+  trace.clear();
+
+  auto r = std::make_shared<async::runner>();
+  auto t = std::make_shared<step_task>(r);
+  std::vector<short> inputs;
+  for (int i = 0; i < NUM_RUNS; ++i)
+    inputs.push_back(static_cast<short>(i));
+
+  r->impl()->stop();
+  t->run_many(t, inputs.begin(), inputs.end());
+  enqueue_marker(r);
+  r->impl()->start();
+
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == NUM_RUNS + 1; }));
+  for (int i = 0; i < NUM_RUNS; ++i)
+    BOOST_CHECK_EQUAL(i, trace[i]);
+  BOOST_CHECK_EQUAL(MARKER, trace[NUM_RUNS]);
+
+  // runs of the task whose runner is gone are not submitted
+  trace.clear();
+  r.reset();
+  BOOST_CHECK_THROW(t->run_many(t, inputs.begin(), inputs.end()), cool::ng::exception::runner_not_available);
+  BOOST_CHECK(!spin_wait(50, [] () { return trace_size() > 0; }));
+}
+
+COOL_AUTO_TEST_CASE(T006,
+  *utf::description("batch kickstart splits the stacks by the runner of their first context"))
+{
+  trace.clear();
+
+  auto r1 = std::make_shared<async::runner>();
+  auto r2 = std::make_shared<async::runner>();
+  std::vector<impl::context_stack*> stacks = {
+      make_stack({ r1 }), make_stack({ r1 }), make_stack({ r2 }), make_stack({ r1 })
+  };
+  r2->impl()->stop();
+  impl::kickstart(stacks.data(), stacks.size());
+
+  BOOST_CHECK(spin_wait(1000, [] () { return trace_size() == 3; }));
+  BOOST_CHECK(!spin_wait(50, [] () { return trace_size() > 3; }));
+  r2->impl()->start();
+  BOOST_CHECK(spin_wait(1000, [] () { return trace_size() == 4; }));
+}
+
+COOL_AUTO_TEST_CASE(T007,
+  *utf::description("context stacks rejected or dropped by the bounded runner are deleted"))
+{
+  trace.clear();
+  steps = 0;
+
+  auto r1 = std::make_shared<async::runner>(async::runner::options()
+      .capacity(1, async::OverflowPolicy::REJECT));
+  r1->impl()->stop();
+  impl::kickstart(make_stack({ r1, r1 }));
+  BOOST_CHECK_THROW(impl::kickstart(make_stack({ r1 })), cool::ng::exception::queue_full);
+  std::vector<impl::context_stack*> stacks = { make_stack({ r1 }), make_stack({ r1 }) };
+  BOOST_CHECK_THROW(impl::kickstart(stacks.data(), stacks.size()), cool::ng::exception::queue_full);
+  BOOST_CHECK_EQUAL(2, steps);
+  r1->impl()->start();
+  BOOST_CHECK(spin_wait(1000, [] () { return trace_size() == 2; }));
+
+  trace.clear();
+  auto r2 = std::make_shared<async::runner>(async::runner::options()
+      .capacity(1, async::OverflowPolicy::DROP_OLDEST));
+  r2->impl()->stop();
+  impl::kickstart(make_stack({ r2, r2 }));
+  impl::kickstart(make_stack({ r2 }));
+  BOOST_CHECK_EQUAL(1, steps);
+  r2->impl()->start();
+  BOOST_CHECK(spin_wait(1000, [] () { return trace_size() == 1; }));
+  BOOST_CHECK(spin_wait(1000, [] () { return steps == 0; }));
+}
+
+
+COOL_AUTO_TEST_CASE(T008,
+  *utf::description("runner pool maps each key to the same runner and executes its tasks in order"))
+{
+  using cool::ng::ip::operator "" _ipv4;
+  using cool::ng::ip::operator "" _ipv6;
+
+  BOOST_CHECK_THROW(async::runner_pool(0), cool::ng::exception::illegal_argument);
+
+  async::runner_pool pool(4, async::runner::options().policy(async::RunPolicy::CONCURRENT));
+  BOOST_REQUIRE_EQUAL(4, pool.size());
+  BOOST_CHECK_THROW(pool.at(4), cool::ng::exception::illegal_argument);
+
+  // the same key always selects the same runner and the keys spread
+  std::vector<int> hits(pool.size(), 0);
+  for (int key = 0; key < 400; ++key)
+  {
+    BOOST_CHECK(pool.get(key) == pool.get(key));
+    ++hits[pool.index_of(key)];
+  }
+  for (auto h : hits)
+    BOOST_CHECK(h > 50);
+
+  // the IPv4 host and its IPv4 mapped IPv6 counterpart compare equal
+  auto v4 = "192.168.1.1"_ipv4;
+  auto v6 = "::ffff:192.168.1.1"_ipv6;
+  BOOST_REQUIRE(v4 == v6);
+  BOOST_CHECK_EQUAL(pool.index_of(v4), pool.index_of(v6));
+
+  // tasks of each key execute in order
+  const int NUM_KEYS = 16;
+  const int NUM_TASKS = 100;
+  static std::mutex mutex;
+  static std::vector<std::vector<int>> seen;
+  static std::atomic_int done;
+  seen.assign(NUM_KEYS, std::vector<int>());
+  done = 0;
+
+  struct item
+  {
+    int key;
+    int value;
+  };
+  auto exec = [] (void* data_)
+  {
+    auto it = static_cast<item*>(data_);
+    std::unique_lock<std::mutex> l(mutex);
+    seen[it->key].push_back(it->value);
+    ++done;
+  };
+  auto del = [] (void* data_) { delete static_cast<item*>(data_); };
+
+  for (int i = 0; i < NUM_TASKS; ++i)
+    for (int key = 0; key < NUM_KEYS; ++key)
+      pool.get(key)->impl()->enqueue(exec, del, new item { key, i });
+  BOOST_REQUIRE(spin_wait(5000, [] () { return done == NUM_KEYS * NUM_TASKS; }));
+
+  std::unique_lock<std::mutex> l(mutex);
+  for (int key = 0; key < NUM_KEYS; ++key)
+  {
+    BOOST_REQUIRE_EQUAL(NUM_TASKS, seen[key].size());
+    for (int i = 0; i < NUM_TASKS; ++i)
+      BOOST_CHECK_EQUAL(i, seen[key][i]);
+  }
+  l.unlock();
+
+#if defined(GCD_DEQUE) || defined(POSIX_POOL)
+  // the runner with the fewest waiting tasks is selected
+  for (std::size_t i = 0; i < pool.size(); ++i)
+    pool.at(i)->impl()->stop();
+  for (std::size_t i = 0; i < pool.size(); ++i)
+    for (std::size_t n = 0; n < (i == 2 ? 1 : 3); ++n)
+      enqueue_marker(pool.at(i));
+  BOOST_CHECK_EQUAL(1, pool.depth(2));
+  BOOST_CHECK_EQUAL(3, pool.depth(0));
+  BOOST_CHECK_EQUAL(2, pool.least_loaded());
+  for (std::size_t i = 0; i < pool.size(); ++i)
+    pool.at(i)->impl()->start();
+  BOOST_CHECK(spin_wait(1000, [&pool] () { return pool.depth(0) + pool.depth(1) + pool.depth(3) == 0; }));
+  BOOST_CHECK_EQUAL(0, pool.least_loaded());
+#endif
+}
+
+COOL_AUTO_TEST_CASE(T009,
+  *utf::description("urgent runs overtake the waiting runs and keep their urgency on the next runners"))
+{
+#if defined(GCD_DEQUE) || defined(POSIX_POOL)
+  trace.clear();
+
+  auto r1 = std::make_shared<async::runner>();
+  auto t = std::make_shared<step_task>(r1);
+  r1->impl()->stop();
+  t->run(t, 1);
+  t->run(t, 2);
+  t->run(t, 3, async::Urgency::CRITICAL);
+  r1->impl()->start();
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == 3; }));
+  BOOST_CHECK_EQUAL(3, trace[0]);
+  BOOST_CHECK_EQUAL(1, trace[1]);
+  BOOST_CHECK_EQUAL(2, trace[2]);
+
+  // the second step overtakes the marker waiting on its runner
+  trace.clear();
+  auto r2 = std::make_shared<async::runner>();
+  r2->impl()->stop();
+  enqueue_marker(r2);
+  auto stack = make_stack({ r1, r2 });
+  stack->urgency(async::Urgency::HIGH);
+  impl::kickstart(stack);
+  BOOST_REQUIRE(spin_wait(1000, [&r2] () { return r2->impl()->depth() == 2; }));
+  r2->impl()->start();
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == 3; }));
+  BOOST_CHECK_EQUAL(0, trace[0]);
+  BOOST_CHECK_EQUAL(1, trace[1]);
+  BOOST_CHECK_EQUAL(MARKER, trace[2]);
+#endif
+}
+
+COOL_AUTO_TEST_CASE(T010,
+  *utf::description("runs with the earlier deadline overtake the waiting runs"))
+{
+#if defined(GCD_DEQUE) || defined(POSIX_POOL)
+  trace.clear();
+
+  auto r = std::make_shared<async::runner>(async::runner::options().deadline_order(true));
+  auto t = std::make_shared<step_task>(r);
+  auto now = async::runner::clock::now();
+  r->impl()->stop();
+  t->run(t, 1);
+  t->run(t, 2, async::Urgency::NORMAL, now + std::chrono::seconds(20));
+  t->run(t, 3, async::Urgency::NORMAL, now + std::chrono::seconds(10));
+  r->impl()->start();
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == 3; }));
+  BOOST_CHECK_EQUAL(3, trace[0]);
+  BOOST_CHECK_EQUAL(2, trace[1]);
+  BOOST_CHECK_EQUAL(1, trace[2]);
+#endif
+}
+
+COOL_AUTO_TEST_CASE(T011,
+  *utf::description("delayed runs are submitted in the order of their times"))
+{
+  trace.clear();
+
+  auto r = std::make_shared<async::runner>();
+  auto t = std::make_shared<step_task>(r);
+  auto now = async::runner::clock::now();
+  t->run_at(t, now + std::chrono::milliseconds(40), 1);
+  t->run_at(t, now + std::chrono::milliseconds(20), 2);
+  t->run_at(t, now - std::chrono::milliseconds(20), 3);
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == 3; }));
+  BOOST_CHECK(async::runner::clock::now() - now >= std::chrono::milliseconds(40));
+  BOOST_CHECK_EQUAL(3, trace[0]);
+  BOOST_CHECK_EQUAL(2, trace[1]);
+  BOOST_CHECK_EQUAL(1, trace[2]);
+
+  // the pending run of the runner that is gone is deleted when due
+  trace.clear();
+  t->run_at(t, async::runner::clock::now() + std::chrono::milliseconds(20), 4);
+  std::weak_ptr<async::runner> w = r;
+  r.reset();
+  BOOST_REQUIRE(spin_wait(1000, [&w] () { return w.expired(); }));
+  BOOST_CHECK_THROW(t->run_at(t, async::runner::clock::now(), 5), cool::ng::exception::runner_not_available);
+  BOOST_CHECK(spin_wait(1000, [] () { return steps == 0; }));
+  BOOST_CHECK_EQUAL(0, trace_size());
+}
+
+COOL_AUTO_TEST_CASE(T012,
+  *utf::description("statically typed sequence runs its tasks on their runners"))
+{
+  trace.clear();
+
+  using first_task = impl::x_taskinfo<impl::tag::simple, async::runner, int, int>;
+  using last_task  = impl::x_taskinfo<impl::tag::simple, async::runner, void, int>;
+  using sequence   = impl::x_taskinfo<impl::tag::sequential, impl::default_runner_type, void, int>;
+
+  auto r1 = std::make_shared<async::runner>();
+  auto r2 = std::make_shared<async::runner>();
+  auto t1 = std::make_shared<first_task>(r1, [] (const std::shared_ptr<async::runner>&, const int& v_) { return v_ * 2; });
+  auto t2 = std::make_shared<last_task>(r2, [] (const std::shared_ptr<async::runner>&, const int& v_) { record(v_); });
+  auto seq = std::make_shared<sequence>(t1, t2);
+
+  for (int i = 0; i < 10; ++i)
+    seq->run(seq, i);
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == 10; }));
+  for (int i = 0; i < 10; ++i)
+    BOOST_CHECK_EQUAL(i * 2, trace[i]);
+}
+
+COOL_AUTO_TEST_CASE(T013,
+  *utf::description("fused sequence runs its tasks on their runners"))
+{
+  trace.clear();
+
+  using first_task = impl::x_taskinfo<impl::tag::simple, async::runner, int, int>;
+  using last_task  = impl::x_taskinfo<impl::tag::simple, async::runner, void, int>;
+  using sequence   = impl::x_sequence<first_task, first_task, last_task>;
+
+  auto r1 = std::make_shared<async::runner>();
+  auto r2 = std::make_shared<async::runner>();
+  auto double_it = [] (const std::shared_ptr<async::runner>&, const int& v_) { return v_ * 2; };
+  auto t1 = std::make_shared<first_task>(r1, double_it);
+  auto t2 = std::make_shared<first_task>(r1, double_it);
+  auto t3 = std::make_shared<last_task>(r2, [] (const std::shared_ptr<async::runner>&, const int& v_) { record(v_); });
+  auto seq = sequence::create(t1, t2, t3);
+
+  for (int i = 0; i < 10; ++i)
+    seq->run(seq, i);
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == 10; }));
+  for (int i = 0; i < 10; ++i)
+    BOOST_CHECK_EQUAL(i * 4, trace[i]);
+
+#if defined(GCD_DEQUE) || defined(POSIX_POOL)
+  // the urgent run overtakes the waiting runs
+  trace.clear();
+  r1->impl()->stop();
+  seq->run(seq, 1);
+  seq->run(seq, 2);
+  seq->run(seq, 3, async::Urgency::CRITICAL);
+  r1->impl()->start();
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == 3; }));
+  BOOST_CHECK_EQUAL(12, trace[0]);
+  BOOST_CHECK_EQUAL(4, trace[1]);
+  BOOST_CHECK_EQUAL(8, trace[2]);
+#endif
+}
+
+COOL_AUTO_TEST_CASE(T014,
+  *utf::description("delayed run to the full blocking runner does not block the timer"))
+{
+  trace.clear();
+
+  // stop the runner and fill its queue
+  auto bounded = std::make_shared<async::runner>(
+      async::runner::options().capacity(1, async::OverflowPolicy::BLOCK));
+  bounded->impl()->stop();
+  enqueue_marker(bounded);
+
+  auto other = std::make_shared<async::runner>();
+  auto t1 = std::make_shared<step_task>(bounded);
+  auto t2 = std::make_shared<step_task>(other);
+  auto now = async::runner::clock::now();
+  t1->run_at(t1, now, 1);
+  t2->run_at(t2, now + std::chrono::milliseconds(20), 2);
+
+  // the later timer fires and the run that did not fit is dropped
+  bool fired = spin_wait(1000, [] () { return trace_size() == 1; });
+  bounded->impl()->start();
+  BOOST_REQUIRE(fired);
+  BOOST_CHECK_EQUAL(2, trace[0]);
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == 2; }));
+  BOOST_CHECK_EQUAL(MARKER, trace[1]);
+  BOOST_CHECK(spin_wait(1000, [] () { return steps == 0; }));
+  BOOST_CHECK_EQUAL(2, trace_size());
+}
+
+COOL_AUTO_TEST_CASE(T015,
+  *utf::description("many short-lived delayed runs"))
+{
+  trace.clear();
+
+  auto r = std::make_shared<async::runner>();
+  auto t = std::make_shared<step_task>(r);
+  auto now = async::runner::clock::now();
+  for (int i = 0; i < 10000; ++i)
+    t->run_at(t, now + std::chrono::microseconds(i % 100 * 100), i);
+  BOOST_REQUIRE(spin_wait(2000, [] () { return trace_size() == 10000; }));
+  BOOST_CHECK(async::runner::clock::now() - now >= std::chrono::microseconds(9900));
+
+  // the runs due at the same time keep the order of the calls
+  std::vector<int> last;
+  for (auto v : trace)
+    if (v % 100 == 99)
+      last.push_back(v);
+  BOOST_REQUIRE_EQUAL(100, last.size());
+  for (std::size_t i = 1; i < last.size(); ++i)
+    BOOST_CHECK_LT(last[i - 1], last[i]);
+  BOOST_CHECK(spin_wait(1000, [] () { return steps == 0; }));
+}
+
+COOL_AUTO_TEST_CASE(T016,
+  *utf::description("contexts on the same runner yield to the more urgent and the earlier work"))
+{
+#if defined(GCD_DEQUE) || defined(POSIX_POOL)
+  const int NUM_STEPS = 5;
+  auto now = async::runner::clock::now();
+
+  // the critical marker arrives while the first step executes
+  {
+    trace.clear();
+    auto r = std::make_shared<async::runner>();
+    auto stack = make_stack(std::vector<std::shared_ptr<async::runner>>(NUM_STEPS - 1, r));
+    stack->push(new urgent_step(stack, r, NUM_STEPS, async::Urgency::CRITICAL, async::runner::clock::time_point::max()));
+    impl::kickstart(stack);
+    BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == NUM_STEPS + 1; }));
+    BOOST_CHECK_EQUAL(NUM_STEPS, trace[0]);
+    BOOST_CHECK_EQUAL(MARKER, trace[1]);
+    for (int i = 0; i < NUM_STEPS - 1; ++i)
+      BOOST_CHECK_EQUAL(i, trace[i + 2]);
+  }
+
+  // the less urgent marker waits for the entire stack
+  {
+    trace.clear();
+    auto r = std::make_shared<async::runner>();
+    auto stack = make_stack(std::vector<std::shared_ptr<async::runner>>(NUM_STEPS - 1, r));
+    stack->push(new urgent_step(stack, r, NUM_STEPS, async::Urgency::LOW, async::runner::clock::time_point::max()));
+    impl::kickstart(stack);
+    BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == NUM_STEPS + 1; }));
+    BOOST_CHECK_EQUAL(MARKER, trace[NUM_STEPS]);
+  }
+
+  // the marker with the earlier deadline arrives while the first step executes
+  {
+    trace.clear();
+    auto r = std::make_shared<async::runner>(async::runner::options().deadline_order(true));
+    auto stack = make_stack(std::vector<std::shared_ptr<async::runner>>(NUM_STEPS - 1, r));
+    stack->push(new urgent_step(stack, r, NUM_STEPS, async::Urgency::NORMAL, now + std::chrono::seconds(10)));
+    stack->deadline(now + std::chrono::seconds(20));
+    impl::kickstart(stack);
+    BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == NUM_STEPS + 1; }));
+    BOOST_CHECK_EQUAL(NUM_STEPS, trace[0]);
+    BOOST_CHECK_EQUAL(MARKER, trace[1]);
+    for (int i = 0; i < NUM_STEPS - 1; ++i)
+      BOOST_CHECK_EQUAL(i, trace[i + 2]);
+  }
+#endif
+}
+
+COOL_AUTO_TEST_CASE(T017,
+  *utf::description("context stacks the bounded runner did not accept report queue_full"))
+{
+  trace.clear();
+  steps = 0;
+
+  // stop the runner and fill its queue
+  auto bounded = std::make_shared<async::runner>(
+      async::runner::options().capacity(1, async::OverflowPolicy::REJECT));
+  bounded->impl()->stop();
+  enqueue_marker(bounded);
+
+  // the stack moves from the other runner to the full runner
+  auto other = std::make_shared<async::runner>();
+  auto stack = new impl::default_task_stack();
+  stack->push(new guarded_step(stack, bounded, 1));
+  stack->push(new step(stack, other, 0));
+  impl::kickstart(stack);
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == 2; }));
+  BOOST_CHECK_EQUAL(0, trace[0]);
+  BOOST_CHECK_EQUAL(FAILED, trace[1]);
+  BOOST_CHECK(spin_wait(1000, [] () { return steps == 0; }));
+
+  // the delayed run to the full runner
+  trace.clear();
+  stack = new impl::default_task_stack();
+  stack->push(new guarded_step(stack, bounded, 2));
+  impl::kickstart(stack, async::runner::clock::now());
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == 1; }));
+  BOOST_CHECK_EQUAL(FAILED, trace[0]);
+  BOOST_CHECK(spin_wait(1000, [] () { return steps == 0; }));
+
+  bounded->impl()->start();
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == 2; }));
+  BOOST_CHECK_EQUAL(MARKER, trace[1]);
+}
+
+COOL_AUTO_TEST_CASE(T018,
+  *utf::description("factory creates statically typed simple and sequential tasks"))
+{
+  using large_value = std::array<long, 8>;
+
+  trace.clear();
+
+  auto r = std::make_shared<async::runner>();
+  auto first = async::factory::create(r
+    , [] (const std::shared_ptr<async::runner>&, int v_)
+      {
+        large_value ret;
+        ret.fill(v_);
+        return ret;
+      });
+  auto second = async::factory::create(r
+    , [] (const std::shared_ptr<async::runner>&, const large_value& v_)
+      {
+        long ret = 0;
+        for (auto v : v_)
+          ret += v;
+        return static_cast<int>(ret);
+      });
+  auto last = async::factory::create(r
+    , [] (const std::shared_ptr<async::runner>&, int v_) { record(v_); });
+  auto seq = async::factory::sequence(first, second, last);
+
+  // the subtasks pass their results to the next subtask by their own types
+  BOOST_CHECK((std::is_same<
+      impl::x_taskinfo<impl::tag::simple, async::runner, large_value, int>
+    , decltype(first)::impl_type>::value));
+  BOOST_CHECK((std::is_same<
+      impl::x_fused_taskinfo<impl::x_link<int>
+        , decltype(first)::impl_type, decltype(second)::impl_type, decltype(last)::impl_type>
+    , decltype(seq)::impl_type>::value));
+  BOOST_CHECK((std::is_same<void, decltype(seq)::result_type>::value));
+  BOOST_CHECK(!!seq);
+  BOOST_CHECK(!decltype(seq)());
+
+  seq.run(2);
+  seq.run(3, async::Urgency::HIGH);
+  seq.run(4, async::runner::clock::now() + std::chrono::seconds(10));
+  last.run(MARKER);
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == 4; }));
+  std::sort(trace.begin(), trace.end());
+  BOOST_CHECK_EQUAL(MARKER, trace[0]);
+  BOOST_CHECK_EQUAL(16, trace[1]);
+  BOOST_CHECK_EQUAL(24, trace[2]);
+  BOOST_CHECK_EQUAL(32, trace[3]);
+
+  // the sequence without input
+  trace.clear();
+  auto start = async::factory::create(r, [] (const std::shared_ptr<async::runner>&) { return 5; });
+  async::factory::sequence(start, last).run();
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == 1; }));
+  BOOST_CHECK_EQUAL(5, trace[0]);
+
+  // the sequence with the compound subtask is not fused
+  trace.clear();
+  auto nested = async::factory::sequence(async::factory::sequence(first, second), last);
+  BOOST_CHECK((std::is_same<
+      impl::x_taskinfo<impl::tag::sequential, impl::default_runner_type, void, int>
+    , decltype(nested)::impl_type>::value));
+  nested.run(1);
+  BOOST_REQUIRE(spin_wait(1000, [] () { return trace_size() == 1; }));
+  BOOST_CHECK_EQUAL(8, trace[0]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()